@@ -1,5 +1,7 @@
 #!/usr/bin/env python3
 from http import server # Python 3
+import os
+import re
 
 class MyHTTPRequestHandler(server.SimpleHTTPRequestHandler):
         def end_headers(self):
@@ -8,9 +10,60 @@ class MyHTTPRequestHandler(server.SimpleHTTPRequestHandler):
 
         def send_my_headers(self):
                 self.send_header("Access-Control-Allow-Origin", "*")
+                self.send_header("Access-Control-Expose-Headers", "Content-Range")
                 self.send_header("Cross-Origin-Embedder-Policy", "require-corp")
                 self.send_header("Cross-Origin-Opener-Policy", "same-origin")
+                self.send_header("Accept-Ranges", "bytes")
+
+        # single Range requests (bytes=start-end, start-, or -suffix), used by twr_pread()
+        def send_head(self):
+                m=re.fullmatch(r"bytes=(\d*)-(\d*)", self.headers.get("Range", "").strip())
+                path=self.translate_path(self.path)
+                if not m or m[1]+m[2]=="" or not os.path.isfile(path):
+                        return server.SimpleHTTPRequestHandler.send_head(self)
+
+                try:
+                        f=open(path, "rb")
+                except OSError:
+                        self.send_error(404, "File not found")
+                        return None
+
+                size=os.fstat(f.fileno()).st_size
+                if m[1]=="":
+                        start=max(size-int(m[2]), 0)
+                        end=size-1
+                else:
+                        start=int(m[1])
+                        end=min(int(m[2]), size-1) if m[2] else size-1
+
+                if start>end:
+                        f.close()
+                        self.send_response(416)
+                        self.send_header("Content-Range", "bytes */%d" % size)
+                        self.send_header("Content-Length", "0")
+                        self.end_headers()
+                        return None
+
+                self.send_response(206)
+                self.send_header("Content-Type", self.guess_type(path))
+                self.send_header("Content-Range", "bytes %d-%d/%d" % (start, end, size))
+                self.send_header("Content-Length", str(end-start+1))
+                self.end_headers()
+                f.seek(start)
+                self.range_left=end-start+1
+                return f
+
+        def copyfile(self, source, outputfile):
+                left=getattr(self, "range_left", None)
+                if left is None:
+                        return server.SimpleHTTPRequestHandler.copyfile(self, source, outputfile)
+                self.range_left=None
+                while left>0:
+                        buf=source.read(min(left, 64*1024))
+                        if not buf:
+                                break
+                        outputfile.write(buf)
+                        left-=len(buf)
 
 if __name__ == '__main__':
         server.test(HandlerClass=MyHTTPRequestHandler)
-        
\ No newline at end of file
@@ -8,10 +8,13 @@
 #include <typeinfo>
 #include <string_view>
 #include <cuchar> // For char16_t and char32_t conversions
+#include <cstring>
+#include "twr-format.h"
 
 bool testUnicodeSupport(void);
 bool testRttiSupported(void);
 bool testDynamicCast(void);
+bool testTwrFormat(void);
 void dotest(void);
 
 
@@ -146,6 +149,15 @@ void dotest() {
 
 	//////////////////////////////////////////////
 
+	if (testTwrFormat())
+		twr::format<"twr::format %s, %d tests\n">("Success", 4);
+	else {
+		printf("ERROR! %d\n",__LINE__);
+		abort();
+	}
+
+	//////////////////////////////////////////////
+
 	std::cout << "Normal End\n";
 
 }
@@ -232,5 +244,25 @@ bool testDynamicCast() {
     return r;
 }
 
+// twr::format should match snprintf for the same format and arguments
+bool testTwrFormat() {
+	char a[100], b[100];
+	int ka, kb;
+
+	ka=twr::format_to<"%s=%5d|%-4x|%08.3f|%c|%%">(a, sizeof(a), "val", -42, 255u, -3.14159, 'z');
+	kb=snprintf(b, sizeof(b), "%s=%5d|%-4x|%08.3f|%c|%%", "val", -42, 255u, -3.14159, 'z');
+	if (ka!=kb || strcmp(a, b)!=0) return false;
+
+	ka=twr::format_to<"%lld %llu %#llx %p">(a, sizeof(a), INT64_MIN, UINT64_MAX, 0xABCull, (void*)a);
+	kb=snprintf(b, sizeof(b), "%lld %llu %#llx %p", INT64_MIN, UINT64_MAX, 0xABCull, (void*)a);
+	if (ka!=kb || strcmp(a, b)!=0) return false;
 
+	// std::string, and truncation
+	ka=twr::format_to<"%s %.3s">(a, 6, std::string("hello"), "world");
+	if (ka!=9 || strcmp(a, "hello")!=0) return false;
 
+	ka=twr::format_to<"no conversions">(a, sizeof(a));
+	if (ka!=14 || strcmp(a, "no conversions")!=0) return false;
+
+	return true;
+}
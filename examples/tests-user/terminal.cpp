@@ -6,6 +6,7 @@
 twrTerminal::twrTerminal() {
     m_iow=(struct IoConsoleWindow*)twr_get_stdio_con();
     assert(m_iow->con.header.type&IO_TYPE_WINDOW);
+    io_set_line_mode(&m_iow->con, true);  // command lines are edited (and recalled with up arrow) by the canvas
 	 //setlocale(LC_ALL, "");  // turn on UTF-8.  
 }
 
@@ -1,10 +1,12 @@
 #include <iostream>
 #include <map>
 #include <stdio.h>
+#include <stdlib.h>
 #include <locale.h>
 #include "parsecmd.h"
 #include "terminal.h"
 #include "twr-crt.h"
+#include "twr-draw2d.h"
 
 typedef int (*FunctionPointer)(parseCommand);
 
@@ -18,6 +20,9 @@ static int lang(parseCommand);
 static int memstats(parseCommand);
 static int unittests(parseCommand);
 static int cls(parseCommand);
+static int pread(parseCommand);
+static int drawbench(parseCommand);
+static int stylecache(parseCommand);
 
 
 std::map<std::string, FunctionPointer> cmdList = {
@@ -32,6 +37,9 @@ std::map<std::string, FunctionPointer> cmdList = {
 	{"memstats", memstats},
 	{"unittests", unittests},
 	{"cls", cls},
+	{"pread", pread},
+	{"drawbench", drawbench},
+	{"stylecache", stylecache},
 };
 
 twrTerminal myTerm;
@@ -90,6 +98,9 @@ static int unittests(parseCommand) {
 	printf("twr_dtoa_unit_test: %s\n", twr_dtoa_unit_test()?"success":"FAIL");
 	printf("string_unit_test: %s\n", string_unit_test()?"success":"FAIL");
 	printf("printf_unit_test: %s\n", printf_unit_test()?"success":"FAIL");
+	printf("sscanf_unit_test: %s\n", sscanf_unit_test()?"success":"FAIL");
+	printf("file_unit_test: %s\n", file_unit_test()?"success":"FAIL");
+	// printf("zlib_unit_test: %s\n", zlib_unit_test()?"success":"FAIL");  needs more memory than this module has -- see example/tests
 	printf("mbstring_unit_test: %s\n", mbstring_unit_test()?"success":"FAIL");
 	
 	printf("test run complete\n");
@@ -176,5 +187,146 @@ static int cls(parseCommand) {
 	return 1;
 }
 
+// pread <url> -- reads a file from a server that supports Range requests (like examples/server.py) with twr_pread.
+// All of it sequentially (which uses prefetch), then 200 4K blocks at random
+static int pread(parseCommand myCmd) {
+	if (myCmd.m_options.size()!=1) {
+		std::cout << "usage: pread <url>\n";
+		return 0;
+	}
+
+	const int h=twr_range_open(myCmd.m_options[0].c_str(), 0, 0, -1);
+	if (h<0) return 0;
+	const int64_t size=twr_range_size(h);
+
+	static unsigned char buf[16384];
+	uint32_t sum=0;
+	int64_t offset=0;
+	uint64_t start=twr_epoch_timems();
+	for (;;) {
+		const long n=twr_pread(h, offset, sizeof(buf), buf);
+		if (n<=0) break;
+		for (long i=0; i<n; i++) sum=sum*31+buf[i];
+		offset+=n;
+	}
+	const uint64_t seqms=twr_epoch_timems()-start;
+
+	start=twr_epoch_timems();
+	for (int i=0; i<200 && size>0; i++)
+		if (twr_pread(h, (int64_t)(((uint64_t)rand()<<16 ^ rand()) % size), 4096, buf)<0) offset=-1;
+	const uint64_t randms=twr_epoch_timems()-start;
+
+	twr_range_close(h);
 
+	printf("size %lld, read %lld, checksum %08x\n", (long long)size, (long long)offset, (unsigned)sum);
+	printf("sequential: %llu ms (%.1f MB/s), 200 random 4K reads: %llu ms\n", (unsigned long long)seqms, seqms ? offset/1000.0/seqms : 0.0, (unsigned long long)randms);
 
+	return offset==size;
+}
+
+////////////////////////////////////////////////////
+
+// the window console's per cell drawing, before text runs were coalesced: a background rect, and a fillcodepoint
+// for each cell that isn't a space
+static void draw_cells(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int start, int end) {
+	for (int i=start; i<=end; i++) {
+		const int x=(i%iow->display.width)*iow->display.my_cx;
+		const int y=(i/iow->display.width)*iow->display.my_cy;
+		const struct IoCell* cell=iow->display.cells+i;
+		d2d_setfillstylergba(ds, iow->display.palette[cell->back]);
+		d2d_fillrect(ds, x, y, iow->display.my_cx, iow->display.my_cy);
+		if (cell->c!=32) {
+			d2d_setfillstylergba(ds, iow->display.palette[cell->fore]);
+			d2d_fillcodepoint(ds, cell->c, x, y);
+		}
+	}
+}
+
+// draw a full screen of colored text, a row at a time, frames times.  Return the instructions per frame
+static long draw_frames(struct IoConsoleWindow* iow, bool coalesce, int frames) {
+	struct d2d_draw_seq* ds=d2d_start_draw_sequence(1<<30);	// flush each row here, not when the count is reached
+	long ins=0;
+
+	iow->display.ds=ds;
+	iow->display.nest_level=1;
+	for (int f=0; f<frames; f++) {
+		for (int row=0; row<iow->display.height; row++) {
+			const int start=row*iow->display.width;
+			if (coalesce)
+				iow->display.io_draw_range(iow, start, start+iow->display.width-1);
+			else
+				draw_cells(iow, ds, start, start+iow->display.width-1);
+			ins+=ds->ins_count;
+			d2d_flush(ds);
+		}
+	}
+	d2d_end_draw_sequence(ds);
+
+	return ins/frames;
+}
+
+static int drawbench(parseCommand) {
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)twr_get_stdio_con();
+	// four foregrounds, a highlight background, and the terminal's background
+	unsigned long palette[]={0xFFFFFFFF, 0x00FF00FF, 0xFFFF00FF, 0x00FFFFFF, 0x0000FFFF, iow->display.back_color};
+	const int dims[][2]={{64, 16}, {200, 60}};
+	const int frames=10;
+
+	for (auto& d : dims) {
+		struct IoConsoleWindow tmp=*iow;
+		tmp.display.width=d[0];
+		tmp.display.height=d[1];
+		tmp.display.size=d[0]*d[1];
+		tmp.display.palette=palette;
+		tmp.display.cells=(struct IoCell*)malloc(tmp.display.size*sizeof(struct IoCell));
+		if (!tmp.display.cells) {
+			std::cout << "out of memory\n";
+			return 0;
+		}
+
+		// words of 1 to 8 letters, each in one of the palette colors, on the default background (with an occasional
+		// highlighted word)
+		srand(1);
+		int color=0;
+		for (int i=0; i<tmp.display.size; i++) {
+			if (i==0 || tmp.display.cells[i-1].c==32) color=rand();
+			const bool space=(rand()%6==0);
+			tmp.display.cells[i].c=space ? 32 : 'a'+rand()%26;
+			tmp.display.cells[i].fore=color%4;
+			tmp.display.cells[i].back=(color%16==0) ? 4 : 5;
+		}
+
+		for (int coalesce=0; coalesce<2; coalesce++) {
+			const uint64_t start=twr_epoch_timems();
+			const long ins=draw_frames(&tmp, coalesce, frames);
+			const uint64_t ms=twr_epoch_timems()-start;
+			printf("%dx%d %s: %ld instructions/frame, %.1f ms/frame\n", d[0], d[1], coalesce?"text runs":"per cell", ins, (double)ms/frames);
+		}
+
+		free(tmp.display.cells);
+	}
+
+	io_draw_range(iow, 0, iow->display.size-1);	// the benchmark drew over the terminal
+
+	return 1;
+}
+
+// the console keeps its draw sequence from one write to the next.  Draw on its canvas in between, with another
+// fill color, and check that the console sets its colors again (the second line should look like the first)
+static int stylecache(parseCommand) {
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)twr_get_stdio_con();
+
+	printf("before another draw sequence\n");
+
+	struct d2d_draw_seq* ds=d2d_start_draw_sequence_on(iow->con.header.handle, 100);
+	d2d_setfillstylergba(ds, 0xFF0000FF);
+	d2d_fillrect(ds, 0, 0, 1, 1);
+	d2d_end_draw_sequence(ds);
+
+	const bool cleared=!iow->display.ds || !iow->display.ds->last_fillstyle_color_valid;
+	printf("after another draw sequence\n");
+
+	io_draw_range(iow, 0, 0);	// cell 0 is back in the console's colors
+
+	return cleared;
+}
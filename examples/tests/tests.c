@@ -1,12 +1,33 @@
 #include <math.h>
 #include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <twr-crt.h>
+#include <twr-zlib.h>
+#include <twr-bigint.h>
 
 #ifndef UNUSED
 #define UNUSED(x) (void)(x)
 #endif
 
 
+// __int128 math is done by compiler-rt (__multi3, __udivti3, __divti3, etc)
+static int int128_test() {
+	volatile unsigned __int128 a=((unsigned __int128)0x0123456789ABCDEFULL<<64) | 0xFEDCBA9876543210ULL;
+	volatile unsigned __int128 b=1000000007;
+	volatile __int128 c=-(__int128)a;
+
+	if (a/b != (((unsigned __int128)0x4E2FFF8ULL<<64) | 0xA480A8F47507E0E0ULL)) return 0;
+	if (a%b != 619465712) return 0;
+	if (((a>>40)*b)/b != (a>>40) || ((a>>40)*b)%b != 0) return 0;
+	if (c/(__int128)b != -(__int128)(a/b) || c%(__int128)b != -(__int128)(a%b)) return 0;
+	if ((c>>100) != -(__int128)((a>>100)+1)) return 0;
+	if (a/a != 1 || b/a != 0 || b%a != b) return 0;
+
+	return 1;
+}
+
 int tests() {
 
 	printf("starting unit tests of twr-wasm...\n");
@@ -22,7 +43,12 @@ int tests() {
 	printf("twr_dtoa_unit_test: %s\n", twr_dtoa_unit_test()?"success":"FAIL");
 	printf("string_unit_test: %s\n", string_unit_test()?"success":"FAIL");
 	printf("printf_unit_test: %s\n", printf_unit_test()?"success":"FAIL");
+	printf("sscanf_unit_test: %s\n", sscanf_unit_test()?"success":"FAIL");
+	printf("file_unit_test: %s\n", file_unit_test()?"success":"FAIL");
+	printf("zlib_unit_test: %s\n", zlib_unit_test()?"success":"FAIL");
 	printf("mbstring_unit_test: %s\n", mbstring_unit_test()?"success":"FAIL");
+	printf("int128_test: %s\n", int128_test()?"success":"FAIL");
+	printf("twr_big_run_unit_tests: %s\n", twr_big_run_unit_tests()?"success":"FAIL");
 	
 	printf("test run complete\n");
 	return 0;
@@ -37,3 +63,188 @@ double sin_test() {
 
     return sum;
 }
+
+// printf throughput.  snprintf uses the span callback, so each literal run and converted value is one memcpy
+int printf_span_test() {
+	char buffer[128];
+	int total=0;
+
+	for (int i=0; i<200000; i++)
+		total+=snprintf(buffer, sizeof(buffer), "line %d: %s=%x, %5d (%c)\n", i, "value", i*7, i&1023, 'a'+(i&15));
+
+	return total;
+}
+
+struct byte_test_data {
+	char* buffer;
+	int pos;
+};
+
+static void byte_test_callback(void* datain, unsigned char c) {
+	struct byte_test_data* data=datain;
+	if (data->pos < 127) data->buffer[data->pos]=c;
+	data->pos++;
+}
+
+static int byte_test_printf(char* buffer, const char* format, ...) {
+	struct byte_test_data data={buffer, 0};
+	va_list vlist;
+	va_start(vlist, format);
+	twr_vcbprintf(byte_test_callback, &data, format, vlist);
+	va_end(vlist);
+	return data.pos;
+}
+
+// same output as printf_span_test, but using the one byte at a time callback (which is how snprintf used to work)
+int printf_byte_test() {
+	char buffer[128];
+	int total=0;
+
+	for (int i=0; i<200000; i++)
+		total+=byte_test_printf(buffer, "line %d: %s=%x, %5d (%c)\n", i, "value", i*7, i&1023, 'a'+(i&15));
+
+	return total;
+}
+
+// numeric text for the sscanf tests: lines of "index count value value"
+static char scanf_text[16384];
+static int scanf_text_len;
+
+static void make_scanf_text() {
+	if (scanf_text_len) return;
+	for (int i=0; scanf_text_len < (int)sizeof(scanf_text)-64; i++)
+		scanf_text_len+=snprintf(scanf_text+scanf_text_len, sizeof(scanf_text)-scanf_text_len, "%d %u %.6f %g\n", i, (i*2654435761U)>>8, i*0.37-500.0, i*1.5e-3);
+}
+
+// parses 4MB of numeric text with sscanf.  returns the number of bytes parsed
+int sscanf_test() {
+	int total=0;
+	double sum=0;
+
+	make_scanf_text();
+	while (total < 4*1024*1024) {
+		const char* p=scanf_text;
+		int index, n;
+		unsigned count;
+		double a, b;
+		while (sscanf(p, "%d %u %lf %lf%n", &index, &count, &a, &b, &n)==4) {
+			sum+=index+count+a+b;
+			p+=n;
+		}
+		total+=p-scanf_text;
+	}
+
+	return sum!=0 ? total : 0;
+}
+
+// same as sscanf_test, using strtol, strtoul and strtod
+int strtod_test() {
+	int total=0;
+	double sum=0;
+
+	make_scanf_text();
+	while (total < 4*1024*1024) {
+		const char* p=scanf_text;
+		const char* const end=scanf_text+scanf_text_len;
+		char* next;
+		while (p<end) {
+			const long index=strtol(p, &next, 10);
+			const unsigned long count=strtoul(next, &next, 10);
+			const double a=strtod(next, &next);
+			const double b=strtod(next, &next);
+			sum+=index+count+a+b;
+			p=next;
+		}
+		total+=p-scanf_text;
+	}
+
+	return sum!=0 ? total : 0;
+}
+
+// fetchStream() callback (see index.html): adds up newline separated numbers into *sum as the text downloads.
+// Only complete lines are used, so a number split between two chunks is passed again with the next one.
+int stream_sum_chunk(const char* data, int len, int final, double* sum) {
+	const char* end=data+len;
+	if (!final) {
+		while (end>data && end[-1]!='\n') end--;
+	}
+
+	const char* p=data;
+	while (p<end) {
+		double v;
+		const struct twr_from_chars_result r=twr_from_chars_d(p, end, &v);
+		if (r.ptr!=p) {
+			*sum+=v;
+			p=r.ptr;
+		}
+		else {
+			p++;	// newline
+		}
+	}
+
+	return end-data;
+}
+
+// fetchStream() callbacks for the inflate benchmark (see index.html).  Both add the decompressed data to the crc32 in *crc:
+// inflate_chunk decompresses gzip itself, and copy_chunk is passed the output of the browser's DecompressionStream
+static struct twr_inflate* bench_inflate;
+
+int inflate_chunk(const char* data, int len, int final, uint32_t* crc) {
+	static char out[16384];
+	size_t in=0;
+
+	if (bench_inflate==NULL) bench_inflate=twr_inflate_new(TWR_Z_GZIP);
+	if (bench_inflate==NULL) return -1;
+
+	for (;;) {
+		size_t used, made;
+		const int rv=twr_inflate(bench_inflate, data+in, len-in, &used, out, sizeof(out), &made);
+		in+=used;
+		*crc=twr_crc32(*crc, out, made);
+
+		if (rv!=TWR_Z_OK || final) {
+			if (rv==TWR_Z_OK && (used || made)) continue;
+			twr_inflate_free(bench_inflate);
+			bench_inflate=NULL;
+			return rv==TWR_Z_DATA_ERROR ? -1 : (int)in;
+		}
+		if (used==0 && made==0) return in;
+	}
+}
+
+int copy_chunk(const char* data, int len, int final, uint32_t* crc) {
+	(void)final;
+	*crc=twr_crc32(*crc, data, len);
+	return len;
+}
+
+// 64x64->128 multiply using unsigned __int128, which calls compiler-rt __multi3
+uint64_t multi3_test() {
+    uint64_t x=0x9E3779B97F4A7C15ULL, sum=0;
+
+    for (int i=0; i<2000000; i++) {
+        const unsigned __int128 p=(unsigned __int128)x*(x^0xD1B54A32D192ED03ULL);
+        sum+=(uint64_t)(p>>64) ^ (uint64_t)p;
+        x=x*6364136223846793005ULL+1442695040888963407ULL;
+    }
+
+    return sum;
+}
+
+// same, specialized to four 32x32->64 i64.mul
+uint64_t mul64x64_test() {
+    uint64_t x=0x9E3779B97F4A7C15ULL, sum=0;
+
+    for (int i=0; i<2000000; i++) {
+        const uint64_t y=x^0xD1B54A32D192ED03ULL;
+        const uint64_t a0=(uint32_t)x, a1=x>>32, b0=(uint32_t)y, b1=y>>32;
+        const uint64_t p00=a0*b0, p01=a0*b1, p10=a1*b0, p11=a1*b1;
+        const uint64_t mid=(p00>>32) + (uint32_t)p01 + (uint32_t)p10;
+        const uint64_t lo=(mid<<32) | (uint32_t)p00;
+        const uint64_t hi=p11 + (mid>>32) + (p01>>32) + (p10>>32);
+        sum+=hi ^ lo;
+        x=x*6364136223846793005ULL+1442695040888963407ULL;
+    }
+
+    return sum;
+}
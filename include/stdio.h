@@ -33,6 +33,15 @@ int putchar(int c);
 
 typedef struct IoConsole FILE; 
 #define EOF (-1)  
+
+/* setvbuf modes.  by default stdout is line buffered (unless it is a window console, which is never buffered), */
+/* and stderr is unbuffered.  Output is also flushed when input is read, and when a callC() returns to JavaScript */
+#define _IOFBF 0
+#define _IOLBF 1
+#define _IONBF 2
+#define BUFSIZ 512
+int setvbuf(FILE* stream, char* buf, int mode, size_t size);
+void setbuf(FILE* stream, char* buf);
 int vfprintf(FILE *stream, const char *format, va_list vlist);
 int fprintf(FILE *stream, const char* format, ...);
 size_t fwrite(const void* buffer, size_t size, size_t count, FILE* stream);
@@ -48,10 +57,22 @@ int getc(FILE *stream);
 int vsscanf(const char *buffer, const char *format, va_list arglist);
 int sscanf( const char *buffer, const char *format, ... );
 int ungetc(int ch, FILE *stream);
+int fputs(const char* str, FILE* stream);
+char* fgets(char* str, int count, FILE* stream);
 
-
-// remove not implemented; here to get libc++ to compile
-static inline int remove( const char* pathname ) {assert(0);return -1;} 
+/* files.  fopen() uses the in-memory file system, or a backend added with twr_fs_mount() (see twr-crt.h) */
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+#define FILENAME_MAX 256
+FILE* fopen(const char* filename, const char* mode);
+int fclose(FILE* stream);
+size_t fread(void* buffer, size_t size, size_t count, FILE* stream);
+int fseek(FILE* stream, long offset, int origin);
+long ftell(FILE* stream);
+void rewind(FILE* stream);
+void clearerr(FILE* stream);
+int remove(const char* pathname);
 
 #ifdef __cplusplus
 }
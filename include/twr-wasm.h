@@ -3,6 +3,8 @@
 
 // twr_wasm_ functions are exported from C to Javascript
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -11,6 +13,10 @@ extern "C" {
 /* not generally used directly by applications -- use TS classes twrWasmModule and twrWasmModuleAsync */
 __attribute__((export_name("twr_wasm_init"))) void twr_wasm_init(int pf, unsigned long mem_size); 
 __attribute__((export_name("twr_wasm_print_mem_debug_stats"))) void twr_wasm_print_mem_debug_stats(void);
+__attribute__((export_name("twr_wasm_flush"))) void twr_wasm_flush(void);
+__attribute__((export_name("twr_wasm_memfs_add"))) int twr_wasm_memfs_add(const char* path, char* data, size_t len);
+__attribute__((export_name("twr_wasm_memfs_add_inflate"))) int twr_wasm_memfs_add_inflate(const char* path, char* data, size_t len);
+__attribute__((export_name("twr_wasm_alloc_asset"))) void* twr_wasm_alloc_asset(size_t size);
 
 #ifdef __cplusplus
 }
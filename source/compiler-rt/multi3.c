@@ -20,6 +20,12 @@ static ti_int __mulddi3(du_int a, du_int b) {
   twords r;
   const int bits_in_dword_2 = (int)(sizeof(di_int) * CHAR_BIT) / 2;
   const du_int lower_mask = (du_int)~0 >> bits_in_dword_2;
+  if (((a | b) >> bits_in_dword_2) == 0) {
+    // both fit in 32 bits: a single i64.mul
+    r.s.low = a * b;
+    r.s.high = 0;
+    return r.all;
+  }
   r.s.low = (a & lower_mask) * (b & lower_mask);
   du_int t = r.s.low >> bits_in_dword_2;
   r.s.low &= lower_mask;
@@ -44,7 +50,9 @@ COMPILER_RT_ABI ti_int __multi3(ti_int a, ti_int b) {
   y.all = b;
   twords r;
   r.all = __mulddi3(x.s.low, y.s.low);
-  r.s.high += x.s.high * y.s.low + x.s.low * y.s.high;
+  // skip the cross products for the common widening 64x64->128 case
+  if (x.s.high | y.s.high)
+    r.s.high += x.s.high * y.s.low + x.s.low * y.s.high;
   return r.all;
 }
 
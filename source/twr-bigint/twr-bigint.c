@@ -0,0 +1,824 @@
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include "twr-bigint.h"
+
+// unsigned bigint with 32 bit limbs.
+// Multiplication is schoolbook for small operands, Karatsuba for large ones.
+// Division is Knuth's algorithm D (TAOCP vol 2, 4.3.1).
+// Conversion to and from base 10 is divide-and-conquer for large values, using cached powers 10^(9*2^k).
+
+#define KARATSUBA_CUTOFF 32		// in words.  Below this, schoolbook is faster
+#define DC_CUTOFF 30					// in words.  Below this, base 10 conversion is done 9 digits at a time
+#define DC_MAXLEVEL 9				// 10^(9*2^9) is bigger than any twr_bigint
+#define LIMB_BITS 32
+
+/*****************************************************/
+/* limb (word array) level functions                 */
+/*****************************************************/
+
+static inline int limbs_norm(const uint32_t* w, int n) {
+	while (n>0 && w[n-1]==0) n--;
+	return n;
+}
+
+static inline void big_setlen(struct twr_bigint* big, int n) {
+	n=limbs_norm(big->word, n);
+	big->len=n;
+	if (n==0) big->word[0]=0;
+}
+
+// r[0..rn) += x[0..xn), xn<=rn.  returns carry out of r[rn-1]
+static uint32_t limbs_add_to(uint32_t* r, int rn, const uint32_t* x, int xn) {
+	uint64_t carry=0;
+	int i;
+	for (i=0; i<xn; i++) {
+		carry+=(uint64_t)r[i]+x[i];
+		r[i]=(uint32_t)carry;
+		carry>>=LIMB_BITS;
+	}
+	for (; carry && i<rn; i++) {
+		carry+=r[i];
+		r[i]=(uint32_t)carry;
+		carry>>=LIMB_BITS;
+	}
+	return (uint32_t)carry;
+}
+
+// r[0..rn) -= x[0..xn), xn<=rn.  returns borrow
+static uint32_t limbs_sub_from(uint32_t* r, int rn, const uint32_t* x, int xn) {
+	uint32_t borrow=0;
+	int i;
+	for (i=0; i<xn; i++) {
+		const uint64_t t=(uint64_t)r[i]-x[i]-borrow;
+		r[i]=(uint32_t)t;
+		borrow=(uint32_t)(t>>63);
+	}
+	for (; borrow && i<rn; i++) {
+		borrow=(r[i]==0);
+		r[i]--;
+	}
+	return borrow;
+}
+
+// r[0..an+bn) = a*b.  r must not overlap a or b
+static void limbs_mul_school(uint32_t* r, const uint32_t* a, int an, const uint32_t* b, int bn) {
+	memset(r, 0, (an+bn)*sizeof(uint32_t));
+	for (int i=0; i<bn; i++) {
+		const uint64_t bi=b[i];
+		uint64_t carry=0;
+		if (bi==0) continue;
+		for (int j=0; j<an; j++) {
+			carry+=a[j]*bi+r[i+j];
+			r[i+j]=(uint32_t)carry;
+			carry>>=LIMB_BITS;
+		}
+		r[i+an]=(uint32_t)carry;
+	}
+}
+
+static void limbs_mul(uint32_t* r, const uint32_t* a, int an, const uint32_t* b, int bn);
+
+// r[0..2n) = a*b, where both a and b are n words
+static void limbs_mul_karatsuba(uint32_t* r, const uint32_t* a, const uint32_t* b, int n) {
+	if (n<KARATSUBA_CUTOFF) {
+		limbs_mul_school(r, a, n, b, n);
+		return;
+	}
+
+	// a=a1*B^m+a0, b=b1*B^m+b0
+	// a*b = z2*B^2m + z1*B^m + z0, where z1=(a0+a1)(b0+b1)-z0-z2
+	const int m=n/2;
+	const int h=n-m;
+	uint32_t sa[h+1], sb[h+1], z1[2*h+2];
+
+	limbs_mul_karatsuba(r, a, b, m);						// z0 -> r[0..2m)
+	limbs_mul_karatsuba(r+2*m, a+m, b+m, h);			// z2 -> r[2m..2n)
+
+	memcpy(sa, a+m, h*sizeof(uint32_t));
+	sa[h]=limbs_add_to(sa, h, a, m);
+	memcpy(sb, b+m, h*sizeof(uint32_t));
+	sb[h]=limbs_add_to(sb, h, b, m);
+
+	limbs_mul_karatsuba(z1, sa, sb, h+1);
+	limbs_sub_from(z1, 2*h+2, r, 2*m);
+	limbs_sub_from(z1, 2*h+2, r+2*m, 2*h);
+
+	limbs_add_to(r+m, 2*n-m, z1, limbs_norm(z1, 2*h+2));
+}
+
+// r[0..an+bn) = a*b.  r must not overlap a or b
+static void limbs_mul(uint32_t* r, const uint32_t* a, int an, const uint32_t* b, int bn) {
+	if (an<bn) {
+		const uint32_t* t=a; a=b; b=t;
+		int tn=an; an=bn; bn=tn;
+	}
+
+	if (bn<KARATSUBA_CUTOFF) {
+		limbs_mul_school(r, a, an, b, bn);
+	}
+	else if (an==bn) {
+		limbs_mul_karatsuba(r, a, b, bn);
+	}
+	else {  // unbalanced -- multiply bn sized pieces of a by b
+		uint32_t t[2*bn];
+		memset(r, 0, (an+bn)*sizeof(uint32_t));
+		for (int i=0; i<an; i+=bn) {
+			const int chunk=(an-i)<bn?(an-i):bn;
+			limbs_mul(t, a+i, chunk, b, bn);
+			limbs_add_to(r+i, an+bn-i, t, chunk+bn);
+		}
+	}
+}
+
+// q=num/den, returns remainder.  q may be num
+static uint32_t limbs_divmod1(uint32_t* q, const uint32_t* num, int n, uint32_t den) {
+	uint64_t rem=0;
+	for (int i=n-1; i>=0; i--) {
+		const uint64_t cur=(rem<<LIMB_BITS)|num[i];
+		if (q) q[i]=(uint32_t)(cur/den);
+		rem=cur%den;
+	}
+	return (uint32_t)rem;
+}
+
+// Knuth algorithm D. m>=n>=2, v[n-1]!=0.  q is m-n+1 words, r is n words.
+static void limbs_divmod_knuth(uint32_t* q, uint32_t* r, const uint32_t* u, int m, const uint32_t* v, int n) {
+	const uint64_t b=(uint64_t)1<<LIMB_BITS;
+	uint32_t un[m+1], vn[n];
+	const int s=__builtin_clz(v[n-1]);
+
+	// normalize so that the top bit of the divisor is set
+	for (int i=n-1; i>0; i--)
+		vn[i]=(v[i]<<s) | (s?(uint32_t)((uint64_t)v[i-1]>>(LIMB_BITS-s)):0);
+	vn[0]=v[0]<<s;
+	un[m]=s?(uint32_t)((uint64_t)u[m-1]>>(LIMB_BITS-s)):0;
+	for (int i=m-1; i>0; i--)
+		un[i]=(u[i]<<s) | (s?(uint32_t)((uint64_t)u[i-1]>>(LIMB_BITS-s)):0);
+	un[0]=u[0]<<s;
+
+	for (int j=m-n; j>=0; j--) {
+		// estimate the quotient digit, which will be at most 2 too big
+		const uint64_t num2=((uint64_t)un[j+n]<<LIMB_BITS) | un[j+n-1];
+		uint64_t qhat=num2/vn[n-1];
+		uint64_t rhat=num2%vn[n-1];
+		while (qhat>=b || qhat*vn[n-2] > ((rhat<<LIMB_BITS) | un[j+n-2])) {
+			qhat--;
+			rhat+=vn[n-1];
+			if (rhat>=b) break;
+		}
+
+		// multiply and subtract
+		int64_t k=0, t;
+		for (int i=0; i<n; i++) {
+			const uint64_t p=qhat*vn[i];
+			t=(int64_t)un[i+j]-k-(int64_t)(p&0xFFFFFFFF);
+			un[i+j]=(uint32_t)t;
+			k=(int64_t)(p>>LIMB_BITS)-(t>>LIMB_BITS);
+		}
+		t=(int64_t)un[j+n]-k;
+		un[j+n]=(uint32_t)t;
+
+		if (t<0) {  // subtracted too much, add back
+			qhat--;
+			uint64_t c=0;
+			for (int i=0; i<n; i++) {
+				c+=(uint64_t)un[i+j]+vn[i];
+				un[i+j]=(uint32_t)c;
+				c>>=LIMB_BITS;
+			}
+			un[j+n]+=(uint32_t)c;
+		}
+		if (q) q[j]=(uint32_t)qhat;
+	}
+
+	// unnormalize the remainder
+	if (r) {
+		for (int i=0; i<n-1; i++)
+			r[i]=(un[i]>>s) | (s?(uint32_t)((uint64_t)un[i+1]<<(LIMB_BITS-s)):0);
+		r[n-1]=un[n-1]>>s;
+	}
+}
+
+/*****************************************************/
+/* basic operations                                  */
+/*****************************************************/
+
+void twr_big_bzero(struct twr_bigint* big) {
+	big->len=0;
+	big->word[0]=0;
+}
+
+void twr_big_assign(struct twr_bigint* dest, const struct twr_bigint* src) {
+	if (dest==src) return;
+	dest->len=src->len;
+	dest->word[0]=0;
+	memcpy(dest->word, src->word, src->len*sizeof(uint32_t));
+}
+
+void twr_big_assign32u(struct twr_bigint* dest, uint32_t value) {
+	dest->word[0]=value;
+	dest->len=value?1:0;
+}
+
+void twr_big_assign64u(struct twr_bigint* dest, uint64_t value) {
+	dest->word[0]=(uint32_t)value;
+	dest->word[1]=(uint32_t)(value>>32);
+	big_setlen(dest, 2);
+}
+
+int twr_big_iszero(const struct twr_bigint* big) {
+	return big->len==0;
+}
+
+int twr_big_isint32u(const struct twr_bigint* big) {
+	return big->len<=1;
+}
+
+int twr_big_isint64u(const struct twr_bigint* big) {
+	return big->len<=2;
+}
+
+int twr_big_isequal32u(const struct twr_bigint* big, uint32_t value) {
+	return big->len<=1 && big->word[0]==value;
+}
+
+uint32_t twr_big_get32u(const struct twr_bigint* big) {
+	return big->word[0];
+}
+
+uint64_t twr_big_get64u(const struct twr_bigint* big) {
+	if (big->len<2) return big->word[0];
+	return ((uint64_t)big->word[1]<<32) | big->word[0];
+}
+
+int twr_big_cmp(const struct twr_bigint* a, const struct twr_bigint* b) {
+	if (a->len!=b->len) return a->len>b->len?1:-1;
+	for (int i=a->len-1; i>=0; i--) {
+		if (a->word[i]!=b->word[i]) return a->word[i]>b->word[i]?1:-1;
+	}
+	return 0;
+}
+
+int twr_big_isequal(const struct twr_bigint* a, const struct twr_bigint* b) {
+	return twr_big_cmp(a, b)==0;
+}
+
+int twr_big_isgt(const struct twr_bigint* a, const struct twr_bigint* b) {
+	return twr_big_cmp(a, b)>0;
+}
+
+int twr_big_islt(const struct twr_bigint* a, const struct twr_bigint* b) {
+	return twr_big_cmp(a, b)<0;
+}
+
+int twr_big_add(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b) {
+	if (a->len<b->len) {
+		const struct twr_bigint* t=a; a=b; b=t;
+	}
+	const int an=a->len, bn=b->len;
+	uint64_t carry=0;
+	int i;
+	for (i=0; i<bn; i++) {
+		carry+=(uint64_t)a->word[i]+b->word[i];
+		r->word[i]=(uint32_t)carry;
+		carry>>=LIMB_BITS;
+	}
+	for (; i<an; i++) {
+		carry+=a->word[i];
+		r->word[i]=(uint32_t)carry;
+		carry>>=LIMB_BITS;
+	}
+	if (carry) {
+		if (an==BIGINT_SIZEW) {
+			big_setlen(r, an);
+			return 1;
+		}
+		r->word[an]=(uint32_t)carry;
+		r->len=an+1;
+	}
+	else {
+		r->len=an;
+		if (an==0) r->word[0]=0;
+	}
+	return 0;
+}
+
+int twr_big_add32u(struct twr_bigint* r, const struct twr_bigint* a, uint32_t b) {
+	struct twr_bigint t;
+	twr_big_assign32u(&t, b);
+	return twr_big_add(r, a, &t);
+}
+
+int twr_big_sub(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b) {
+	if (twr_big_cmp(a, b)<0) {
+		twr_big_bzero(r);
+		return 1;
+	}
+	twr_big_assign(r, a);
+	limbs_sub_from(r->word, r->len, b->word, b->len);
+	big_setlen(r, r->len);
+	return 0;
+}
+
+int twr_big_mult32u(struct twr_bigint* r, const struct twr_bigint* a, uint32_t b) {
+	const int n=a->len;
+	uint64_t carry=0;
+	for (int i=0; i<n; i++) {
+		carry+=(uint64_t)a->word[i]*b;
+		r->word[i]=(uint32_t)carry;
+		carry>>=LIMB_BITS;
+	}
+	if (carry) {
+		if (n==BIGINT_SIZEW) {
+			big_setlen(r, n);
+			return 1;
+		}
+		r->word[n]=(uint32_t)carry;
+		r->len=n+1;
+	}
+	else
+		big_setlen(r, n);
+	return 0;
+}
+
+int twr_big_mult(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b) {
+	const int an=a->len, bn=b->len;
+	if (an==0 || bn==0) {
+		twr_big_bzero(r);
+		return 0;
+	}
+	if (bn==1) return twr_big_mult32u(r, a, b->word[0]);
+	if (an==1) return twr_big_mult32u(r, b, a->word[0]);
+	if (an+bn-1 > BIGINT_SIZEW) {  // too big, even before any carry
+		twr_big_bzero(r);
+		return 1;
+	}
+
+	uint32_t t[an+bn];
+	limbs_mul(t, a->word, an, b->word, bn);
+	int n=limbs_norm(t, an+bn);
+	if (n>BIGINT_SIZEW) {
+		twr_big_bzero(r);
+		return 1;
+	}
+	memcpy(r->word, t, n*sizeof(uint32_t));
+	big_setlen(r, n);
+	return 0;
+}
+
+uint32_t twr_big_div32u(struct twr_bigint* q, const struct twr_bigint* num, uint32_t den) {
+	if (den==0) return 0;
+	const int n=num->len;
+	const uint32_t rem=limbs_divmod1(q?q->word:NULL, num->word, n, den);
+	if (q) big_setlen(q, n);
+	return rem;
+}
+
+int twr_big_div(struct twr_bigint* q, struct twr_bigint* r, const struct twr_bigint* num, const struct twr_bigint* den) {
+	const int m=num->len, n=den->len;
+
+	if (n==0) return 1;
+
+	if (twr_big_cmp(num, den)<0) {
+		if (r) twr_big_assign(r, num);
+		if (q) twr_big_bzero(q);
+		return 0;
+	}
+
+	if (n==1) {
+		const uint32_t rem=twr_big_div32u(q, num, den->word[0]);
+		if (r) twr_big_assign32u(r, rem);
+		return 0;
+	}
+
+	// q and r may be the same struct as num or den, so use temps
+	uint32_t qw[m-n+1], rw[n];
+	limbs_divmod_knuth(qw, rw, num->word, m, den->word, n);
+	if (q) {
+		memcpy(q->word, qw, (m-n+1)*sizeof(uint32_t));
+		big_setlen(q, m-n+1);
+	}
+	if (r) {
+		memcpy(r->word, rw, n*sizeof(uint32_t));
+		big_setlen(r, n);
+	}
+	return 0;
+}
+
+int twr_big_shiftleft_bits(struct twr_bigint* big, int n) {
+	if (big->len==0 || n<=0) return 0;
+
+	const int words=n/LIMB_BITS, bits=n%LIMB_BITS;
+	const int len=big->len;
+	int newlen=len+words;
+	uint32_t top=bits ? big->word[len-1]>>(LIMB_BITS-bits) : 0;
+	if (top) newlen++;
+	if (newlen>BIGINT_SIZEW) {
+		twr_big_bzero(big);
+		return 1;
+	}
+
+	if (top) big->word[len+words]=top;
+	for (int i=len-1; i>=0; i--) {
+		uint32_t w=big->word[i]<<bits;
+		if (bits && i>0) w|=big->word[i-1]>>(LIMB_BITS-bits);
+		big->word[i+words]=w;
+	}
+	memset(big->word, 0, words*sizeof(uint32_t));
+	big->len=newlen;
+	return 0;
+}
+
+void twr_big_shiftright_bits(struct twr_bigint* big, int n) {
+	if (n<=0) return;
+
+	const int words=n/LIMB_BITS, bits=n%LIMB_BITS;
+	const int len=big->len;
+	if (words>=len) {
+		twr_big_bzero(big);
+		return;
+	}
+
+	const int newlen=len-words;
+	for (int i=0; i<newlen; i++) {
+		uint32_t w=big->word[i+words]>>bits;
+		if (bits && i+words+1<len) w|=big->word[i+words+1]<<(LIMB_BITS-bits);
+		big->word[i]=w;
+	}
+	big_setlen(big, newlen);
+}
+
+void twr_big_shiftright_onebit(struct twr_bigint* big) {
+	twr_big_shiftright_bits(big, 1);
+}
+
+int twr_big_2pow(struct twr_bigint* r, int exp) {
+	if (exp<0 || exp>=BIGINT_SIZEW*LIMB_BITS) {
+		twr_big_bzero(r);
+		return 1;
+	}
+	const int w=exp/LIMB_BITS;
+	memset(r->word, 0, w*sizeof(uint32_t));
+	r->word[w]=(uint32_t)1<<(exp%LIMB_BITS);
+	r->len=w+1;
+	return 0;
+}
+
+// r=base^exp, where chunk=base^chunkexp fits in 32 bits
+static int big_smallpow(struct twr_bigint* r, int exp, uint32_t base, uint32_t chunk, int chunkexp) {
+	if (exp<0) {
+		twr_big_bzero(r);
+		return 1;
+	}
+	twr_big_assign32u(r, 1);
+	while (exp>=chunkexp) {
+		if (twr_big_mult32u(r, r, chunk)) return 1;
+		exp-=chunkexp;
+	}
+	uint32_t rest=1;
+	while (exp--) rest*=base;
+	return twr_big_mult32u(r, r, rest);
+}
+
+int twr_big_5pow(struct twr_bigint* r, int exp) {
+	return big_smallpow(r, exp, 5, 1220703125, 13);
+}
+
+int twr_big_10pow(struct twr_bigint* r, int exp) {
+	return big_smallpow(r, exp, 10, 1000000000, 9);
+}
+
+/*****************************************************/
+/* logs                                              */
+/*****************************************************/
+
+int twr_big_numbits(const struct twr_bigint* big) {
+	if (big->len==0) return 0;
+	return big->len*LIMB_BITS - __builtin_clz(big->word[big->len-1]);
+}
+
+int twr_big_2log(const struct twr_bigint* num, const struct twr_bigint* den) {
+	if (num->len==0 || den->len==0) return BIGINT_LOG_OFZERO_ERROR;
+
+	int d=twr_big_numbits(num)-twr_big_numbits(den);
+	struct twr_bigint t;
+
+	// num/den is in [2^(d-1), 2^(d+1))
+	if (d>=0) {
+		twr_big_assign(&t, den);
+		twr_big_shiftleft_bits(&t, d);
+		if (twr_big_cmp(num, &t)<0) d--;
+	}
+	else {
+		twr_big_assign(&t, num);
+		twr_big_shiftleft_bits(&t, -d);
+		if (twr_big_cmp(&t, den)<0) d--;
+	}
+
+	return d;
+}
+
+// compare num/den to 10^k
+static int cmp_pow10(const struct twr_bigint* num, const struct twr_bigint* den, int k) {
+	struct twr_bigint t, p;
+	if (k>=0) {
+		twr_big_10pow(&p, k);
+		if (twr_big_mult(&t, den, &p)) return -1;   // den*10^k doesn't fit, so it must be bigger than num
+		return twr_big_cmp(num, &t);
+	}
+	else {
+		twr_big_10pow(&p, -k);
+		if (twr_big_mult(&t, num, &p)) return 1;
+		return twr_big_cmp(&t, den);
+	}
+}
+
+int twr_big_10log(const struct twr_bigint* num, const struct twr_bigint* den) {
+	const int l2=twr_big_2log(num, den);
+	if (l2==BIGINT_LOG_OFZERO_ERROR) return l2;
+
+	// 78913/2^18 ~= log10(2).  The estimate can be off by one either way.
+	int k=(l2*78913)>>18;
+	if (cmp_pow10(num, den, k+1)>=0) k++;
+	else if (cmp_pow10(num, den, k)<0) k--;
+
+	return k;
+}
+
+int twr_big_num10digits(const struct twr_bigint* big) {
+	struct twr_bigint one;
+	if (big->len==0) return 1;
+	twr_big_assign32u(&one, 1);
+	return twr_big_10log(big, &one)+1;
+}
+
+/*****************************************************/
+/* conversion to and from text                       */
+/*****************************************************/
+
+// dc_pow10[k] is 10^(9*2^k).  malloc'd on first use, since they are only needed for large values
+static struct twr_bigint* dc_pow10;
+static int dc_pow10_count;
+
+static const struct twr_bigint* get_dc_pow10(int level) {
+	if (level>=DC_MAXLEVEL) return NULL;
+	if (dc_pow10==NULL) {
+		dc_pow10=malloc(sizeof(struct twr_bigint)*DC_MAXLEVEL);
+		if (dc_pow10==NULL) return NULL;
+		twr_big_assign32u(&dc_pow10[0], 1000000000);
+		dc_pow10_count=1;
+	}
+	while (dc_pow10_count<=level) {
+		if (twr_big_mult(&dc_pow10[dc_pow10_count], &dc_pow10[dc_pow10_count-1], &dc_pow10[dc_pow10_count-1])) return NULL;
+		dc_pow10_count++;
+	}
+	return &dc_pow10[level];
+}
+
+static const char digit_chars[]="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// output digits least significant first, by repeated division by radix^chunkdigits.
+// at least mindigits are output (zero padded).  returns number of digits or -1 if size is too small
+static int big_itoa_reversed(const struct twr_bigint* big, char* buffer, int size, int radix, int mindigits) {
+	uint32_t chunk=radix;
+	int chunkdigits=1;
+	while ((uint64_t)chunk*radix <= 0xFFFFFFFF) {
+		chunk*=radix;
+		chunkdigits++;
+	}
+
+	struct twr_bigint t;
+	twr_big_assign(&t, big);
+	int n=0;
+	while (t.len>0) {
+		uint32_t rem=twr_big_div32u(&t, &t, chunk);
+		for (int i=0; i<chunkdigits && (t.len>0 || rem>0); i++) {
+			if (n>=size) return -1;
+			buffer[n++]=digit_chars[rem%radix];
+			rem/=radix;
+		}
+		if (t.len>0) {   // pad an inner chunk with zeros
+			while (n%chunkdigits) {
+				if (n>=size) return -1;
+				buffer[n++]='0';
+			}
+		}
+	}
+	while (n<mindigits) {
+		if (n>=size) return -1;
+		buffer[n++]='0';
+	}
+	return n;
+}
+
+static void str_reverse(char* s, int n) {
+	for (int i=0, j=n-1; i<j; i++, j--) {
+		const char c=s[i];
+		s[i]=s[j];
+		s[j]=c;
+	}
+}
+
+// base 10, most significant first.  if width>0, exactly width digits are output (zero padded)
+// returns number of digits or -1 if size is too small
+static int big_dtoa_dc(const struct twr_bigint* big, char* buffer, int size, int width) {
+	int level=-1;
+
+	if (big->len>=DC_CUTOFF) {
+		// split with the largest 10^(9*2^level) that has no more than half the words of big
+		const struct twr_bigint* p;
+		while ((p=get_dc_pow10(level+1))!=NULL && p->len*2 <= big->len) level++;
+	}
+
+	if (level<0) {
+		const int n=big_itoa_reversed(big, buffer, size, 10, width);
+		if (n<0) return -1;
+		str_reverse(buffer, n);
+		return n;
+	}
+
+	const int lowdigits=9<<level;
+	struct twr_bigint q, r;
+	twr_big_div(&q, &r, big, get_dc_pow10(level));
+
+	int nh=big_dtoa_dc(&q, buffer, size, width>0?width-lowdigits:0);
+	if (nh<0) return -1;
+	int nl=big_dtoa_dc(&r, buffer+nh, size-nh, lowdigits);
+	if (nl<0) return -1;
+	return nh+nl;
+}
+
+int twr_big_itoa(const struct twr_bigint* big, char* buffer, int size, int radix) {
+	int n;
+
+	if (buffer==NULL || size<1) return 1;
+	if (radix<2 || radix>36) {
+		buffer[0]=0;
+		return 1;
+	}
+
+	if (radix==10) {
+		n=big_dtoa_dc(big, buffer, size-1, 1);
+	}
+	else {
+		n=big_itoa_reversed(big, buffer, size-1, radix, 1);
+		if (n>=0) str_reverse(buffer, n);
+	}
+
+	if (n<0) {
+		buffer[0]=0;
+		return 1;
+	}
+	buffer[n]=0;
+	return 0;
+}
+
+// n decimal digits to a bigint
+static int big_atoi_dc(const char* str, int n, struct twr_bigint* big) {
+	int level=-1;
+	const struct twr_bigint* p;
+
+	if (n > DC_CUTOFF*9) {
+		while ((p=get_dc_pow10(level+1))!=NULL && (18<<(level+1)) <= n) level++;
+	}
+
+	if (level<0) {
+		static const uint32_t pow10[]={1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+		twr_big_bzero(big);
+		while (n>0) {
+			const int chunk=(n%9)?(n%9):9;
+			uint32_t v=0;
+			for (int i=0; i<chunk; i++)
+				v=v*10+(str[i]-'0');
+			if (twr_big_mult32u(big, big, pow10[chunk])) return 1;
+			if (twr_big_add32u(big, big, v)) return 1;
+			str+=chunk;
+			n-=chunk;
+		}
+		return 0;
+	}
+
+	// big = high*10^lowdigits + low
+	const int lowdigits=9<<level;
+	struct twr_bigint low;
+	if (big_atoi_dc(str, n-lowdigits, big)) return 1;
+	if (big_atoi_dc(str+n-lowdigits, lowdigits, &low)) return 1;
+	if (twr_big_mult(big, big, get_dc_pow10(level))) return 1;
+	return twr_big_add(big, big, &low);
+}
+
+// returns the number of decimal digits consumed, or -1 if the number doesn't fit (and big is set to zero)
+int twr_big_atoi(const char* str, struct twr_bigint* big) {
+	int n=0;
+	while (isdigit((unsigned char)str[n])) n++;
+
+	if (big_atoi_dc(str, n, big)) {
+		twr_big_bzero(big);
+		return -1;
+	}
+	return n;
+}
+
+/*****************************************************/
+/* unit tests                                        */
+/*****************************************************/
+
+static int big_expect(const struct twr_bigint* big, const char* str) {
+	char buffer[2600];
+	if (twr_big_itoa(big, buffer, sizeof(buffer), 10)) return 0;
+	return strcmp(buffer, str)==0;
+}
+
+int twr_big_run_unit_tests(void) {
+	struct twr_bigint a, b, c, q, r;
+	char buffer[2600];
+
+	twr_big_assign64u(&a, 0xFFFFFFFFFFFFFFFFULL);
+	if (!big_expect(&a, "18446744073709551615")) return 0;
+	if (twr_big_add32u(&a, &a, 1)) return 0;
+	if (!big_expect(&a, "18446744073709551616")) return 0;
+	if (a.len!=3 || twr_big_numbits(&a)!=65) return 0;
+	if (twr_big_sub(&a, &a, &a) || !twr_big_iszero(&a) || a.word[0]!=0) return 0;
+
+	twr_big_assign32u(&a, 5);
+	twr_big_assign32u(&b, 7);
+	if (twr_big_sub(&c, &a, &b)!=1) return 0;
+
+	twr_big_assign32u(&a, 0);
+	if (!big_expect(&a, "0") || twr_big_num10digits(&a)!=1) return 0;
+
+	twr_big_10pow(&a, 30);
+	if (!big_expect(&a, "1000000000000000000000000000000")) return 0;
+	if (twr_big_num10digits(&a)!=31) return 0;
+	twr_big_itoa(&a, buffer, sizeof(buffer), 16);
+	if (strcmp(buffer, "C9F2C9CD04674EDEA40000000")!=0) return 0;
+	if (twr_big_itoa(&a, buffer, 10, 10)!=1) return 0;
+
+	twr_big_2pow(&a, 100);
+	twr_big_itoa(&a, buffer, sizeof(buffer), 2);
+	if (strlen(buffer)!=101 || buffer[0]!='1' || buffer[1]!='0') return 0;
+
+	// logs
+	twr_big_assign32u(&a, 1);
+	twr_big_assign32u(&b, 10);
+	if (twr_big_2log(&a, &b)!=-4 || twr_big_10log(&a, &b)!=-1) return 0;
+	twr_big_assign32u(&a, 999);
+	twr_big_assign32u(&b, 1);
+	if (twr_big_2log(&a, &b)!=9 || twr_big_10log(&a, &b)!=2) return 0;
+	twr_big_assign32u(&a, 1000);
+	if (twr_big_10log(&a, &b)!=3) return 0;
+	twr_big_bzero(&a);
+	if (twr_big_10log(&a, &b)!=BIGINT_LOG_OFZERO_ERROR) return 0;
+
+	// shifts
+	twr_big_assign32u(&a, 3);
+	twr_big_shiftleft_bits(&a, 100);
+	twr_big_shiftright_bits(&a, 99);
+	if (!twr_big_isequal32u(&a, 6)) return 0;
+	twr_big_shiftright_onebit(&a);
+	if (!twr_big_isequal32u(&a, 3)) return 0;
+
+	// division, including the Knuth add back case
+	if (twr_big_atoi("340282366920938463463374607431768211455", &a)!=39) return 0;  // 2^128-1
+	if (twr_big_atoi("18446744073709551617xyz", &b)!=20) return 0;  // 2^64+1
+	twr_big_div(&q, &r, &a, &b);
+	if (!big_expect(&q, "18446744073709551615") || !twr_big_iszero(&r)) return 0;
+	twr_big_atoi("1000000000000000000000000000000000000000001", &a);
+	twr_big_atoi("99999999999999999999", &b);
+	twr_big_div(&a, &r, &a, &b);   // q aliases num
+	if (!big_expect(&a, "10000000000000000000100") || !big_expect(&r, "101")) return 0;
+	twr_big_bzero(&b);
+	if (twr_big_div(&q, &r, &a, &b)!=1) return 0;
+
+	// big numbers: Karatsuba and divide-and-conquer paths
+	// a=(10^600-1)/9 (all ones), b=3^1000
+	for (int i=0; i<600; i++) buffer[i]='1';
+	buffer[600]=0;
+	if (twr_big_atoi(buffer, &a)!=600) return 0;
+	if (!big_expect(&a, buffer)) return 0;
+	twr_big_assign32u(&b, 1);
+	for (int i=0; i<1000; i++) twr_big_mult32u(&b, &b, 3);
+	if (twr_big_mult(&c, &a, &b)) return 0;
+	if (twr_big_div(&q, &r, &c, &b) || !twr_big_isequal(&q, &a) || !twr_big_iszero(&r)) return 0;
+	if (twr_big_add32u(&c, &c, 12345)) return 0;
+	if (twr_big_div(&q, &r, &c, &a) || !twr_big_isequal(&q, &b) || !twr_big_isequal32u(&r, 12345)) return 0;
+	if (twr_big_itoa(&c, buffer, sizeof(buffer), 10)) return 0;
+	if (twr_big_atoi(buffer, &q)!=(int)strlen(buffer) || !twr_big_isequal(&q, &c)) return 0;
+
+	// (a*a) with a mix of words,  checked as (a*a)/a
+	for (int i=0; i<120; i++) a.word[i]=0x9E3779B9u*(i+1);
+	a.len=120;
+	if (twr_big_mult(&c, &a, &a)) return 0;
+	if (twr_big_div(&q, &r, &c, &a) || !twr_big_isequal(&q, &a) || !twr_big_iszero(&r)) return 0;
+
+	// overflow
+	twr_big_2pow(&a, BIGINT_SIZEW*32-1);
+	if (twr_big_mult32u(&b, &a, 2)!=1) return 0;
+	if (twr_big_mult(&b, &a, &a)!=1) return 0;
+	if (twr_big_add(&b, &a, &a)!=1) return 0;
+	if (twr_big_shiftleft_bits(&a, 1)!=1) return 0;
+
+	return 1;
+}
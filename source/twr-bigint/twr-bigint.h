@@ -0,0 +1,73 @@
+#ifndef __TWR_BIGINT_H__
+#define __TWR_BIGINT_H__
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* unsigned arbitrary precision integers, up to BIGINT_SIZEW 32 bit words (8192 bits, about 2466 decimal digits) */
+/* a twr_bigint is a fixed size struct, so it can be declared on the stack and copied with twr_big_assign() */
+/* operations only touch the words in use (len), so small values are fast */
+/* functions that return int return 0 on success, or 1 if the result overflowed (didn't fit) */
+
+/* keep in sync with twrBigIntSizeW in twrmodbase.ts */
+#define BIGINT_SIZEW 256
+
+#define BIGINT_LOG_OFZERO_ERROR (-2147483647-1)
+
+struct twr_bigint {
+	int len;								/* number of words in use.  0 for zero.  word[len-1] is never 0 */
+	uint32_t word[BIGINT_SIZEW];	/* little endian: word[0] is the least significant.  word[0] is 0 for zero. */
+};
+
+void twr_big_bzero(struct twr_bigint* big);
+void twr_big_assign(struct twr_bigint* dest, const struct twr_bigint* src);
+void twr_big_assign32u(struct twr_bigint* dest, uint32_t value);
+void twr_big_assign64u(struct twr_bigint* dest, uint64_t value);
+
+int twr_big_iszero(const struct twr_bigint* big);
+int twr_big_isint32u(const struct twr_bigint* big);
+int twr_big_isint64u(const struct twr_bigint* big);
+int twr_big_isequal32u(const struct twr_bigint* big, uint32_t value);
+uint32_t twr_big_get32u(const struct twr_bigint* big);
+uint64_t twr_big_get64u(const struct twr_bigint* big);
+
+int twr_big_cmp(const struct twr_bigint* a, const struct twr_bigint* b);  /* -1, 0, 1 */
+int twr_big_isequal(const struct twr_bigint* a, const struct twr_bigint* b);
+int twr_big_isgt(const struct twr_bigint* a, const struct twr_bigint* b);
+int twr_big_islt(const struct twr_bigint* a, const struct twr_bigint* b);
+
+/* the result may be the same struct as an operand */
+int twr_big_add(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b);
+int twr_big_add32u(struct twr_bigint* r, const struct twr_bigint* a, uint32_t b);
+int twr_big_sub(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b);  /* returns 1 if b>a */
+int twr_big_mult(struct twr_bigint* r, const struct twr_bigint* a, const struct twr_bigint* b);
+int twr_big_mult32u(struct twr_bigint* r, const struct twr_bigint* a, uint32_t b);
+int twr_big_div(struct twr_bigint* q, struct twr_bigint* r, const struct twr_bigint* num, const struct twr_bigint* den);  /* q or r may be NULL.  returns 1 on divide by zero */
+uint32_t twr_big_div32u(struct twr_bigint* q, const struct twr_bigint* num, uint32_t den);  /* returns the remainder */
+
+int twr_big_shiftleft_bits(struct twr_bigint* big, int n);
+void twr_big_shiftright_bits(struct twr_bigint* big, int n);
+void twr_big_shiftright_onebit(struct twr_bigint* big);
+
+int twr_big_2pow(struct twr_bigint* r, int exp);
+int twr_big_5pow(struct twr_bigint* r, int exp);
+int twr_big_10pow(struct twr_bigint* r, int exp);
+
+int twr_big_numbits(const struct twr_bigint* big);
+int twr_big_2log(const struct twr_bigint* num, const struct twr_bigint* den);   /* floor(log2(num/den)) or BIGINT_LOG_OFZERO_ERROR */
+int twr_big_10log(const struct twr_bigint* num, const struct twr_bigint* den);  /* floor(log10(num/den)) or BIGINT_LOG_OFZERO_ERROR */
+int twr_big_num10digits(const struct twr_bigint* big);
+
+int twr_big_itoa(const struct twr_bigint* big, char* buffer, int size, int radix);  /* returns 1 if buffer is too small */
+int twr_big_atoi(const char* str, struct twr_bigint* big);  /* returns number of decimal digits consumed, or -1 if the value doesn't fit */
+
+int twr_big_run_unit_tests(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -1,24 +1,16 @@
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 #include "twr-jsimports.h"
 #include "twr-crt.h"
 #include "twr-draw2d.h"
 
-void d2d_free_instructions(struct d2d_draw_seq* ds) {
-    assert(ds);
-    if (ds) {
-        struct d2d_instruction_hdr *next=ds->start;
+// A draw sequence's instructions are records, one after another, in one buffer (ds->buf).  Each record is a
+// struct d2dins_*, rounded up to a multiple of 8 bytes (so that its doubles are aligned), and its hdr.size says how
+// big it is.  twrCanvas.drawSeq decodes the buffer in one pass.  A flush empties the buffer, but keeps it for the
+// next instructions, so once it has grown to fit a frame, drawing doesn't allocate.
 
-        while (next) {
-            //twr_conlog("free instruction me %x type %x next %x",next, next->type, next->next);
-            struct d2d_instruction_hdr * nextnext=next->next;
-            twr_cache_free(next);
-            next=nextnext;
-        }
-        ds->start=0;
-        ds->last=0;
-    }
-}
+#define D2D_BUF_START 4096
 
 static void invalidate_cache(struct d2d_draw_seq* ds) {
     ds->last_fillstyle_color_valid=false;
@@ -27,11 +19,18 @@ static void invalidate_cache(struct d2d_draw_seq* ds) {
 }
 
 struct d2d_draw_seq* d2d_start_draw_sequence(int flush_at_ins_count) {
+    return d2d_start_draw_sequence_on(D2D_DEFAULT_CANVAS, flush_at_ins_count);
+}
+
+// a draw sequence for canvas (a handle from d2d_get_canvas)
+struct d2d_draw_seq* d2d_start_draw_sequence_on(int canvas, int flush_at_ins_count) {
     //twr_conlog("C: d2d_start_draw_sequence");
     struct d2d_draw_seq* ds = twr_cache_malloc(sizeof(struct d2d_draw_seq));
     assert(ds);
-    ds->last=0;
-    ds->start=0;
+    ds->buf=0;
+    ds->len=0;
+    ds->size=0;
+    ds->canvas=canvas;
     ds->ins_count=0;
     invalidate_cache(ds);
     ds->flush_at_ins_count=flush_at_ins_count;
@@ -42,23 +41,73 @@ void d2d_end_draw_sequence(struct d2d_draw_seq* ds) {
     //twr_conlog("C: end_draw_seq");
     d2d_flush(ds);
     if (ds) {  // should never happen -- ie, ds==NULL
+        free(ds->buf);
         twr_cache_free(ds);
     }
 }
 
+// While a batch is open (see d2d_begin_batch), flushed instructions are queued here instead of drawn, and
+// d2d_end_batch sends them all (for any number of canvases) to JavaScript in one call.  A flush swaps its draw
+// sequence's buffer with the (empty) buffer of the next batch entry, so the draw sequence can go on or end, and
+// the buffers are reused by later batches.
+#define D2D_BATCH_MAX 64
+
+static struct d2d_draw_seq batch_seqs[D2D_BATCH_MAX];
+static struct d2d_draw_seq* batch[D2D_BATCH_MAX];
+static int batch_len;
+static int batch_level;
+
+static void send_batch(void) {
+    if (batch_len>0) {
+        twrCanvasDrawSeqs(batch, batch_len);
+        for (int i=0; i<batch_len; i++)
+            batch_seqs[i].len=0;
+        batch_len=0;
+    }
+}
+
+// batches can nest.  The outermost d2d_end_batch sends the batch
+void d2d_begin_batch(void) {
+    batch_level++;
+}
+
+void d2d_end_batch(void) {
+    assert(batch_level>0);
+    if (--batch_level==0)
+        send_batch();
+}
+
 void d2d_flush(struct d2d_draw_seq* ds) {
     assert(ds);
     if (ds) {
-        if (ds->start) {
+        if (ds->len>0) {
             //twr_conlog("do d2d_flush");
-            twrCanvasDrawSeq(ds);
-            d2d_free_instructions(ds); 
+            if (batch_level>0) {
+                if (batch_len==D2D_BATCH_MAX)
+                    send_batch();
+                struct d2d_draw_seq* queued=&batch_seqs[batch_len];
+                unsigned char* buf=queued->buf;
+                const unsigned long size=queued->size;
+                queued->buf=ds->buf;
+                queued->len=ds->len;
+                queued->size=ds->size;
+                queued->canvas=ds->canvas;
+                ds->buf=buf;
+                ds->size=size;
+                batch[batch_len++]=queued;
+            }
+            else {
+                twrCanvasDrawSeq(ds);
+            }
+            ds->len=0;
             ds->ins_count=0;
         }
+        // other draw sequences (or JavaScript) can change the canvas's styles before this one draws again
+        invalidate_cache(ds);
     }
 }
 
-void new_instruction(struct d2d_draw_seq* ds) {
+static void new_instruction(struct d2d_draw_seq* ds) {
     //twr_conlog("new_instruction %d %d", ds->ins_count, ds->flush_at_ins_count);
 
     assert(ds);
@@ -70,53 +119,104 @@ void new_instruction(struct d2d_draw_seq* ds) {
     }
 }
 
-static void set_ptrs(struct d2d_draw_seq* ds, struct d2d_instruction_hdr *e) {
+// space for a record of size bytes at the end of ds->buf, which grows (doubling) if needed.  The caller fills it
+// in, then calls end_record
+static void* new_record(struct d2d_draw_seq* ds, unsigned long type, unsigned long size) {
     assert(ds);
-    if (ds->start==0) {
-        ds->start=e;
-        //twr_conlog("C: set_ptrs start set to %x",ds->start);
+    size=(size+7)&~7UL;
+    if (ds->len+size > ds->size) {
+        unsigned long new_size=ds->size ? ds->size*2 : D2D_BUF_START;
+        while (new_size < ds->len+size)
+            new_size*=2;
+        unsigned char* buf=realloc(ds->buf, new_size);
+        assert(buf);
+        ds->buf=buf;
+        ds->size=new_size;
     }
-    e->next=0;
-    if (ds->last)
-        ds->last->next=e;
-    ds->last=e;
+
+    struct d2d_instruction_hdr* e=(struct d2d_instruction_hdr*)(ds->buf+ds->len);
+    e->size=size;
+    e->type=type;
+    return e;
+}
+
+// a record of size bytes, followed by a copy of str, so that str doesn't need to outlive the call.  (A flush in a
+// batch isn't drawn until d2d_end_batch.)  The caller sets the string's field to size
+static void* new_record_str(struct d2d_draw_seq* ds, unsigned long type, unsigned long size, const char* str) {
+    const unsigned long len=strlen(str)+1;
+    unsigned char* e=new_record(ds, type, size+len);
+    memcpy(e+size, str, len);
+    return e;
+}
+
+static void end_record(struct d2d_draw_seq* ds, struct d2d_instruction_hdr *e) {
+    ds->len+=e->size;
     new_instruction(ds);
-    //twr_conlog("C: set_ptrs ds->last set to %x",ds->last);
+}
+
+/* the handle of <canvas id=element_id>, or -1 if the module has no such canvas.  see twrWasmModuleInJSMain.canvases */
+int d2d_get_canvas(const char* element_id) {
+	return twrCanvasGetHandle(element_id);
 }
 
 /* returns entry in interface ICanvasProps */
 int d2d_get_canvas_prop(const char* prop) {
-	return twrCanvasGetProp(prop);
+	return twrCanvasGetProp(D2D_DEFAULT_CANVAS, prop);
+}
+
+int d2d_get_canvas_prop_on(int canvas, const char* prop) {
+	return twrCanvasGetProp(canvas, prop);
 }
 
 void d2d_fillrect(struct d2d_draw_seq* ds, double x, double y, double w, double h) {
-    struct d2dins_fillrect* r= twr_cache_malloc(sizeof(struct d2dins_fillrect));
-    r->hdr.type=D2D_FILLRECT;
+    struct d2dins_fillrect* r=new_record(ds, D2D_FILLRECT, sizeof(struct d2dins_fillrect));
     r->x=x;
     r->y=y;
     r->w=w;
     r->h=h;
-    set_ptrs(ds, &r->hdr);
+    end_record(ds, &r->hdr);
     //twr_conlog("C: fillrect,last_fillstyle_color:  %d",ds->last_fillstyle_color);
 }
 
 void d2d_strokerect(struct d2d_draw_seq* ds, double x, double y, double w, double h) {
-    struct d2dins_strokerect* r= twr_cache_malloc(sizeof(struct d2dins_strokerect));
-    r->hdr.type=D2D_STROKERECT;
+    struct d2dins_strokerect* r=new_record(ds, D2D_STROKERECT, sizeof(struct d2dins_strokerect));
+    r->x=x;
+    r->y=y;
+    r->w=w;
+    r->h=h;
+    end_record(ds, &r->hdr);
+}
+
+// copy a rectangle of the canvas to another position on it (the rectangles may overlap), for example to scroll
+void d2d_copyrect(struct d2d_draw_seq* ds, double sx, double sy, double w, double h, double dx, double dy) {
+    struct d2dins_copyrect* r=new_record(ds, D2D_COPYRECT, sizeof(struct d2dins_copyrect));
+    r->sx=sx;
+    r->sy=sy;
+    r->w=w;
+    r->h=h;
+    r->dx=dx;
+    r->dy=dy;
+    end_record(ds, &r->hdr);
+}
+
+// a w by h cell of 2x3 blocks (TRS-80 style graphics).  bits 1 and 2 are the top row (left, right), 4 and 8 the
+// middle, 16 and 32 the bottom.  The left column is w/2 wide, and the top two rows are each h/3 high (rounded down)
+void d2d_fillblocks(struct d2d_draw_seq* ds, unsigned long bits, double x, double y, double w, double h) {
+    struct d2dins_fillblocks* r=new_record(ds, D2D_FILLBLOCKS, sizeof(struct d2dins_fillblocks));
     r->x=x;
     r->y=y;
     r->w=w;
     r->h=h;
-    set_ptrs(ds, &r->hdr);
+    r->bits=bits;
+    end_record(ds, &r->hdr);
 }
 
 void d2d_setlinewidth(struct d2d_draw_seq* ds, double width) {
     if (ds->last_line_width!=width) {
         ds->last_line_width=width;
-        struct d2dins_setlinewidth* e= twr_cache_malloc(sizeof(struct d2dins_setlinewidth));
-        e->hdr.type=D2D_SETLINEWIDTH;
+        struct d2dins_setlinewidth* e=new_record(ds, D2D_SETLINEWIDTH, sizeof(struct d2dins_setlinewidth));
         e->width=width;
-        set_ptrs(ds, &e->hdr);  
+        end_record(ds, &e->hdr);  
     }
 }
 
@@ -127,10 +227,9 @@ void d2d_setfillstylergba(struct d2d_draw_seq* ds, unsigned long color) {
     if (!(ds->last_fillstyle_color_valid && color==ds->last_fillstyle_color)) {
         ds->last_fillstyle_color=color;
         ds->last_fillstyle_color_valid=true;
-        struct d2dins_setfillstylergba* e= twr_cache_malloc(sizeof(struct d2dins_setfillstylergba));
-        e->hdr.type=D2D_SETFILLSTYLERGBA;
+        struct d2dins_setfillstylergba* e=new_record(ds, D2D_SETFILLSTYLERGBA, sizeof(struct d2dins_setfillstylergba));
         e->color=color;
-        set_ptrs(ds, &e->hdr);  
+        end_record(ds, &e->hdr);  
     }
 }
 
@@ -141,149 +240,143 @@ void d2d_setstrokestylergba(struct d2d_draw_seq* ds, unsigned long color) {
     if (!(ds->last_strokestyle_color_valid && color==ds->last_strokestyle_color)) {
         ds->last_strokestyle_color=color;
         ds->last_strokestyle_color_valid=true;
-        struct d2dins_setstrokestylergba* e= twr_cache_malloc(sizeof(struct d2dins_setstrokestylergba));
-        e->hdr.type=D2D_SETSTROKESTYLERGBA;
+        struct d2dins_setstrokestylergba* e=new_record(ds, D2D_SETSTROKESTYLERGBA, sizeof(struct d2dins_setstrokestylergba));
         e->color=color;
-        set_ptrs(ds, &e->hdr);  
+        end_record(ds, &e->hdr);  
     }
 }
 
 void d2d_setfillstyle(struct d2d_draw_seq* ds, const char* css_color) {
-    struct d2dins_setfillstyle* e= twr_cache_malloc(sizeof(struct d2dins_setfillstyle));
-    e->hdr.type=D2D_SETFILLSTYLE;
-    e->css_color=css_color;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_setfillstyle* e=new_record_str(ds, D2D_SETFILLSTYLE, sizeof(struct d2dins_setfillstyle), css_color);
+    e->css_color=sizeof(struct d2dins_setfillstyle);
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_setstrokestyle(struct d2d_draw_seq* ds, const char* css_color) {
-    struct d2dins_setstrokestyle* e= twr_cache_malloc(sizeof(struct d2dins_setstrokestyle));
-    e->hdr.type=D2D_SETSTROKESTYLE;
-    e->css_color=css_color;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_setstrokestyle* e=new_record_str(ds, D2D_SETSTROKESTYLE, sizeof(struct d2dins_setstrokestyle), css_color);
+    e->css_color=sizeof(struct d2dins_setstrokestyle);
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_setfont(struct d2d_draw_seq* ds, const char* font) {
-    struct d2dins_setfont* e= twr_cache_malloc(sizeof(struct d2dins_setfont));
-    e->hdr.type=D2D_SETFONT;
-    e->font=font;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_setfont* e=new_record_str(ds, D2D_SETFONT, sizeof(struct d2dins_setfont), font);
+    e->font=sizeof(struct d2dins_setfont);
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_beginpath(struct d2d_draw_seq* ds) {
-    struct d2dins_beginpath* e= twr_cache_malloc(sizeof(struct d2dins_beginpath));
-    e->hdr.type=D2D_BEGINPATH;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_beginpath* e=new_record(ds, D2D_BEGINPATH, sizeof(struct d2dins_beginpath));
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_fill(struct d2d_draw_seq* ds) {
-    struct d2dins_fill* e= twr_cache_malloc(sizeof(struct d2dins_fill));
-    e->hdr.type=D2D_FILL;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_fill* e=new_record(ds, D2D_FILL, sizeof(struct d2dins_fill));
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_stroke(struct d2d_draw_seq* ds) {
-    struct d2dins_stroke* e= twr_cache_malloc(sizeof(struct d2dins_stroke));
-    e->hdr.type=D2D_STROKE;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_stroke* e=new_record(ds, D2D_STROKE, sizeof(struct d2dins_stroke));
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_save(struct d2d_draw_seq* ds) {
-    struct d2dins_save* e= twr_cache_malloc(sizeof(struct d2dins_save));
-    e->hdr.type=D2D_SAVE;
-    set_ptrs(ds, &e->hdr); 
+    struct d2dins_save* e=new_record(ds, D2D_SAVE, sizeof(struct d2dins_save));
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_restore(struct d2d_draw_seq* ds) {
-    struct d2dins_restore* e= twr_cache_malloc(sizeof(struct d2dins_restore));
+    struct d2dins_restore* e=new_record(ds, D2D_RESTORE, sizeof(struct d2dins_restore));
     invalidate_cache(ds);
-    e->hdr.type=D2D_RESTORE;
-    set_ptrs(ds, &e->hdr); 
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_moveto(struct d2d_draw_seq* ds, double x, double y) {
-    struct d2dins_moveto* e= twr_cache_malloc(sizeof(struct d2dins_moveto));
-    e->hdr.type=D2D_MOVETO;
+    struct d2dins_moveto* e=new_record(ds, D2D_MOVETO, sizeof(struct d2dins_moveto));
     e->x=x;
     e->y=y;
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
 }
 
 void d2d_lineto(struct d2d_draw_seq* ds, double x, double y) {
-    struct d2dins_lineto* e= twr_cache_malloc(sizeof(struct d2dins_lineto));
-    e->hdr.type=D2D_LINETO;
+    struct d2dins_lineto* e=new_record(ds, D2D_LINETO, sizeof(struct d2dins_lineto));
     e->x=x;
     e->y=y;
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
 }
 
 void d2d_arc(struct d2d_draw_seq* ds, double x, double y, double radius, double start_angle, double end_angle, bool counterclockwise) {
-    struct d2dins_arc* e= twr_cache_malloc(sizeof(struct d2dins_arc));
-    e->hdr.type=D2D_ARC;
+    struct d2dins_arc* e=new_record(ds, D2D_ARC, sizeof(struct d2dins_arc));
     e->x=x;
     e->y=y;
     e->radius=radius;
     e->start_angle=start_angle;
     e->end_angle=end_angle;
     e->counterclockwise=counterclockwise;
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
 }
 
 void d2d_bezierto(struct d2d_draw_seq* ds, double cp1x, double cp1y, double cp2x, double cp2y, double x, double y) {
-    struct d2dins_bezierto* e= twr_cache_malloc(sizeof(struct d2dins_bezierto));
-    e->hdr.type=D2D_BEZIERTO;
+    struct d2dins_bezierto* e=new_record(ds, D2D_BEZIERTO, sizeof(struct d2dins_bezierto));
     e->cp1x=cp1x;
     e->cp1y=cp1y;
     e->cp2x=cp2x;
     e->cp2y=cp2y;
     e->x=x;
     e->y=y;
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
 }
 
 
 void d2d_filltext(struct d2d_draw_seq* ds, const char* str, double x, double y) {
-    struct d2dins_filltext* e= twr_cache_malloc(sizeof(struct d2dins_filltext));
-    e->hdr.type=D2D_FILLTEXT;
+    struct d2dins_filltext* e=new_record_str(ds, D2D_FILLTEXT, sizeof(struct d2dins_filltext), str);
     e->x=x;
     e->y=y;
-    e->str=str;
+    e->str=sizeof(struct d2dins_filltext);
 	 e->code_page=__get_current_lc_ctype_code_page_modified();
-    set_ptrs(ds, &e->hdr);
+    end_record(ds, &e->hdr);
 }
 
 // c is a unicode 32 bit codepoint
 void d2d_fillcodepoint(struct d2d_draw_seq* ds, unsigned long c, double x, double y) {
-    struct d2dins_fillcodepoint* e= twr_cache_malloc(sizeof(struct d2dins_fillcodepoint));
-    e->hdr.type=D2D_FILLCODEPOINT;
+    struct d2dins_fillcodepoint* e=new_record(ds, D2D_FILLCODEPOINT, sizeof(struct d2dins_fillcodepoint));
     e->x=x;
     e->y=y;
     e->c=c;
    //twr_conlog("C: d2d_char %d %d %d",e->x, e->y, e->c);
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
+}
+
+// n unicode code points, drawn as one string with each advance pixels after the last (for a monospace font)
+void d2d_fillcodepoints(struct d2d_draw_seq* ds, const unsigned long* c, int n, double x, double y, double advance) {
+    struct d2dins_fillcodepoints* e=new_record(ds, D2D_FILLCODEPOINTS, sizeof(struct d2dins_fillcodepoints)+n*sizeof(unsigned long));
+    e->x=x;
+    e->y=y;
+    e->advance=advance;
+    e->n=n;
+    memcpy(e->c, c, n*sizeof(unsigned long));
+    end_record(ds, &e->hdr);
 }
 
 // causes a flush so that a result is returned in *tm
 void d2d_measuretext(struct d2d_draw_seq* ds, const char* str, struct d2d_text_metrics *tm) {
-    struct d2dins_measuretext* e= twr_cache_malloc(sizeof(struct d2dins_measuretext));
-
-    e->hdr.type=D2D_MEASURETEXT;
+    struct d2dins_measuretext* e=new_record(ds, D2D_MEASURETEXT, sizeof(struct d2dins_measuretext));
     e->str=str;
     e->tm=tm;
 	 e->code_page=__get_current_lc_ctype_code_page_modified();
-    set_ptrs(ds, &e->hdr);  
+    end_record(ds, &e->hdr);  
     d2d_flush(ds);
+    send_batch();  // tm is set when the instruction is drawn, so a batch can't wait
 }
 
 
 void d2d_imagedata(struct d2d_draw_seq* ds, long id, void* mem, unsigned long length, unsigned long width, unsigned long height) {
-     struct d2dins_image_data* e= twr_cache_malloc(sizeof(struct d2dins_image_data));
-    e->hdr.type=D2D_IMAGEDATA;
+    struct d2dins_image_data* e=new_record(ds, D2D_IMAGEDATA, sizeof(struct d2dins_image_data));
     e->start=mem-(void*)0;
     e->length=length;
     e->width=width;
     e->height=height;
     e->id=id;
-    set_ptrs(ds, &e->hdr); 
+    end_record(ds, &e->hdr); 
 }
 
 
@@ -292,8 +385,7 @@ void d2d_putimagedata(struct d2d_draw_seq* ds, long id, unsigned long dx, unsign
 }
 
 void d2d_putimagedatadirty(struct d2d_draw_seq* ds, long id, unsigned long dx, unsigned long dy, unsigned long dirtyX, unsigned long dirtyY, unsigned long dirtyWidth, unsigned long dirtyHeight) {
-    struct d2dins_put_image_data* e= twr_cache_malloc(sizeof(struct d2dins_put_image_data));
-    e->hdr.type=D2D_PUTIMAGEDATA;
+    struct d2dins_put_image_data* e=new_record(ds, D2D_PUTIMAGEDATA, sizeof(struct d2dins_put_image_data));
     assert(sizeof(void*)==4);  // ensure 32 bit architecture, 64 bit not supported 
     e->id=id; 
     e->dx=dx;
@@ -302,12 +394,11 @@ void d2d_putimagedatadirty(struct d2d_draw_seq* ds, long id, unsigned long dx, u
     e->dirtyY=dirtyY;
     e->dirtyWidth=dirtyWidth;
     e->dirtyHeight=dirtyHeight;
-    set_ptrs(ds, &e->hdr);
+    end_record(ds, &e->hdr);
 }
 
 void d2d_createradialgradient(struct d2d_draw_seq* ds, long id, double x0, double y0, double radius0, double x1, double y1, double radius1) {
-    struct d2dins_create_radial_gradient* e= twr_cache_malloc(sizeof(struct d2dins_create_radial_gradient));
-    e->hdr.type=D2D_CREATERADIALGRADIENT;
+    struct d2dins_create_radial_gradient* e=new_record(ds, D2D_CREATERADIALGRADIENT, sizeof(struct d2dins_create_radial_gradient));
     e->id=id;
     e->x0=x0;
     e->y0=y0;
@@ -315,39 +406,35 @@ void d2d_createradialgradient(struct d2d_draw_seq* ds, long id, double x0, doubl
     e->x1=x1;
     e->y1=y1;
     e->radius1=radius1;
-    set_ptrs(ds, &e->hdr);    
+    end_record(ds, &e->hdr);    
 }
 
 void d2d_createlineargradient(struct d2d_draw_seq* ds, long id, double x0, double y0, double x1, double y1) {
-    struct d2dins_create_linear_gradient* e= twr_cache_malloc(sizeof(struct d2dins_create_linear_gradient));
-    e->hdr.type=D2D_CREATELINEARGRADIENT;
+    struct d2dins_create_linear_gradient* e=new_record(ds, D2D_CREATELINEARGRADIENT, sizeof(struct d2dins_create_linear_gradient));
     e->id=id;
     e->x0=x0;
     e->y0=y0;
     e->x1=x1;
     e->y1=y1;
-    set_ptrs(ds, &e->hdr);    
+    end_record(ds, &e->hdr);    
 }
 
 void d2d_addcolorstop(struct d2d_draw_seq* ds, long gradid, long position, const char* csscolor) {
-    struct d2dins_set_color_stop* e= twr_cache_malloc(sizeof(struct d2dins_set_color_stop));
-    e->hdr.type=D2D_SETCOLORSTOP;
+    struct d2dins_set_color_stop* e=new_record_str(ds, D2D_SETCOLORSTOP, sizeof(struct d2dins_set_color_stop), csscolor);
     e->id=gradid;
     e->position=position;
-    e->csscolor=csscolor;
-    set_ptrs(ds, &e->hdr); 
+    e->csscolor=sizeof(struct d2dins_set_color_stop);
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_setfillstylegradient(struct d2d_draw_seq* ds, long gradid) {
-    struct d2dins_set_fillstyle_gradient* e= twr_cache_malloc(sizeof(struct d2dins_set_fillstyle_gradient));
-    e->hdr.type=D2D_SETFILLSTYLEGRADIENT;
+    struct d2dins_set_fillstyle_gradient* e=new_record(ds, D2D_SETFILLSTYLEGRADIENT, sizeof(struct d2dins_set_fillstyle_gradient));
     e->id=gradid;
-    set_ptrs(ds, &e->hdr); 
+    end_record(ds, &e->hdr); 
 }
 
 void d2d_releaseid(struct d2d_draw_seq* ds, long id) {
-    struct d2dins_release_id* e= twr_cache_malloc(sizeof(struct d2dins_release_id));
-    e->hdr.type=D2D_RELEASEID;
+    struct d2dins_release_id* e=new_record(ds, D2D_RELEASEID, sizeof(struct d2dins_release_id));
     e->id=id;
-    set_ptrs(ds, &e->hdr); 
+    end_record(ds, &e->hdr); 
 }
\ No newline at end of file
@@ -1,5 +1,9 @@
 #include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "twr-crt.h"
+#include "twr-zlib.h"
 
 
 /*
@@ -67,6 +71,9 @@ void twr_wasm_init(int pf, unsigned long mem_size) {
 			con=twr_debugcon();
 	}
 
+	if (con==NULL)		// (twr_windowcon is out of memory)
+		con=twr_debugcon();
+
 	twr_set_stdio_con(con);
 
 //
@@ -83,6 +90,65 @@ void twr_wasm_init(int pf, unsigned long mem_size) {
 
 }
 
+// called by twrWasmModule after each callC(), so buffered stdout is displayed
+__attribute__((export_name("twr_wasm_flush")))
+void twr_wasm_flush(void) {
+	fflush(NULL);
+}
+
+// memory for a file that twrWasmModuleBase.addFile() loads.  16 byte aligned, for SIMD
+__attribute__((export_name("twr_wasm_alloc_asset")))
+void* twr_wasm_alloc_asset(size_t size) {
+	return aligned_alloc(16, size ? size : 1);
+}
+
+// called by twrWasmModuleBase.addFile(), after it has loaded the file into memory from twr_wasm_alloc_asset
+__attribute__((export_name("twr_wasm_memfs_add")))
+int twr_wasm_memfs_add(const char* path, char* data, size_t len) {
+	return twr_memfs_add(path, data, len);
+}
+
+// the same, for addFile(path, data, {inflate:true}).  data is zlib or gzip compressed, and is freed if the file is added
+__attribute__((export_name("twr_wasm_memfs_add_inflate")))
+int twr_wasm_memfs_add_inflate(const char* path, char* data, size_t len) {
+	size_t cap=len*4+64;
+	if (len>=18 && (unsigned char)data[0]==0x1f) {	// gzip ends with the size
+		const unsigned char* isize=(unsigned char*)data+len-4;
+		cap=isize[0] | isize[1]<<8 | isize[2]<<16 | (size_t)isize[3]<<24;
+		if (cap==0 || cap/1032>len) cap=len*4+64;		// 1032:1 is the most deflate can compress
+	}
+
+	struct twr_inflate* z=twr_inflate_new(TWR_Z_AUTO);
+	char* out=aligned_alloc(16, cap);
+	size_t in=0, made=0;
+	int rv=TWR_Z_DATA_ERROR;
+
+	while (z && out) {
+		size_t used, m;
+		rv=twr_inflate(z, data+in, len-in, &used, out+made, cap-made, &m);
+		in+=used;
+		made+=m;
+		if (rv!=TWR_Z_OK) break;
+
+		if (used==0 && m==0) {
+			if (made<cap) break;		// truncated
+			char* bigger=aligned_alloc(16, cap*2);
+			if (bigger) memcpy(bigger, out, made);
+			free(out);
+			out=bigger;
+			cap*=2;
+		}
+	}
+	twr_inflate_free(z);
+
+	if (rv!=TWR_Z_END || twr_memfs_add(path, out, made)!=0) {
+		free(out);
+		return -1;
+	}
+	free(data);
+	return 0;
+}
+
 __attribute__((export_name("twr_wasm_print_mem_debug_stats")))
 void twr_wasm_print_mem_debug_stats(void) {
 	twr_mem_debug_stats(twr_get_stderr_con());
@@ -1,12 +1,15 @@
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdio.h>
+#include <string.h>
 #include <ctype.h>
 #include <assert.h>
 #include <locale.h>
+#include <limits.h>
 #include <twr-jsimports.h>
 #include "twr-io.h"
-#include "twr-crt.h"  //twr_vcbprintf
+#include "twr-crt.h"
 
 /*
  * Console I/O routines.
@@ -32,6 +35,131 @@
  */
 
 
+//*************************************************
+// Each color is stored once, in display.palette, and cells hold its index.  palette_hash finds a color's index: it
+// has palette_size*2 slots, each 0 (empty) or an index+1
+
+#define PALETTE_MAX 65535
+#define PALETTE_RETRY 1024		// when every color is in use, compact again after this many more colors
+#define CELL_INVALID 0xFFFFFFFF		// not a code point, so never the same as a cell being drawn
+
+static int hash_color(unsigned long rgba, int slots)
+{
+	return ((rgba*2654435761UL)>>15)&(slots-1);
+}
+
+static void rehash_palette(struct IoDisplay* d)
+{
+	const int slots=d->palette_size*2;
+	memset(d->palette_hash, 0, slots*sizeof(unsigned short));
+	for (int i=0; i<d->palette_len; i++) {
+		int h=hash_color(d->palette[i], slots);
+		while (d->palette_hash[h]) h=(h+1)&(slots-1);
+		d->palette_hash[h]=i+1;
+	}
+}
+
+// the palette is full: keep only the colors that cells use.  Usually this leaves plenty of room, but a big display
+// (with a front buffer) can use every color
+static void compact_palette(struct IoDisplay* d)
+{
+	unsigned short* remap=malloc(d->palette_len*sizeof(unsigned short));
+	unsigned long* palette=malloc(d->palette_size*sizeof(unsigned long));
+	assert(remap && palette);
+	memset(remap, 0xFF, d->palette_len*sizeof(unsigned short));
+	int n=0;
+
+#define REMAP(index) do { if (remap[index]==0xFFFF) { palette[n]=d->palette[index]; remap[index]=n++; } (index)=remap[index]; } while(0)
+	for (int i=0; i<d->size; i++) {
+		REMAP(d->cells[i].fore);
+		REMAP(d->cells[i].back);
+		if (d->front) {
+			REMAP(d->front[i].fore);
+			REMAP(d->front[i].back);
+		}
+	}
+	REMAP(d->fore_index);
+	REMAP(d->back_index);
+#undef REMAP
+
+	free(remap);
+	free(d->palette);
+	d->palette=palette;
+	d->palette_len=n;
+	rehash_palette(d);
+}
+
+// the color in the palette closest to rgba, for when every color is in use
+static unsigned short nearest_color(struct IoDisplay* d, unsigned long rgba)
+{
+	unsigned long best_dist=ULONG_MAX;
+	int best=0;
+	for (int i=0; i<d->palette_len; i++) {
+		unsigned long dist=0;
+		for (int shift=0; shift<32; shift+=8) {
+			const long diff=(long)((rgba>>shift)&0xFF)-(long)((d->palette[i]>>shift)&0xFF);
+			dist+=diff*diff;
+		}
+		if (dist<best_dist) {
+			best_dist=dist;
+			best=i;
+		}
+	}
+	return best;
+}
+
+static unsigned short color_index(struct IoDisplay* d, unsigned long rgba)
+{
+	if (d->palette_len>0) {
+		const int slots=d->palette_size*2;
+		for (int h=hash_color(rgba, slots); d->palette_hash[h]; h=(h+1)&(slots-1))
+			if (d->palette[d->palette_hash[h]-1]==rgba)
+				return d->palette_hash[h]-1;
+	}
+
+	if (d->palette_len==PALETTE_MAX) {
+		if (d->palette_nearest==0)
+			compact_palette(d);
+		if (d->palette_len==PALETTE_MAX) {
+			d->palette_nearest=(d->palette_nearest+1)%PALETTE_RETRY;
+			return nearest_color(d, rgba);
+		}
+	}
+
+	if (d->palette_len==d->palette_size) {
+		const int size=d->palette_size==0 ? 16 : (d->palette_size*2 > PALETTE_MAX ? PALETTE_MAX+1 : d->palette_size*2);
+		unsigned long* palette=realloc(d->palette, size*sizeof(unsigned long));
+		unsigned short* hash=malloc(size*2*sizeof(unsigned short));
+		assert(palette && hash);
+		free(d->palette_hash);
+		d->palette=palette;
+		d->palette_hash=hash;
+		d->palette_size=size;
+		rehash_palette(d);
+	}
+
+	const int slots=d->palette_size*2;
+	int h=hash_color(rgba, slots);
+	while (d->palette_hash[h]) h=(h+1)&(slots-1);
+	d->palette_hash[h]=d->palette_len+1;
+	d->palette[d->palette_len]=rgba;
+	return d->palette_len++;
+}
+
+static inline void set_cell(struct IoDisplay* d, int location, unsigned long c)
+{
+	d->cells[location].c=c;
+	d->cells[location].fore=d->fore_index;
+	d->cells[location].back=d->back_index;
+}
+
+// draw cells start to end.  With double buffering, io_present() draws them instead
+static void draw_range(struct IoConsoleWindow* iow, int start, int end)
+{
+	if (!iow->display.front)
+		iow->display.io_draw_range(iow, start, end);
+}
+
 //*************************************************
 
 static void erase_line(struct IoConsoleWindow* iow)
@@ -44,8 +172,45 @@ static void erase_line(struct IoConsoleWindow* iow)
 	io_end_draw((struct IoConsole*)iow);
 }
 		
+/* maintain the cursor of a stream device.  returns false if c should not be output */
+static bool stream_cursor(struct IoConsole* io, unsigned char c)
+{
+	if (c==13 || c==10 || c==12)	// return, or form feed (clear)
+	{
+		io->header.cursor = 0;
+	}
+	else if (c==8 || c==24)	// backspace || backspace cursor
+	{
+		if (io->header.cursor > 0)
+			io->header.cursor--;
+		else
+			return false;
+	}
+	else
+	{
+		io->header.cursor++;
+	}
+	return true;
+}
+
+static inline bool is_buffered(struct IoConsole* io)
+{
+	return io->outbuf.buf!=NULL && io->outbuf.mode!=_IONBF;
+}
+
 void io_putc(struct IoConsole* io, unsigned char c)
 {
+	if (io->header.type&IO_TYPE_FILE)	// files do their own buffering
+	{
+		(*io->charout.io_putc)(io, c);
+		return;
+	}
+
+	if (c==0x1B || io->vt.state)	// an escape sequence
+	{
+		io_vt_putc(io, c);
+		return;
+	}
 
 	if (io->charout.io_putc)
 	{
@@ -55,23 +220,21 @@ void io_putc(struct IoConsole* io, unsigned char c)
 		 */
 		if (io->header.type==0)	// Stream
 		{
-			if (c==13 || c==10)	// return
-			{
-				io->header.cursor = 0;
-			}
-			else if (c==8 || c==24)	// backspace || backspace cursor
-			{
-				if (io->header.cursor > 0)
-					io->header.cursor--;
-				else
-					return;
-			}
-			else
-			{
-				io->header.cursor++;
-			}
+			if (!stream_cursor(io, c))
+				return;
+		}
+
+		if (is_buffered(io))
+		{
+			struct IoOutBuffer* ob=&io->outbuf;
+			ob->buf[ob->len++]=c;
+			if (ob->len==ob->size || (ob->mode==_IOLBF && c=='\n'))
+				io_flush(io);
+		}
+		else
+		{
+			(*io->charout.io_putc)(io, c);
 		}
-		(*io->charout.io_putc)(io, c);
 		return;
 	}
 
@@ -84,13 +247,20 @@ void io_putc(struct IoConsole* io, unsigned char c)
 		if (iow->display.cursor_visible)
 			io_setc32(iow, io->header.cursor,' ');
 		
-		io->header.cursor = io->header.cursor/iow->display.width;
-		io->header.cursor = io->header.cursor*iow->display.width;
-		io->header.cursor = io->header.cursor + iow->display.width;
+		const int row=io->header.cursor/iow->display.width;
+		if (io->vt.bottom && row==io->vt.bottom)	// the last row of a scroll region
+		{
+			io_scroll(iow, io->vt.top, io->vt.bottom, 1);
+			io->header.cursor = row*iow->display.width;
+		}
+		else
+		{
+			io->header.cursor = (row+1)*iow->display.width;
 		
-		/* if return put us on a new line that isn't a scroll, erase the line */
-		if (io->header.cursor < iow->display.size)	
-			erase_line(iow);
+			/* if return put us on a new line that isn't a scroll, erase the line */
+			if (io->header.cursor < iow->display.size)	
+				erase_line(iow);
+		}
 	}
 	else if (c==8)	// backspace
 	{
@@ -158,19 +328,12 @@ void io_putc(struct IoConsole* io, unsigned char c)
 	if (io->header.cursor == iow->display.size)	
 	{
 		io->header.cursor = iow->display.width*(iow->display.height-1);
-		for (int i=0; i < (iow->display.width*(iow->display.height-1)); i++) {
-			iow->display.video_mem[i] = iow->display.video_mem[i+iow->display.width];
-			iow->display.back_color_mem[i] = iow->display.back_color_mem[i+iow->display.width];
-			iow->display.fore_color_mem[i] = iow->display.fore_color_mem[i+iow->display.width];
-		}
-
-		for (int i=0; i < iow->display.width; i++) {
-			iow->display.video_mem[iow->display.width*iow->display.height-i-1] = ' ';
-			iow->display.back_color_mem[iow->display.width*iow->display.height-i-1] = iow->display.back_color;
-			iow->display.fore_color_mem[iow->display.width*iow->display.height-i-1] = iow->display.fore_color;
-		}
-
-		io_draw_range(iow, 0, iow->display.size-1);
+		io_scroll(iow, 0, iow->display.height-1, 1);
+	}
+	else if (io->vt.bottom && io->header.cursor == (io->vt.bottom+1)*iow->display.width)	// past the end of a scroll region
+	{
+		io->header.cursor = io->vt.bottom*iow->display.width;
+		io_scroll(iow, io->vt.top, io->vt.bottom, 1);
 	}
 
 	if (iow->display.cursor_visible)
@@ -185,9 +348,30 @@ void io_putc(struct IoConsole* io, unsigned char c)
 
 //*************************************************
 
+// the next key press waiting in io->keys (with its IO_KEY_* flags), or 0
+static int pending_key_event(struct IoConsole* io)
+{
+	while (io->keys.next < io->keys.len) {
+		const int k=io->keys.keys[io->keys.next++];
+		if (!(k&IO_KEY_UP))
+			return k;
+	}
+	return 0;
+}
+
+// the next key press waiting in io->keys (as a code point), or 0
+static int pending_key(struct IoConsole* io)
+{
+	return pending_key_event(io)&IO_KEY_CODE_MASK;
+}
+
 char io_inkey(struct IoConsole* io)
 {
-	if (io->charin.io_inkey)
+	io_flush(io);
+	const int c=pending_key(io);
+	if (c)
+		return c;
+	else if (io->charin.io_inkey)
 		return (*io->charin.io_inkey)(io);
 	else
 		return 0;
@@ -198,19 +382,77 @@ char io_inkey(struct IoConsole* io)
 // returns a unicode code point
 int io_getc32(struct IoConsole* io)
 {
+	io_flush(io);  // so that a prompt is visible
+	io_present(io);
+	const int c=pending_key(io);
+	if (c) return c;
 	return (*io->charin.io_getc32)(io);
 }
 
-// returns multibyte null terminated string from stdin using current code page (locale)
-void io_mbgetc(struct IoConsole* io, char* strout)
+// wait for at least one key event, then put every key event there is (up to n) in keys, and return the count.
+// A key event is a unicode code point, or'd with the IO_KEY_* flags.  Key releases (IO_KEY_UP) are only seen by
+// io_getkeys, not io_getc32 or io_inkey
+int io_getkeys(struct IoConsole* io, int* keys, int n)
+{
+	if (n<=0) return 0;
+
+	if (io->keys.next < io->keys.len) {
+		int count=0;
+		while (count<n && io->keys.next < io->keys.len)
+			keys[count++]=io->keys.keys[io->keys.next++];
+		return count;
+	}
+
+	io_flush(io);
+	io_present(io);
+	if (io->charin.io_getkeys)
+		return (*io->charin.io_getkeys)(io, keys, n);
+
+	keys[0]=(*io->charin.io_getc32)(io);
+	return 1;
+}
+
+// the next key press (with its IO_KEY_* flags).  When io->keys is empty, it is refilled with every key event waiting,
+// in one call
+static int next_key_event(struct IoConsole* io)
+{
+	int k;
+	while (!(k=pending_key_event(io))) {
+		if (!io->charin.io_getkeys)
+			return io_getc32(io);
+		io_flush(io);
+		io_present(io);
+		io->keys.len=(*io->charin.io_getkeys)(io, io->keys.keys, IO_KEY_BUFFER_SIZE);
+		io->keys.next=0;
+	}
+	return k;
+}
+
+// With line mode on, io_mbgets lets the JS console (twrWasmModuleAsync div or terminal canvas) edit the line:  echo,
+// backspace and history (up and down arrows) are done on the main JS thread, and the finished line is sent at once.
+// Returns false if the console can't do this (or the module is a twrWasmModule, which has no blocking input)
+bool io_set_line_mode(struct IoConsole* io, bool on)
+{
+	if (on && (!io->charin.io_begin_line || !twrLineModeAvailable()))
+		return false;
+	io->keys.line_mode=on;
+	return true;
+}
+
+static void code_point_to_mb(int code_point, char* strout)
 {
-	const int code_point = io_getc32(io);
 	int code_page = __get_current_lc_ctype_code_page(); //"C" locale is ASCII
 
 	const int len=twrUnicodeCodePointToCodePage(strout, code_point, code_page);
 	strout[len]=0;
 }
 
+// returns multibyte null terminated string from stdin using current code page (locale)
+void io_mbgetc(struct IoConsole* io, char* strout)
+{
+	code_point_to_mb(io_getc32(io), strout);
+}
+
 //*************************************************
 
 int io_chk_brk(struct IoConsole* io)
@@ -225,6 +467,7 @@ int io_chk_brk(struct IoConsole* io)
 
 void io_close(struct IoConsole* io)
 {
+	io_flush(io);
 	if (io->header.io_close)
 		io->header.io_close(io);
 }
@@ -235,16 +478,13 @@ void io_cls(struct IoConsoleWindow* iow)
 	if (iow->display.width==0 || iow->display.height==0)
 		return;
 
-	for (int i=0; i < iow->display.width*iow->display.height; i++) {
-		iow->display.video_mem[i]=' ';
-		iow->display.back_color_mem[i]=iow->display.back_color;
-		iow->display.fore_color_mem[i]=iow->display.fore_color;
-	}
+	for (int i=0; i < iow->display.size; i++)
+		set_cell(&iow->display, i, ' ');
 
 	iow->con.header.cursor = 0;
 	iow->display.cursor_visible = false;
 
-	io_draw_range(iow, 0, iow->display.size-1);
+	draw_range(iow, 0, iow->display.size-1);
 }
 
 /* accepts a byte stream encoded in the passed code_page. EG, UTF-8 */
@@ -271,9 +511,7 @@ void io_setc32(struct IoConsoleWindow* iow, int location, int c)
 	assert(iow->display.width!=0 && iow->display.height!=0 && (iow->con.header.type&IO_TYPE_WINDOW));
 	assert(location>=0 && location<iow->display.size);
 
-	iow->display.video_mem[location]=c;
-	iow->display.back_color_mem[location]=iow->display.back_color;
-	iow->display.fore_color_mem[location]=iow->display.fore_color;
+	set_cell(&iow->display, location, c);
 	
 	// draw one before and one after to fix any character rendering overlap.  Can happen with anti-aliasing on graphic chars that fill the cell
 	int start=location-1;
@@ -281,7 +519,7 @@ void io_setc32(struct IoConsoleWindow* iow, int location, int c)
 	int end=location+1;
 	if (end >= iow->display.size) end=iow->display.size-1;
 
-	iow->display.io_draw_range(iow, start, end);
+	draw_range(iow, start, end);
 }
 
 //*************************************************
@@ -297,18 +535,15 @@ bool io_setreset(struct IoConsoleWindow* iow, int x, int y, bool isset)
 	assert(x>=0 && x<iow->display.width*2);
 	assert(y>=0 && y<iow->display.height*3);
 
-	if (!((iow->display.video_mem[loc]&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER)) {
-		iow->display.video_mem[loc]= TRS80_GRAPHIC_MARKER;	/* set to a cleared graphics value */
-		iow->display.back_color_mem[loc]=iow->display.back_color;
-		iow->display.fore_color_mem[loc]=iow->display.fore_color;
-	}
+	if (!((iow->display.cells[loc].c&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER))
+		set_cell(&iow->display, loc, TRS80_GRAPHIC_MARKER);	/* set to a cleared graphics value */
 
 	if (isset)
-		iow->display.video_mem[loc]|= (1<<(celly*2+cellx));
+		iow->display.cells[loc].c|= (1<<(celly*2+cellx));
 	else
-		iow->display.video_mem[loc]&= ~(1<<(celly*2+cellx));
+		iow->display.cells[loc].c&= ~(1<<(celly*2+cellx));
 
-	io_draw_range(iow, loc, loc);
+	draw_range(iow, loc, loc);
 
 	return true;
 }
@@ -325,10 +560,10 @@ bool io_point(struct IoConsoleWindow* iow, int x, int y)
 	assert(y>=0 && y<iow->display.height*3);
 	assert(loc<iow->display.size);
 
-	if (!((iow->display.video_mem[loc]&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER))
+	if (!((iow->display.cells[loc].c&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER))
 		return false;	/* not a graphic cell, so false */
 
-	if (iow->display.video_mem[loc]&(1<<(celly*2+cellx)))
+	if (iow->display.cells[loc].c&(1<<(celly*2+cellx)))
 		return true;
 	else 
 		return false;
@@ -372,6 +607,8 @@ void io_set_colors(struct IoConsole* io, unsigned long foreground, unsigned long
 
 	iow->display.fore_color=RGB_TO_RGBA(foreground);
 	iow->display.back_color=RGB_TO_RGBA(background);
+	iow->display.fore_index=color_index(&iow->display, iow->display.fore_color);
+	iow->display.back_index=color_index(&iow->display, iow->display.back_color);
 }
 
 void io_get_colors(struct IoConsole* io, unsigned long *foreground, unsigned long *background) {
@@ -387,10 +624,148 @@ void io_get_colors(struct IoConsole* io, unsigned long *foreground, unsigned lon
 
 void io_putstr(struct IoConsole* io, const char* str)
 {
-	io_begin_draw(io);
-	for (int i=0; str[i]; i++)
-		io_putc(io, str[i]);
-	io_end_draw(io);
+	io_write(io, str, strlen(str));
+}
+
+//*************************************************
+// stdio style output buffering.  Only stream consoles (that have a charout.io_putc) are buffered.  
+// Output is sent to the driver a span at a time, via charout.io_write if the driver has one.
+
+static void write_driver(struct IoConsole* io, const char* str, int len)
+{
+	if (len<=0) return;
+
+	if (io->charout.io_write)
+		io->charout.io_write(io, str, len);
+	else
+		for (int i=0; i<len; i++)
+			io->charout.io_putc(io, str[i]);
+}
+
+// str has already been through stream_cursor()
+static void write_stream(struct IoConsole* io, const char* str, int len)
+{
+	struct IoOutBuffer* ob=&io->outbuf;
+
+	if (len<=0) return;
+
+	if (!is_buffered(io)) {
+		write_driver(io, str, len);
+		return;
+	}
+
+	if (ob->mode==_IOLBF) {  // everything up to and including the last newline goes out now
+		int nl=len-1;
+		while (nl>=0 && str[nl]!='\n') nl--;
+		if (nl>=0) {
+			if (ob->len+nl+1 <= ob->size) {
+				memcpy(ob->buf+ob->len, str, nl+1);
+				ob->len+=nl+1;
+				io_flush(io);
+			}
+			else {
+				io_flush(io);
+				write_driver(io, str, nl+1);
+			}
+			str+=nl+1;
+			len-=nl+1;
+			if (len==0) return;
+		}
+	}
+
+	if (ob->len+len > ob->size) {
+		io_flush(io);
+		if (len>=ob->size) {
+			write_driver(io, str, len);
+			return;
+		}
+	}
+
+	memcpy(ob->buf+ob->len, str, len);
+	ob->len+=len;
+	if (ob->len==ob->size)
+		io_flush(io);
+}
+
+// write len bytes.  Same as calling io_putc() for each byte, but much faster on a stream console
+void io_write(struct IoConsole* io, const char* str, int len)
+{
+	if (io->header.type&IO_TYPE_FILE) {
+		(*io->charout.io_write)(io, str, len);
+		return;
+	}
+
+	if (io->charout.io_putc==NULL || io->header.type!=0) {  // window console
+		io_begin_draw(io);
+		for (int i=0; i<len; i++)
+			io_putc(io, str[i]);
+		io_end_draw(io);
+		return;
+	}
+
+	int start=0;
+	for (int i=0; i<len; i++) {
+		if (str[i]==0x1B || io->vt.state) {  // an escape sequence isn't output as is
+			write_stream(io, str+start, i-start);
+			io_vt_putc(io, str[i]);
+			start=i+1;
+		}
+		else if (!stream_cursor(io, str[i])) {  // char is dropped
+			write_stream(io, str+start, i-start);
+			start=i+1;
+		}
+	}
+	write_stream(io, str+start, len-start);
+}
+
+// send any buffered output to the driver
+int io_flush(struct IoConsole* io)
+{
+	struct IoOutBuffer* ob=&io->outbuf;
+
+	if (ob->len>0) {
+		const int len=ob->len;
+		ob->len=0;
+		write_driver(io, ob->buf, len);
+	}
+
+	return 0;
+}
+
+// same as setvbuf().  If buf is NULL, a buffer of size bytes (BUFSIZ if size is 0) is malloc'd.  returns 0 on success
+int io_setvbuf(struct IoConsole* io, char* buf, int mode, size_t size)
+{
+	struct IoOutBuffer* ob=&io->outbuf;
+
+	if (mode!=_IOFBF && mode!=_IOLBF && mode!=_IONBF) return -1;
+	if (io->charout.io_putc==NULL || io->header.type!=0) return -1;  // window consoles are not buffered
+
+	io_flush(io);
+	if (ob->allocated) free(ob->buf);
+	ob->buf=NULL;
+	ob->size=0;
+	ob->allocated=false;
+	ob->mode=mode;
+
+	if (mode!=_IONBF) {
+		if (buf==NULL) {
+			if (size==0) size=BUFSIZ;
+			buf=malloc(size);
+			if (buf==NULL) {
+				ob->mode=_IONBF;
+				return -1;
+			}
+			ob->allocated=true;
+		}
+		else if (size==0) {
+			ob->mode=_IONBF;
+			return -1;
+		}
+		ob->buf=buf;
+		ob->size=size;
+	}
+
+	return 0;
 }
 
 //*************************************************
@@ -400,6 +775,12 @@ void io_draw_range(struct IoConsoleWindow* iow, int start, int end)
 	iow->display.io_draw_range(iow, start, end);
 }
 
+// after changing iow->display.cells start to end directly, draw them.  With double buffering, io_present() does
+void io_draw_cells(struct IoConsoleWindow* iow, int start, int end)
+{
+	draw_range(iow, start, end);
+}
+
 void io_begin_draw(struct IoConsole* io)
 {
 	if (io->header.type&IO_TYPE_WINDOW) {  // only currently supported on IoConsoleWindow
@@ -416,6 +797,169 @@ void io_end_draw(struct IoConsole* io)
 	}
 }
 
+//*************************************************
+// Double buffering.  For a full screen app that changes many cells at a time: instead of each change being drawn
+// as it is made, io_present() draws (in one draw sequence) just the cells that are different from the last present
+
+// returns false if io isn't a window console, or out of memory
+bool io_set_double_buffer(struct IoConsole* io, bool on)
+{
+	if (!(io->header.type&IO_TYPE_WINDOW))
+		return false;
+
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)io;
+
+	if (on && !iow->display.front) {
+		struct IoCell* front=malloc(iow->display.size*sizeof(struct IoCell));
+		if (front==NULL)
+			return false;
+		memcpy(front, iow->display.cells, iow->display.size*sizeof(struct IoCell));  // they have been drawn
+		iow->display.front=front;
+		iow->display.scrolled=0;
+	}
+	else if (!on && iow->display.front) {
+		io_present(io);
+		free(iow->display.front);
+		iow->display.front=NULL;
+	}
+
+	return true;
+}
+
+static inline bool same_cell(const struct IoCell* a, const struct IoCell* b)
+{
+	return a->c==b->c && a->fore==b->fore && a->back==b->back;
+}
+
+// with double buffering, move what is drawn up iow->display.scrolled rows, as cells was.  Then the uncovered rows
+// are the only ones that are different
+static void present_scroll(struct IoConsoleWindow* iow)
+{
+	struct IoCell* front=iow->display.front;
+	const int width=iow->display.width;
+	const int height=iow->display.height;
+	const int rows=iow->display.scrolled;
+
+	if (rows==0)
+		return;
+
+	int invalid_from=0;
+	if (rows < height && iow->display.io_scroll) {
+		iow->display.io_scroll(iow, 0, height-1, rows);
+		memmove(front, front+rows*width, (height-rows)*width*sizeof(struct IoCell));
+		invalid_from=(height-rows)*width;
+	}
+	for (int i=invalid_from; i < iow->display.size; i++)
+		front[i].c=CELL_INVALID;
+	iow->display.scrolled=0;
+}
+
+// move rows top to bottom (inclusive) up n rows, or down if n is negative, and blank the rows uncovered (with the
+// current colors).  What is drawn is moved with a copy (the io_scroll driver function), so only the uncovered rows
+// are drawn
+void io_scroll(struct IoConsoleWindow* iow, int top, int bottom, int n)
+{
+	const int width=iow->display.width;
+	const int height=iow->display.height;
+	struct IoCell* front=iow->display.front;
+
+	if (top<0) top=0;
+	if (bottom>=height) bottom=height-1;
+	if (top>bottom || n==0)
+		return;
+
+	const int rows=bottom-top+1;
+	if (n>rows) n=rows;
+	if (n<-rows) n=-rows;
+	const int moved=n>0 ? n : -n;
+	const int keep=(rows-moved)*width;	// cells that move
+	const int blank=(n>0 ? bottom-moved+1 : top)*width;	// the first uncovered cell
+	struct IoCell* region=iow->display.cells+top*width;
+
+	if (n>0)
+		memmove(region, region+moved*width, keep*sizeof(struct IoCell));
+	else
+		memmove(region+moved*width, region, keep*sizeof(struct IoCell));
+
+	for (int i=blank; i < blank+moved*width; i++)
+		set_cell(&iow->display, i, ' ');
+
+	if (front) {
+		// the whole screen up is left for io_present(), which can do several at once
+		if (top==0 && bottom==height-1 && n>0) {
+			iow->display.scrolled+=n;
+			if (iow->display.scrolled > height) iow->display.scrolled=height;
+			return;
+		}
+
+		// what is drawn moves now, so front (what is drawn) moves too.  If it can't, io_present() draws the region
+		if (keep>0 && iow->display.io_scroll) {
+			present_scroll(iow);	// first
+			iow->display.io_scroll(iow, top, bottom, n);
+			struct IoCell* front_region=front+top*width;
+			if (n>0)
+				memmove(front_region, front_region+moved*width, keep*sizeof(struct IoCell));
+			else
+				memmove(front_region+moved*width, front_region, keep*sizeof(struct IoCell));
+		}
+		return;
+	}
+
+	io_begin_draw((struct IoConsole*)iow);
+	if (keep>0 && iow->display.io_scroll) {
+		iow->display.io_scroll(iow, top, bottom, n);
+		iow->display.io_draw_range(iow, blank, blank+moved*width-1);
+	}
+	else {
+		iow->display.io_draw_range(iow, top*width, (bottom+1)*width-1);
+	}
+	io_end_draw((struct IoConsole*)iow);
+}
+
+// unchanged cells between two changes are drawn too, if there are fewer than this, so that there are fewer draws
+#define PRESENT_MERGE_GAP 4
+
+void io_present(struct IoConsole* io)
+{
+	if (!(io->header.type&IO_TYPE_WINDOW))
+		return;
+
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)io;
+	struct IoCell* front=iow->display.front;
+	const struct IoCell* cells=iow->display.cells;
+	const int width=iow->display.width;
+
+	if (front==NULL)
+		return;
+
+	io_begin_draw(io);
+
+	present_scroll(iow);
+
+	for (int row_start=0; row_start < iow->display.size; row_start+=width) {
+		const int row_end=row_start+width-1;
+		int i=row_start;
+		while (i <= row_end) {
+			if (same_cell(cells+i, front+i)) {
+				i++;
+				continue;
+			}
+
+			int last=i;
+			for (int j=i+1; j <= row_end && j-last <= PRESENT_MERGE_GAP; j++)
+				if (!same_cell(cells+j, front+j)) last=j;
+
+			// and one each side, as io_setc32() does, for a character that overlaps its neighbor
+			iow->display.io_draw_range(iow, i > row_start ? i-1 : i, last < row_end ? last+1 : last);
+			i=last+1;
+		}
+	}
+
+	memcpy(front, cells, iow->display.size*sizeof(struct IoCell));
+
+	io_end_draw(io);
+}
+
 //*************************************************
 
 // get a string from stdin and encodes it in the current locale's codepage
@@ -426,15 +970,25 @@ char *io_mbgets(struct IoConsole* io, char *buffer)
 
 	io_putc(io, 0xE);		/* io->header.cursor on */
 
+	// keys typed ahead are read below as usual.  Otherwise the JS console may edit the whole line.  If it doesn't
+	// (keys were typed while it was asked), the line is read and echoed here
+	bool js_line=false;
+	if (io->keys.line_mode && io->keys.next==io->keys.len) {
+		io_flush(io);
+		io_present(io);
+		js_line=(*io->charin.io_begin_line)(io);
+	}
+
 	while (true)
 	{
-		io_mbgetc(io, (char*)chrbuf);
+		const int k=next_key_event(io);  // typed ahead or pasted keys are read in one wait
+		code_point_to_mb(k&IO_KEY_CODE_MASK, (char*)chrbuf);
 		if (*chrbuf==0x1b)		// ESC key
 			return NULL;
 
-		if (!(*chrbuf==0x08 && i == 0))
-			for (int k=0; chrbuf[k]; k++)
-				io_putc(io, chrbuf[k]);
+		if (!(js_line && (k&IO_KEY_ECHOED)) && !(*chrbuf==0x08 && i == 0))
+			for (int j=0; chrbuf[j]; j++)
+				io_putc(io, chrbuf[j]);
 
 		if (*chrbuf=='\n' || *chrbuf=='\r')
 		{
@@ -453,8 +1007,8 @@ char *io_mbgets(struct IoConsole* io, char *buffer)
 		}
 		else if (*chrbuf>=0x20)
 		{
-			for (int k=0; chrbuf[k]; k++)
-				buffer[i++] = chrbuf[k];
+			for (int j=0; chrbuf[j]; j++)
+				buffer[i++] = chrbuf[j];
 		}
 	}
 }
@@ -467,7 +1021,7 @@ void io_printf(struct IoConsole *io, const char *format, ...) {
 	va_start(vlist, format);
 
 	io_begin_draw(io);
-	twr_vcbprintf((twr_vcbprintf_callback)io_putc, io, format, vlist);
+	vfprintf(io, format, vlist);
 	io_end_draw(io);
 
 	va_end(vlist);
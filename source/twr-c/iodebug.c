@@ -12,10 +12,17 @@ static void dbgputc(struct IoConsole* io, unsigned char c)
 	//twrSleep(1);  // hack to ensure msg prints to console before crash.  only works/needed on async mod.
 }
 
+static void dbgwrite(struct IoConsole* io, const char* str, int len)
+{
+	UNUSED(io);
+	twrDebugLogStr(str, len);
+}
+
+// unbuffered, since this is stderr
 static struct IoConsole io={
 	{0,0,0,0},	// header
 	{0},		// charin
-	{dbgputc}   	// charout
+	{dbgputc, dbgwrite}	// charout
 };
 
 struct IoConsole* twr_debugcon()
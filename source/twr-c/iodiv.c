@@ -1,28 +1,44 @@
+#include <stdio.h>
+#include <stdlib.h>
 #include "twr-io.h"
+#include "twr-crt.h"
 #include "twr-jsimports.h"
 
-#ifndef UNUSED
-#define UNUSED(x) (void)(x)
-#endif
-
 static void divputc(struct IoConsole* io, unsigned char c)
 {
-	UNUSED(io);
+	const int cp=__get_current_lc_ctype_code_page_modified();
+	twrDivCharOut(io->header.handle, c, cp);
+}
 
+static void divwrite(struct IoConsole* io, const char* str, int len)
+{
 	const int cp=__get_current_lc_ctype_code_page_modified();
-	twrDivCharOut(c, cp);
+	twrDivStrOut(io->header.handle, str, len, cp);
 }
 
 static int divgetc(struct IoConsole* io)
 {
-	UNUSED(io);
-	return twrDivCharIn();
+	return twrDivCharIn(io->header.handle);
 }
 
+static int divgetkeys(struct IoConsole* io, int* keys, int n)
+{
+	return twrDivKeysIn(io->header.handle, keys, n);
+}
+
+static bool divbeginline(struct IoConsole* io)
+{
+	return twrDivLineBegin(io->header.handle);
+}
+
+static char outbuf[BUFSIZ];
+
+// div 0 is <div id="twr_iodiv">
 static struct IoConsole io={
-	{0,0,0,0},	// header
-	{divgetc}, 	// charin
-	{divputc}   	// charout
+	{0,0,0,0,0},	// header
+	{divgetc, NULL, divgetkeys, divbeginline}, 	// charin
+	{divputc, divwrite},	// charout
+	{_IOLBF, sizeof(outbuf), 0, outbuf, false}	// outbuf -- stdout is line buffered
 };
 
 struct IoConsole* twr_divcon()
@@ -30,5 +46,36 @@ struct IoConsole* twr_divcon()
 	return &io;
 }
 
+//*************************************************
 
+static void divclose(struct IoConsole* con)
+{
+	io_setvbuf(con, NULL, _IONBF, 0);	// frees the buffer
+	free(con);
+}
+
+// a console for another div (a handle from twr_get_div).  io_close() frees it.  returns NULL if out of memory, or
+// if div is -1 (twr_get_div didn't find the div)
+struct IoConsole* twr_new_divcon(int div)
+{
+	if (div<0)
+		return NULL;
+
+	struct IoConsole* con=calloc(1, sizeof(struct IoConsole));
+	if (con==NULL)
+		return NULL;
 
+	con->header.handle=div;
+	con->header.io_close=divclose;
+	con->charin=io.charin;
+	con->charout=io.charout;
+	io_setvbuf(con, NULL, _IOLBF, 0);
+
+	return con;
+}
+
+/* the handle of <div id=element_id>, or -1 if the module has no such div.  see twrWasmModuleInJSMain.divs */
+int twr_get_div(const char* element_id)
+{
+	return twrDivGetHandle(element_id);
+}
@@ -0,0 +1,519 @@
+#include <stdlib.h>
+#include <string.h>
+#include "twr-io.h"
+
+/*
+ * VT100/xterm escape sequences, for io_putc().
+ *
+ * The parser is a state machine with a table (vt_table) of what to do with each class of byte in each state.  A
+ * sequence changes nothing until its final byte.  Then it is applied at once, in one draw batch.
+ *
+ * Window consoles support cursor movement, erase, insert and delete, scroll regions (scrolled with a copy of the
+ * canvas, see io_scroll), and SGR colors (16, 256 and 24 bit), which are set with io_set_colors().
+ * Stream consoles (eg, the div) only support erasing the whole screen (sent as a form feed) and showing or hiding the
+ * cursor.  Other sequences are removed from the output.
+ */
+
+enum {
+	VT_GROUND,
+	VT_ESCAPE,
+	VT_ESCAPE_INTERMEDIATE,
+	VT_CSI_PARAM,
+	VT_CSI_INTERMEDIATE,
+	VT_CSI_IGNORE,
+	VT_OSC,
+	VT_OSC_ESCAPE,
+	VT_NUM_STATES
+};
+
+/* byte classes */
+enum {
+	VC_C0,		// 0x00-0x1F except these
+	VC_BEL,		// 0x07
+	VC_CANCEL,	// 0x18, 0x1A
+	VC_ESC,		// 0x1B
+	VC_INTER,	// 0x20-0x2F
+	VC_DIGIT,	// 0x30-0x39
+	VC_SEP,		// ':' ';'
+	VC_PRIVATE,	// 0x3C-0x3F
+	VC_CSI,		// '['
+	VC_ST,		// '\'
+	VC_OSC,		// ']'
+	VC_FINAL,	// 0x40-0x7E except these
+	VC_DEL,		// 0x7F
+	VC_HIGH,		// 0x80-0xFF
+	VC_NUM_CLASSES
+};
+
+/* actions */
+enum {
+	VA_NONE,
+	VA_CLEAR,		// start a sequence
+	VA_COLLECT,		// an intermediate byte
+	VA_PARAM,		// a digit or separator
+	VA_PRIVATE,		// a private marker ('?' etc)
+	VA_ESC_DISPATCH,
+	VA_CSI_DISPATCH,
+};
+
+#define T(action, state) ((action)<<4 | (state))
+
+static const unsigned char vt_table[VT_NUM_STATES][VC_NUM_CLASSES] = {
+	[VT_GROUND] = {
+		// bytes other than ESC aren't given to the parser in the ground state
+		[VC_ESC]=T(VA_CLEAR, VT_ESCAPE),
+	},
+	[VT_ESCAPE] = {
+		[VC_C0]=T(VA_NONE, VT_ESCAPE), [VC_BEL]=T(VA_NONE, VT_ESCAPE), [VC_CANCEL]=T(VA_NONE, VT_GROUND),
+		[VC_ESC]=T(VA_CLEAR, VT_ESCAPE), [VC_INTER]=T(VA_COLLECT, VT_ESCAPE_INTERMEDIATE),
+		[VC_DIGIT]=T(VA_ESC_DISPATCH, VT_GROUND), [VC_SEP]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_PRIVATE]=T(VA_ESC_DISPATCH, VT_GROUND), [VC_CSI]=T(VA_CLEAR, VT_CSI_PARAM),
+		[VC_ST]=T(VA_NONE, VT_GROUND), [VC_OSC]=T(VA_NONE, VT_OSC), [VC_FINAL]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_DEL]=T(VA_NONE, VT_ESCAPE), [VC_HIGH]=T(VA_NONE, VT_GROUND),
+	},
+	[VT_ESCAPE_INTERMEDIATE] = {
+		[VC_C0]=T(VA_NONE, VT_ESCAPE_INTERMEDIATE), [VC_BEL]=T(VA_NONE, VT_ESCAPE_INTERMEDIATE),
+		[VC_CANCEL]=T(VA_NONE, VT_GROUND), [VC_ESC]=T(VA_CLEAR, VT_ESCAPE),
+		[VC_INTER]=T(VA_COLLECT, VT_ESCAPE_INTERMEDIATE), [VC_DIGIT]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_SEP]=T(VA_ESC_DISPATCH, VT_GROUND), [VC_PRIVATE]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_CSI]=T(VA_ESC_DISPATCH, VT_GROUND), [VC_ST]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_OSC]=T(VA_ESC_DISPATCH, VT_GROUND), [VC_FINAL]=T(VA_ESC_DISPATCH, VT_GROUND),
+		[VC_DEL]=T(VA_NONE, VT_ESCAPE_INTERMEDIATE), [VC_HIGH]=T(VA_NONE, VT_GROUND),
+	},
+	[VT_CSI_PARAM] = {
+		[VC_C0]=T(VA_NONE, VT_CSI_PARAM), [VC_BEL]=T(VA_NONE, VT_CSI_PARAM), [VC_CANCEL]=T(VA_NONE, VT_GROUND),
+		[VC_ESC]=T(VA_CLEAR, VT_ESCAPE), [VC_INTER]=T(VA_COLLECT, VT_CSI_INTERMEDIATE),
+		[VC_DIGIT]=T(VA_PARAM, VT_CSI_PARAM), [VC_SEP]=T(VA_PARAM, VT_CSI_PARAM),
+		[VC_PRIVATE]=T(VA_PRIVATE, VT_CSI_PARAM), [VC_CSI]=T(VA_CSI_DISPATCH, VT_GROUND),
+		[VC_ST]=T(VA_CSI_DISPATCH, VT_GROUND), [VC_OSC]=T(VA_CSI_DISPATCH, VT_GROUND),
+		[VC_FINAL]=T(VA_CSI_DISPATCH, VT_GROUND), [VC_DEL]=T(VA_NONE, VT_CSI_PARAM), [VC_HIGH]=T(VA_NONE, VT_GROUND),
+	},
+	[VT_CSI_INTERMEDIATE] = {
+		[VC_C0]=T(VA_NONE, VT_CSI_INTERMEDIATE), [VC_BEL]=T(VA_NONE, VT_CSI_INTERMEDIATE),
+		[VC_CANCEL]=T(VA_NONE, VT_GROUND), [VC_ESC]=T(VA_CLEAR, VT_ESCAPE),
+		[VC_INTER]=T(VA_COLLECT, VT_CSI_INTERMEDIATE), [VC_DIGIT]=T(VA_NONE, VT_CSI_IGNORE),
+		[VC_SEP]=T(VA_NONE, VT_CSI_IGNORE), [VC_PRIVATE]=T(VA_NONE, VT_CSI_IGNORE),
+		[VC_CSI]=T(VA_CSI_DISPATCH, VT_GROUND), [VC_ST]=T(VA_CSI_DISPATCH, VT_GROUND),
+		[VC_OSC]=T(VA_CSI_DISPATCH, VT_GROUND), [VC_FINAL]=T(VA_CSI_DISPATCH, VT_GROUND),
+		[VC_DEL]=T(VA_NONE, VT_CSI_INTERMEDIATE), [VC_HIGH]=T(VA_NONE, VT_GROUND),
+	},
+	[VT_CSI_IGNORE] = {
+		[VC_C0]=T(VA_NONE, VT_CSI_IGNORE), [VC_BEL]=T(VA_NONE, VT_CSI_IGNORE), [VC_CANCEL]=T(VA_NONE, VT_GROUND),
+		[VC_ESC]=T(VA_CLEAR, VT_ESCAPE), [VC_INTER]=T(VA_NONE, VT_CSI_IGNORE), [VC_DIGIT]=T(VA_NONE, VT_CSI_IGNORE),
+		[VC_SEP]=T(VA_NONE, VT_CSI_IGNORE), [VC_PRIVATE]=T(VA_NONE, VT_CSI_IGNORE), [VC_CSI]=T(VA_NONE, VT_GROUND),
+		[VC_ST]=T(VA_NONE, VT_GROUND), [VC_OSC]=T(VA_NONE, VT_GROUND), [VC_FINAL]=T(VA_NONE, VT_GROUND),
+		[VC_DEL]=T(VA_NONE, VT_CSI_IGNORE), [VC_HIGH]=T(VA_NONE, VT_GROUND),
+	},
+	[VT_OSC] = {  // an OSC string (eg, a window title) is ignored.  It ends with BEL or ESC backslash
+		[VC_C0]=T(VA_NONE, VT_OSC), [VC_BEL]=T(VA_NONE, VT_GROUND), [VC_CANCEL]=T(VA_NONE, VT_GROUND),
+		[VC_ESC]=T(VA_NONE, VT_OSC_ESCAPE), [VC_INTER]=T(VA_NONE, VT_OSC), [VC_DIGIT]=T(VA_NONE, VT_OSC),
+		[VC_SEP]=T(VA_NONE, VT_OSC), [VC_PRIVATE]=T(VA_NONE, VT_OSC), [VC_CSI]=T(VA_NONE, VT_OSC),
+		[VC_ST]=T(VA_NONE, VT_OSC), [VC_OSC]=T(VA_NONE, VT_OSC), [VC_FINAL]=T(VA_NONE, VT_OSC),
+		[VC_DEL]=T(VA_NONE, VT_OSC), [VC_HIGH]=T(VA_NONE, VT_OSC),
+	},
+	[VT_OSC_ESCAPE] = {  // (anything but ESC ends the string.  Only backslash is valid)
+		[VC_ESC]=T(VA_NONE, VT_OSC_ESCAPE),
+	},
+};
+
+static inline int byte_class(unsigned char c)
+{
+	if (c>=0x80) return VC_HIGH;
+	if (c==0x7F) return VC_DEL;
+	if (c<0x20) {
+		if (c==0x07) return VC_BEL;
+		if (c==0x18 || c==0x1A) return VC_CANCEL;
+		if (c==0x1B) return VC_ESC;
+		return VC_C0;
+	}
+	if (c<0x30) return VC_INTER;
+	if (c<0x3A) return VC_DIGIT;
+	if (c<0x3C) return VC_SEP;
+	if (c<0x40) return VC_PRIVATE;
+	if (c=='[') return VC_CSI;
+	if (c=='\\') return VC_ST;
+	if (c==']') return VC_OSC;
+	return VC_FINAL;
+}
+
+//*************************************************
+
+// parameter i, or dflt if it is missing or zero
+static inline int param(struct IoVT* vt, int i, int dflt)
+{
+	return (i<vt->nparams && vt->params[i]>0) ? vt->params[i] : dflt;
+}
+
+/* xterm's 256 color palette */
+static unsigned long palette_rgb(int i)
+{
+	static const unsigned long ansi[16]={
+		0x000000, 0xCD0000, 0x00CD00, 0xCDCD00, 0x0000EE, 0xCD00CD, 0x00CDCD, 0xE5E5E5,
+		0x7F7F7F, 0xFF0000, 0x00FF00, 0xFFFF00, 0x5C5CFF, 0xFF00FF, 0x00FFFF, 0xFFFFFF
+	};
+
+	if (i<16) return ansi[i];
+	if (i<232) {  // 6x6x6 cube
+		static const unsigned char level[6]={0, 95, 135, 175, 215, 255};
+		i-=16;
+		return (unsigned long)level[i/36]<<16 | level[(i/6)%6]<<8 | level[i%6];
+	}
+	const unsigned long gray=8+(i-232)*10;
+	return gray<<16 | gray<<8 | gray;
+}
+
+static unsigned long color_rgb(int color, unsigned long dflt)
+{
+	if (color<0) return dflt;
+	if (color&IO_VT_RGB) return color&0xFFFFFF;
+	return palette_rgb(color);
+}
+
+static void apply_colors(struct IoConsole* io)
+{
+	struct IoVT* vt=&io->vt;
+	const int fore=(vt->bold && vt->fore>=0 && vt->fore<8) ? vt->fore+8 : vt->fore;  // bold is bright
+	unsigned long f=color_rgb(fore, vt->default_fore);
+	unsigned long b=color_rgb(vt->back, vt->default_back);
+
+	if (vt->reverse) {
+		const unsigned long t=f;
+		f=b;
+		b=t;
+	}
+
+	io_set_colors(io, f, b);
+
+	// the next SGR starts from the colors then (io_set_colors may have been called in between)
+	if (vt->fore<0 && vt->back<0 && !vt->bold && !vt->reverse)
+		vt->colors_saved=false;
+}
+
+// 38;5;n or 38;2;r;g;b (and 48 for the background).  i is the index of the 5 or 2.  returns the params used
+static int extended_color(struct IoVT* vt, int i, int* color)
+{
+	if (i<vt->nparams && vt->params[i]==5 && i+1<vt->nparams) {
+		*color=vt->params[i+1]&255;
+		return 2;
+	}
+	if (i<vt->nparams && vt->params[i]==2 && i+3<vt->nparams) {
+		*color=IO_VT_RGB | (vt->params[i+1]&255)<<16 | (vt->params[i+2]&255)<<8 | (vt->params[i+3]&255);
+		return 4;
+	}
+	return vt->nparams-i;  // malformed.  ignore the rest
+}
+
+static void sgr(struct IoConsole* io)
+{
+	struct IoVT* vt=&io->vt;
+
+	if (!vt->colors_saved) {
+		io_get_colors(io, &vt->default_fore, &vt->default_back);
+		vt->colors_saved=true;
+	}
+
+	if (vt->nparams==0)
+		vt->nparams=1;	// (params[0] is 0)
+
+	for (int i=0; i<vt->nparams; i++) {
+		const int p=vt->params[i];
+		if (p==0) {
+			vt->fore=vt->back=-1;
+			vt->bold=vt->reverse=false;
+		}
+		else if (p==1) vt->bold=true;
+		else if (p==22) vt->bold=false;
+		else if (p==7) vt->reverse=true;
+		else if (p==27) vt->reverse=false;
+		else if (p>=30 && p<=37) vt->fore=p-30;
+		else if (p==38) i+=extended_color(vt, i+1, &vt->fore);
+		else if (p==39) vt->fore=-1;
+		else if (p>=40 && p<=47) vt->back=p-40;
+		else if (p==48) i+=extended_color(vt, i+1, &vt->back);
+		else if (p==49) vt->back=-1;
+		else if (p>=90 && p<=97) vt->fore=p-90+8;
+		else if (p>=100 && p<=107) vt->back=p-100+8;
+		// others (italic, underline, blink, ...) aren't supported
+	}
+
+	apply_colors(io);
+}
+
+//*************************************************
+
+// blank cells start to end (inclusive), with the current colors, without drawing them
+static void blank(struct IoConsoleWindow* iow, int start, int end)
+{
+	for (int i=start; i<=end; i++) {
+		iow->display.cells[i].c=' ';
+		iow->display.cells[i].fore=iow->display.fore_index;
+		iow->display.cells[i].back=iow->display.back_index;
+	}
+}
+
+static void erase(struct IoConsoleWindow* iow, int start, int end)
+{
+	if (start<0) start=0;
+	if (end>=iow->display.size) end=iow->display.size-1;
+	if (start>end) return;
+
+	blank(iow, start, end);
+	io_draw_cells(iow, start, end);
+}
+
+// insert (n>0) or delete (n<0) blank cells at the cursor, moving the rest of the line right or left
+static void shift_line(struct IoConsoleWindow* iow, int n)
+{
+	const int cursor=iow->con.header.cursor;
+	const int line_end=(cursor/iow->display.width+1)*iow->display.width;  // one past
+	struct IoCell* cells=iow->display.cells;
+	const int moved=n>0 ? n : -n;
+
+	if (moved >= line_end-cursor) {
+		erase(iow, cursor, line_end-1);
+		return;
+	}
+
+	if (n>0) {
+		memmove(cells+cursor+moved, cells+cursor, (line_end-cursor-moved)*sizeof(struct IoCell));
+		blank(iow, cursor, cursor+moved-1);
+	}
+	else {
+		memmove(cells+cursor, cells+cursor+moved, (line_end-cursor-moved)*sizeof(struct IoCell));
+		blank(iow, line_end-moved, line_end-1);
+	}
+	io_draw_cells(iow, cursor, line_end-1);
+}
+
+// the rows a line feed, insert line, etc. act in:  the scroll region, or the screen
+static void region(struct IoConsoleWindow* iow, int* top, int* bottom)
+{
+	if (iow->con.vt.bottom) {
+		*top=iow->con.vt.top;
+		*bottom=iow->con.vt.bottom;
+	}
+	else {
+		*top=0;
+		*bottom=iow->display.height-1;
+	}
+}
+
+static void set_cursor(struct IoConsoleWindow* iow, int x, int y)
+{
+	if (x<0) x=0;
+	if (x>=iow->display.width) x=iow->display.width-1;
+	if (y<0) y=0;
+	if (y>=iow->display.height) y=iow->display.height-1;
+	iow->con.header.cursor=y*iow->display.width+x;
+}
+
+static void reset(struct IoConsoleWindow* iow)
+{
+	struct IoVT* vt=&iow->con.vt;
+	vt->fore=vt->back=-1;
+	vt->bold=vt->reverse=false;
+	if (vt->colors_saved)
+		apply_colors(&iow->con);
+	vt->top=vt->bottom=0;
+	vt->saved_cursor=0;
+	io_cls(iow);
+}
+
+static void window_esc_dispatch(struct IoConsoleWindow* iow, unsigned char c)
+{
+	struct IoVT* vt=&iow->con.vt;
+	const int width=iow->display.width;
+	const int x=iow->con.header.cursor%width;
+	const int y=iow->con.header.cursor/width;
+	int top, bottom;
+	region(iow, &top, &bottom);
+
+	if (vt->intermediate)  // character set selection, etc
+		return;
+
+	switch (c) {
+		case '7':	vt->saved_cursor=iow->con.header.cursor; break;
+		case '8':	iow->con.header.cursor=vt->saved_cursor; break;
+		case 'D':	// index (line feed, without the carriage return)
+			if (y==bottom) io_scroll(iow, top, bottom, 1);
+			else set_cursor(iow, x, y+1);
+			break;
+		case 'M':	// reverse index
+			if (y==top) io_scroll(iow, top, bottom, -1);
+			else set_cursor(iow, x, y-1);
+			break;
+		case 'E':	// next line
+			if (y==bottom) io_scroll(iow, top, bottom, 1);
+			else set_cursor(iow, 0, y+1);
+			break;
+		case 'c':	reset(iow); break;
+	}
+}
+
+static void window_csi_dispatch(struct IoConsoleWindow* iow, unsigned char c)
+{
+	struct IoVT* vt=&iow->con.vt;
+	const int width=iow->display.width;
+	const int height=iow->display.height;
+	const int cursor=iow->con.header.cursor;
+	const int x=cursor%width;
+	const int y=cursor/width;
+	int top, bottom;
+	region(iow, &top, &bottom);
+
+	if (vt->private_marker) {
+		if (vt->private_marker=='?' && param(vt, 0, 0)==25 && (c=='h' || c=='l'))  // show or hide the cursor
+			iow->display.cursor_visible=(c=='h');
+		return;
+	}
+
+	if (vt->intermediate)
+		return;
+
+	switch (c) {
+		case 'A':	set_cursor(iow, x, y-param(vt, 0, 1)); break;
+		case 'B':	set_cursor(iow, x, y+param(vt, 0, 1)); break;
+		case 'C':	set_cursor(iow, x+param(vt, 0, 1), y); break;
+		case 'D':	set_cursor(iow, x-param(vt, 0, 1), y); break;
+		case 'E':	set_cursor(iow, 0, y+param(vt, 0, 1)); break;
+		case 'F':	set_cursor(iow, 0, y-param(vt, 0, 1)); break;
+		case 'G':
+		case '`':	set_cursor(iow, param(vt, 0, 1)-1, y); break;
+		case 'd':	set_cursor(iow, x, param(vt, 0, 1)-1); break;
+		case 'H':
+		case 'f':	set_cursor(iow, param(vt, 1, 1)-1, param(vt, 0, 1)-1); break;
+
+		case 'J':	// erase in display
+			switch (param(vt, 0, 0)) {
+				case 0:	erase(iow, cursor, iow->display.size-1); break;
+				case 1:	erase(iow, 0, cursor); break;
+				case 2:
+				case 3:	erase(iow, 0, iow->display.size-1); break;
+			}
+			break;
+
+		case 'K':	// erase in line
+			switch (param(vt, 0, 0)) {
+				case 0:	erase(iow, cursor, (y+1)*width-1); break;
+				case 1:	erase(iow, y*width, cursor); break;
+				case 2:	erase(iow, y*width, (y+1)*width-1); break;
+			}
+			break;
+
+		case 'X':	erase(iow, cursor, cursor+param(vt, 0, 1)-1 < (y+1)*width-1 ? cursor+param(vt, 0, 1)-1 : (y+1)*width-1); break;
+		case '@':	shift_line(iow, param(vt, 0, 1)); break;
+		case 'P':	shift_line(iow, -param(vt, 0, 1)); break;
+
+		case 'L':	// insert lines, in the scroll region
+		case 'M':	// delete lines
+			if (y>=top && y<=bottom) {
+				io_scroll(iow, y, bottom, c=='L' ? -param(vt, 0, 1) : param(vt, 0, 1));
+				iow->con.header.cursor=y*width;
+			}
+			break;
+
+		case 'S':	io_scroll(iow, top, bottom, param(vt, 0, 1)); break;
+		case 'T':	io_scroll(iow, top, bottom, -param(vt, 0, 1)); break;
+
+		case 'r':	// set the scroll region
+		{
+			const int t=param(vt, 0, 1)-1;
+			const int b=param(vt, 1, height)-1;
+			if (t<b && b<height) {
+				vt->top=t;
+				vt->bottom=(t==0 && b==height-1) ? 0 : b;  // the whole screen is the same as no region
+				iow->con.header.cursor=0;
+			}
+			break;
+		}
+
+		case 's':	vt->saved_cursor=cursor; break;
+		case 'u':	iow->con.header.cursor=vt->saved_cursor; break;
+		case 'm':	sgr(&iow->con); break;
+	}
+}
+
+// a stream console can only clear the screen (a form feed), and show or hide the cursor (0xE, 0xF), which the div
+// console handles
+static void stream_csi_dispatch(struct IoConsole* io, unsigned char c)
+{
+	struct IoVT* vt=&io->vt;
+	if (vt->intermediate)
+		return;
+	if (!vt->private_marker && c=='J' && param(vt, 0, 0)>=2)
+		io_putc(io, '\f');
+	else if (vt->private_marker=='?' && param(vt, 0, 0)==25 && (c=='h' || c=='l'))
+		io_putc(io, c=='h' ? 0xE : 0xF);
+}
+
+static void dispatch(struct IoConsole* io, unsigned char c, int action)
+{
+	if (!(io->header.type&IO_TYPE_WINDOW)) {
+		if (action==VA_CSI_DISPATCH)
+			stream_csi_dispatch(io, c);
+		return;
+	}
+
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)io;
+	const bool cursor_visible=iow->display.cursor_visible;
+
+	io_begin_draw(io);
+
+	// the cursor is drawn as a cell (see io_putc)
+	if (cursor_visible)
+		io_setc32(iow, io->header.cursor, ' ');
+
+	if (action==VA_ESC_DISPATCH)
+		window_esc_dispatch(iow, c);
+	else
+		window_csi_dispatch(iow, c);
+
+	if (iow->display.cursor_visible)
+		io_setc32(iow, io->header.cursor, 9611);
+
+	io_end_draw(io);
+}
+
+// c is the next byte of an escape sequence (or the ESC that starts one)
+void io_vt_putc(struct IoConsole* io, unsigned char c)
+{
+	struct IoVT* vt=&io->vt;
+	const unsigned char t=vt_table[vt->state][byte_class(c)];
+	const int action=t>>4;
+
+	vt->state=t&15;
+
+	switch (action) {
+		case VA_CLEAR:
+			vt->private_marker=0;
+			vt->intermediate=0;
+			vt->nparams=0;
+			vt->params[0]=0;
+			break;
+
+		case VA_COLLECT:
+			vt->intermediate=c;
+			break;
+
+		case VA_PRIVATE:
+			if (vt->nparams==0) vt->private_marker=c;
+			else vt->state=VT_CSI_IGNORE;
+			break;
+
+		case VA_PARAM:
+			if (vt->nparams==0) vt->nparams=1;
+			if (c==';' || c==':') {
+				if (vt->nparams<IO_VT_MAX_PARAMS) vt->params[vt->nparams++]=0;
+			}
+			else {
+				int* p=&vt->params[vt->nparams-1];
+				if (*p<10000) *p=*p*10+(c-'0');
+			}
+			break;
+
+		case VA_ESC_DISPATCH:
+		case VA_CSI_DISPATCH:
+			dispatch(io, c, action);
+			break;
+	}
+}
@@ -5,90 +5,100 @@
 #include "twr-draw2d.h"
 #include "twr-jsimports.h"
 
-#ifndef UNUSED
-#define UNUSED(x) (void)(x)
-#endif
-
 
 static int wingetc(struct IoConsole* io)
 {
-	UNUSED(io);
-	return twrCanvasCharIn();
+	return twrCanvasCharIn(io->header.handle);
 }
 
 static char wininkey(struct IoConsole* io)
 {
-	UNUSED(io);
-	return twrCanvasInkey();
+	return twrCanvasInkey(io->header.handle);
 }
 
-//**************************************************
-
-static void draw_trs80_graphic(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int offset, cellsize_t val, unsigned long fgc, unsigned long bgc)
+static int wingetkeys(struct IoConsole* io, int* keys, int n)
 {
-	int x, y;
+	return twrCanvasKeysIn(io->header.handle, keys, n);
+}
 
-	x = (offset%iow->display.width)*iow->display.my_cx;
-	y = (offset/iow->display.width)*iow->display.my_cy;
+static bool winbeginline(struct IoConsole* io)
+{
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)io;
+	return twrCanvasLineBegin(io->header.handle, io->header.cursor, iow->display.fore_color, iow->display.back_color);
+}
 
-	d2d_setfillstylergba(ds, bgc);
-	d2d_fillrect(ds, x, y, iow->display.my_cx, iow->display.my_cy);
+//**************************************************
 
-	if (val == 32)
+// the foreground of a TRS-80 graphic cell (the background is drawn with its row).  One instruction, that the
+// canvas can draw as a single glyph atlas tile
+static void draw_trs80_graphic(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int offset, unsigned long val, unsigned long fgc)
+{
+	if (val == 0)
 		return;
 
 	d2d_setfillstylergba(ds, fgc);
+	d2d_fillblocks(ds, val, (offset%iow->display.width)*iow->display.my_cx, (offset/iow->display.width)*iow->display.my_cy,
+		iow->display.my_cx, iow->display.my_cy);
+} 
 
-	if (val&1)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w1, iow->display.my_cell_h1);
-
-	y=y+iow->display.my_cell_h1;
-
-	if (val&4)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w1, iow->display.my_cell_h2);
-
-	y=y+iow->display.my_cell_h2;
-
-	if (val&16)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w1, iow->display.my_cell_h3);
-
-	x=x+iow->display.my_cell_w1;
-
-	if (val&32)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w2, iow->display.my_cell_h3);
-
-	y=y-iow->display.my_cell_h2;
-
-	if (val&8)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w2, iow->display.my_cell_h2);
-
-	y=y-iow->display.my_cell_h1;
+//**************************************************
 
-	if (val&2)
-		d2d_fillrect(ds, x, y, iow->display.my_cell_w2, iow->display.my_cell_h1);
+#define is_graphic(value) (((value)&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER)
 
-} 
+// text cells that can be drawn together, with one fillText.  Courier New has these (and its advance is fixed), so they
+// don't fall back to another font that might have a different width
+#define in_text_run(value) ((value)<0x250)
 
-//**************************************************
+// the most cells in one d2d_fillcodepoints
+#define TEXT_RUN_MAX 128
 
-static void draw_cell(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int offset, cellsize_t value, unsigned long fgc, unsigned long bgc)
+// cells start to end, all in one row.  Each run of cells with the same background is one fillrect, and each run of
+// text with the same foreground (spaces in it can have any foreground) is one d2d_fillcodepoints
+static void draw_row(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int start, int end)
 {
-	if ( (value&TRS80_GRAPHIC_MARKER_MASK)==TRS80_GRAPHIC_MARKER || value==32)
-	{
-		draw_trs80_graphic(iow, ds, offset, value&TRS80_GRAPHIC_CHAR_MASK, fgc, bgc);
+	const struct IoCell* cells=iow->display.cells;
+	const unsigned long* palette=iow->display.palette;
+	const int cx=iow->display.my_cx;
+	const int x0=(start%iow->display.width)*cx;
+	const int y=(start/iow->display.width)*iow->display.my_cy;
+
+	for (int i=start; i <= end; ) {
+		int j=i+1;
+		while (j <= end && cells[j].back==cells[i].back)
+			j++;
+		d2d_setfillstylergba(ds, palette[cells[i].back]);
+		d2d_fillrect(ds, x0+(i-start)*cx, y, (j-i)*cx, iow->display.my_cy);
+		i=j;
 	}
-	else
-	{
-		int x, y;
-
-		x = (offset%iow->display.width)*iow->display.my_cx;
-		y = (offset/iow->display.width)*iow->display.my_cy;
-
-		d2d_setfillstylergba(ds, bgc);
-		d2d_fillrect(ds, x, y, iow->display.my_cx, iow->display.my_cy);
-		if (value!=32) {
-			d2d_setfillstylergba(ds, fgc);
-			d2d_fillcodepoint(ds, value, x, y);
+
+	for (int i=start; i <= end; ) {
+		const unsigned long value=cells[i].c;
+
+		if (is_graphic(value)) {
+			draw_trs80_graphic(iow, ds, i, value&TRS80_GRAPHIC_CHAR_MASK, palette[cells[i].fore]);
+			i++;
+		}
+		else if (value==32) {
+			i++;
+		}
+		else {
+			int last=i;
+			if (in_text_run(value)) {
+				for (int j=i+1; j <= end && j-i < TEXT_RUN_MAX && in_text_run(cells[j].c) && (cells[j].c==32 || cells[j].fore==cells[i].fore); j++)
+					if (cells[j].c!=32) last=j;
+			}
+
+			d2d_setfillstylergba(ds, palette[cells[i].fore]);
+			if (last==i) {
+				d2d_fillcodepoint(ds, value, x0+(i-start)*cx, y);
+			}
+			else {
+				unsigned long run[TEXT_RUN_MAX];
+				for (int j=i; j <= last; j++)
+					run[j-i]=cells[j].c;
+				d2d_fillcodepoints(ds, run, last-i+1, x0+(i-start)*cx, y, cx);
+			}
+			i=last+1;
 		}
 	}
 }
@@ -98,10 +108,11 @@ static void draw_cell(struct IoConsoleWindow* iow, struct d2d_draw_seq* ds, int
 //!!!!!! CHANGE THIS AND WINDOWS VERSION TO USE A (to be created) CANVAS DRIVER
 //!!!! move this to io.c
 
+// the draw sequence is kept from one draw to the next, so that its buffer is reused
 static void beginDrawRange(struct IoConsoleWindow* iow) {
 
-	if (iow->display.nest_level==0)
-		iow->display.ds=d2d_start_draw_sequence(500);
+	if (iow->display.ds==NULL)
+		iow->display.ds=d2d_start_draw_sequence_on(iow->con.header.handle, 500);
 
 	iow->display.nest_level++;
 }
@@ -110,20 +121,37 @@ static void endDrawRange(struct IoConsoleWindow* iow) {
 	iow->display.nest_level--;
 	assert(iow->display.nest_level>=0);
 	if (iow->display.nest_level==0) 
-		d2d_end_draw_sequence(iow->display.ds);
+		d2d_flush(iow->display.ds);
 }
 
 static void drawRange(struct IoConsoleWindow* iow, int start, int end)
 {
 	beginDrawRange(iow);
 
-	for (int i=start; i <= end; i++) {
-		draw_cell(iow, iow->display.ds, i, iow->display.video_mem[i], iow->display.fore_color_mem[i], iow->display.back_color_mem[i] );
+	while (start <= end) {
+		const int row_end=(start/iow->display.width+1)*iow->display.width-1;
+		draw_row(iow, iow->display.ds, start, row_end < end ? row_end : end);
+		start=row_end+1;
 	}
 
 	endDrawRange(iow);
 }
 
+// move rows top to bottom up n rows (down if n<0), with one copy of the canvas
+static void scrollRows(struct IoConsoleWindow* iow, int top, int bottom, int n)
+{
+	const int rows=bottom-top+1;
+	const int moved=n>0 ? n : -n;
+	if (moved==0 || moved >= rows)
+		return;
+
+	const int src=n>0 ? top+moved : top;
+	const int dest=n>0 ? top : top+moved;
+	beginDrawRange(iow);
+	d2d_copyrect(iow->display.ds, 0, src*iow->display.my_cy, iow->display.width*iow->display.my_cx, (rows-moved)*iow->display.my_cy, 0, dest*iow->display.my_cy);
+	endDrawRange(iow);
+}
+
 //*************************************************
 
 
@@ -131,61 +159,109 @@ static void drawRange(struct IoConsoleWindow* iow, int start, int end)
 //	void (*io_close)  (struct IoConsole*);
 //	int  (*io_chk_brk)(struct IoConsole*);
 
-struct IoConsole* twr_windowcon()
+// iow is zeroed.  returns false if out of memory
+static bool init_windowcon(struct IoConsoleWindow* iow, int canvas)
 {
-	static struct IoConsoleWindow iow;
-
-	const int width=d2d_get_canvas_prop("widthInChars");
-	const int height=d2d_get_canvas_prop("heightInChars");
+	const int width=d2d_get_canvas_prop_on(canvas, "widthInChars");
+	const int height=d2d_get_canvas_prop_on(canvas, "heightInChars");
 	const int size=width*height;
 
 	assert(width>0);
 	assert(height>0);
-	assert(iow.con.header.type==0);  // twr_windowcon() function can only be called once
-
-	iow.display.video_mem=malloc(size*sizeof(cellsize_t));
-	iow.display.fore_color_mem=malloc(size*sizeof(unsigned long));
-	iow.display.back_color_mem=malloc(size*sizeof(unsigned long));
 
-	iow.con.charin.io_inkey		= wininkey;
-	iow.con.charout.io_putc		= NULL;			// Use default implementation
-	iow.con.charin.io_getc32		= wingetc;
-	iow.con.header.io_chk_brk	= NULL;   		// need to sort this out:  checkForBreak;
-	iow.con.header.io_close		= NULL;			// don't call any close
-	iow.con.header.type			= IO_TYPE_WINDOW;
-
-	iow.display.io_draw_range=drawRange;
-	iow.display.io_begin_draw=beginDrawRange;
-	iow.display.io_end_draw=endDrawRange;
+	iow->display.cells=malloc(size*sizeof(struct IoCell));
+	iow->display.front=NULL;
+	if (iow->display.cells==NULL)
+		return false;
+
+	iow->con.charin.io_inkey		= wininkey;
+	iow->con.charout.io_putc		= NULL;			// Use default implementation
+	iow->con.charin.io_getc32		= wingetc;
+	iow->con.charin.io_getkeys	= wingetkeys;
+	iow->con.charin.io_begin_line	= winbeginline;
+	iow->con.header.io_chk_brk	= NULL;   		// need to sort this out:  checkForBreak;
+	iow->con.header.io_close		= NULL;			// don't call any close
+	iow->con.header.type			= IO_TYPE_WINDOW;
+	iow->con.header.handle		= canvas;
+
+	iow->display.io_draw_range=drawRange;
+	iow->display.io_begin_draw=beginDrawRange;
+	iow->display.io_end_draw=endDrawRange;
+	iow->display.io_scroll=scrollRows;
 	
-	iow.display.nest_level=0;  
+	iow->display.nest_level=0;  
 
-	iow.display.width = width;
-	iow.display.height = height;
-	iow.display.size=size;
+	iow->display.width = width;
+	iow->display.height = height;
+	iow->display.size=size;
 	
-	iow.display.cursor_visible = false;
-	iow.con.header.cursor=0;
+	iow->display.cursor_visible = false;
+	iow->con.header.cursor=0;
 
-	iow.display.my_cx = d2d_get_canvas_prop("charWidth");
-	iow.display.my_cy = d2d_get_canvas_prop("charHeight");
-	assert(iow.display.my_cx>0);
-	assert(iow.display.my_cy>0);
+	iow->display.my_cx = d2d_get_canvas_prop_on(canvas, "charWidth");
+	iow->display.my_cy = d2d_get_canvas_prop_on(canvas, "charHeight");
+	assert(iow->display.my_cx>0);
+	assert(iow->display.my_cy>0);
 
 	// Calc each cell separately to avoid rounding errors
-	iow.display.my_cell_w1 = iow.display.my_cx / 2;  
-	iow.display.my_cell_w2 = iow.display.my_cx - iow.display.my_cell_w1;  
-	iow.display.my_cell_h1 = iow.display.my_cy / 3;
-	iow.display.my_cell_h2 = iow.display.my_cy / 3;
-	iow.display.my_cell_h3 = iow.display.my_cy - iow.display.my_cell_h1 - iow.display.my_cell_h2;
+	iow->display.my_cell_w1 = iow->display.my_cx / 2;  
+	iow->display.my_cell_w2 = iow->display.my_cx - iow->display.my_cell_w1;  
+	iow->display.my_cell_h1 = iow->display.my_cy / 3;
+	iow->display.my_cell_h2 = iow->display.my_cy / 3;
+	iow->display.my_cell_h3 = iow->display.my_cy - iow->display.my_cell_h1 - iow->display.my_cell_h2;
+
+	io_set_colors(&iow->con, d2d_get_canvas_prop_on(canvas, "foreColor"), d2d_get_canvas_prop_on(canvas, "backColor"));
 
-	iow.display.fore_color=RGB_TO_RGBA(d2d_get_canvas_prop("foreColor"));
-	iow.display.back_color=RGB_TO_RGBA(d2d_get_canvas_prop("backColor"));
+	io_cls(iow);
+
+	return true;
+}
 
-	io_cls(&iow);
+// canvas 0 is <canvas id="twr_iocanvas">
+struct IoConsole* twr_windowcon()
+{
+	static struct IoConsoleWindow iow;
+
+	assert(iow.con.header.type==0);  // twr_windowcon() function can only be called once
+	if (!init_windowcon(&iow, 0))
+		return NULL;
 
 	return &iow.con;
 }
 
+static void winclose(struct IoConsole* io)
+{
+	struct IoConsoleWindow* iow=(struct IoConsoleWindow*)io;
+
+	if (iow->display.ds)
+		d2d_end_draw_sequence(iow->display.ds);
+	free(iow->display.cells);
+	free(iow->display.front);
+	free(iow->display.palette);
+	free(iow->display.palette_hash);
+	free(iow);
+}
+
+// a console for another canvas (a handle from d2d_get_canvas).  It is as many characters wide and high as fit in
+// the canvas.  io_close() frees it.  returns NULL if out of memory, or if canvas is -1 (d2d_get_canvas didn't find
+// the canvas)
+struct IoConsole* twr_new_windowcon(int canvas)
+{
+	if (canvas==-1)
+		return NULL;
+
+	struct IoConsoleWindow* iow=calloc(1, sizeof(struct IoConsoleWindow));
+	if (iow==NULL)
+		return NULL;
+
+	if (!init_windowcon(iow, canvas)) {
+		free(iow);
+		return NULL;
+	}
+	iow->con.header.io_close=winclose;
+
+	return &iow->con;
+}
+
 
 
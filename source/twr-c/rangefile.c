@@ -0,0 +1,100 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include "twr-crt.h"
+#include "twr-jsimports.h"
+
+// Matches TS class twrRangeFiles (twrrange.ts)
+//
+// twr_pread() reads part of a remote file, so a file much larger than module memory can be read at random.  The main
+// JavaScript thread fetches the file a page at a time with HTTP Range requests, and keeps up to max_pages of them in
+// an LRU cache.  A read waits (in the worker) for the pages it needs, and once reads are sequential, the pages after
+// each read are requested before they are needed.
+
+#define RANGE_PAGE_SIZE (64*1024)
+#define RANGE_MAX_PAGES 64
+#define RANGE_PREFETCH 4
+
+int twr_range_open(const char* url, long page_size, int max_pages, int prefetch) {
+	if (page_size<0 || max_pages<0) {
+		errno=EINVAL;
+		return -1;
+	}
+	if (page_size==0) page_size=RANGE_PAGE_SIZE;
+	if (max_pages==0) max_pages=RANGE_MAX_PAGES;
+	if (prefetch<0) prefetch=RANGE_PREFETCH;	// (0 turns prefetch off, for reads at random)
+	if (prefetch>=max_pages) prefetch=max_pages-1;	// so a prefetch can't evict the page being read
+
+	const int handle=twrRangeOpen(url, page_size, max_pages, prefetch);
+	if (handle<0) errno=EIO;	// the reason is logged to the console
+	return handle;
+}
+
+int64_t twr_range_size(int handle) {
+	const double size=twrRangeSize(handle);
+	if (size<0) {
+		errno=EBADF;
+		return -1;
+	}
+	return (int64_t)size;
+}
+
+long twr_pread(int handle, int64_t offset, long len, void* buf) {
+	if (offset<0 || len<0) {
+		errno=EINVAL;
+		return -1;
+	}
+	if (len==0) return 0;
+
+	const long n=twrRangeRead(handle, (double)offset, buf, len);
+	if (n<0) errno=EIO;
+	return n;
+}
+
+int twr_range_close(int handle) {
+	twrRangeClose(handle);
+	return 0;
+}
+
+//*************************************************
+
+// fopen() backend.  Handles are passed as handle+1, since NULL is an error
+static void* rangefs_open(const char* path, int flags) {
+	if (flags&TWR_FS_WRITE) {
+		errno=EROFS;
+		return NULL;
+	}
+
+	const int handle=twr_range_open(path, 0, 0, -1);
+	if (handle<0) return NULL;
+	return (void*)(intptr_t)(handle+1);
+}
+
+static int rangefs_close(void* h) {
+	return twr_range_close((intptr_t)h-1);
+}
+
+static long rangefs_read(void* h, long offset, char* buf, long len) {
+	return twr_pread((intptr_t)h-1, offset, len, buf);
+}
+
+// a file larger than a long can only be read with twr_pread.  To fopen it is a stream (can't seek)
+static long rangefs_size(void* h) {
+	const int64_t size=twr_range_size((intptr_t)h-1);
+	return size>LONG_MAX ? -1 : (long)size;
+}
+
+static const struct twr_fs_backend rangefs={
+	rangefs_open,
+	rangefs_close,
+	rangefs_read,
+	NULL,
+	rangefs_size,
+	NULL,
+	NULL
+};
+
+const struct twr_fs_backend* twr_rangefs(void) {
+	return &rangefs;
+}
@@ -27,17 +27,46 @@ double twr_infval(void);
 
 void twr_dtoa(char* buffer, int sizeInBytes, double value, int max_precision);
 int64_t twr_atou64(const char *str, int* len, int radix);
+int twr_u64toa_end(uint64_t value, char* end, int radix, bool uppercase);
 int __atosign(const char *str, int* len);
 int __atosign_l(const char *str, int* len, locale_t loc);
 #define twr_atod(str) atof(str)
 
+struct twr_from_chars_result {
+	const char* ptr;
+	int ec;		// 0, EINVAL, or ERANGE
+};
+struct twr_from_chars_result twr_from_chars_d(const char* first, const char* last, double* value);
+struct twr_from_chars_result twr_from_chars_d_l(const char* first, const char* last, double* value, locale_t locale);
+
 typedef void (*twr_vcbprintf_callback)(void* cbdata, unsigned char c);
 void twr_vcbprintf(twr_vcbprintf_callback out, void* cbdata, const char *format, va_list vlist);
+typedef void (*twr_vcbprintf_span_callback)(void* cbdata, const char* buf, size_t len);
+void twr_vcbprintf_span(twr_vcbprintf_span_callback out, void* cbdata, const char *format, va_list vlist);
+
+/* one parsed printf conversion.  The emitters are shared by printf and the C++ twr::format (twr-format.h) */
+struct twr_printf_spec {
+	char specifier;		/* d i u o x X p c s f e g */
+	int width;
+	int precision;			/* 6 if not set */
+	bool precision_set;
+	bool flag_minus;
+	bool flag_zero;
+	bool flag_space;
+	bool flag_plus;
+	bool flag_hash;
+};
+void twr_printf_int(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* spec, uint64_t magnitude, bool negative);
+void twr_printf_double(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* spec, double value);
+void twr_printf_str(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* spec, const char* str, int len);
 void twr_conlog(const char* format, ...);
 
 struct IoConsole* twr_divcon(void);
 struct IoConsole* twr_debugcon(void);
 struct IoConsole* twr_windowcon(void);
+struct IoConsole* twr_new_divcon(int div);
+struct IoConsole* twr_new_windowcon(int canvas);
+int twr_get_div(const char* element_id);
 
 void twr_set_stdio_con(struct IoConsole *setto);
 void twr_set_stderr_con(struct IoConsole *setto);
@@ -46,6 +75,49 @@ struct IoConsole * twr_get_stderr_con(void);
 int twr_getc32(void);
 char* twr_mbgets(char* buffer);
 
+/* file system backends used by fopen().  A path is looked up in the mount table (longest matching prefix), and */
+/* the backend is passed the rest of the path.  The in-memory file system (twr_memfs) is mounted at "" */
+#define TWR_FS_READ   (1<<0)
+#define TWR_FS_WRITE  (1<<1)
+#define TWR_FS_CREATE (1<<2)
+#define TWR_FS_TRUNC  (1<<3)
+#define TWR_FS_APPEND (1<<4)
+#define TWR_FS_EXCL   (1<<5)
+
+/* offsets are from the start of the file.  read and write return the number of bytes transferred, or -1 with errno set */
+struct twr_fs_backend {
+	void* (*open)(const char* path, int flags);	/* TWR_FS_ flags.  returns a handle, or NULL with errno set */
+	int (*close)(void* handle);
+	long (*read)(void* handle, long offset, char* buf, long len);
+	long (*write)(void* handle, long offset, const char* buf, long len);	/* NULL if read only */
+	long (*size)(void* handle);		/* -1 if the file isn't seekable */
+	const char* (*map)(void* handle, long* len);		/* optional.  the contents of a file opened read only, if they are in memory */
+	int (*remove)(const char* path);	/* optional */
+};
+
+int twr_fs_mount(const char* prefix, const struct twr_fs_backend* fs);	/* returns 0, or -1 if the mount table is full.  fs NULL unmounts */
+struct IoConsole* twr_fopen_handle(const struct twr_fs_backend* fs, void* handle, const char* mode);
+
+/* in-memory file system.  twr_memfs_add takes ownership of data, which must be from malloc */
+const struct twr_fs_backend* twr_memfs(void);
+int twr_memfs_add(const char* path, char* data, size_t len);
+
+/* a read only view of a file in the in-memory file system, without a copy.  Files added by JavaScript */
+/* (addFile) are 16 byte aligned.  Each twr_map_asset must be matched by a twr_unmap_asset */
+const void* twr_map_asset(const char* name, size_t* len);
+void twr_unmap_asset(const void* data);
+
+/* random access to a remote file with HTTP Range requests.  The file is read in pages, which the main JavaScript */
+/* thread keeps in an LRU cache of max_pages.  After a sequential read, the next prefetch pages are requested ahead. */
+/* 0 selects the default for page_size or max_pages.  A negative prefetch selects its default, and 0 turns */
+/* prefetch off (for reads at random).  These block while pages download, so they need */
+/* twrWasmModuleAsync.  twr_rangefs is an fopen backend for these files, with paths that are URLs relative to the page */
+int twr_range_open(const char* url, long page_size, int max_pages, int prefetch);	/* returns a handle, or -1 with errno set */
+int64_t twr_range_size(int handle);
+long twr_pread(int handle, int64_t offset, long len, void* buf);	/* returns the bytes read (fewer at the end of the file), or -1 */
+int twr_range_close(int handle);
+const struct twr_fs_backend* twr_rangefs(void);
+
 _Noreturn void twr_trap(void);
 
 void twr_sleep(int ms);
@@ -64,6 +136,17 @@ void twr_localize_numeric_string(char* str, locale_t locale);
 /* internal utility function */
 void nstrcopy(char *buffer, const int sizeInBytes, const char *outstring, const int sizeofoutstring, int n);
 
+/* internal.  the stdio functions call these for a FILE from fopen() (see file.c) */
+size_t __twr_file_read(struct IoConsole* stream, char* dest, size_t total);
+int __twr_file_getc(struct IoConsole* stream);
+int __twr_file_ungetc(int ch, struct IoConsole* stream);
+char* __twr_file_gets(char* str, int count, struct IoConsole* stream);
+int __twr_file_flush(struct IoConsole* stream);
+void __twr_file_flush_all(void);
+int __twr_file_setvbuf(struct IoConsole* stream, char* buf, int mode, size_t size);
+int __twr_file_eof(struct IoConsole* stream);
+int __twr_file_error(struct IoConsole* stream);
+
 /* unit tests */
 int malloc_unit_test(void);
 int string_unit_test(void);
@@ -77,6 +160,9 @@ int fcvt_unit_test(void);
 int atof_unit_test(void);
 int twr_dtoa_unit_test(void);
 int printf_unit_test(void);
+int sscanf_unit_test(void);
+int file_unit_test(void);
+int zlib_unit_test(void);
 int time_unit_tests(void);
 int strftime_unit_test(void);
 int locale_unit_test(void);
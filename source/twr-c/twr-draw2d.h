@@ -34,11 +34,15 @@ extern "C" {
 #define D2D_CREATELINEARGRADIENT 32
 #define D2D_SETFILLSTYLE 33
 #define D2D_SETSTROKESTYLE 34
+#define D2D_COPYRECT 35
+#define D2D_FILLCODEPOINTS 36
+#define D2D_FILLBLOCKS 37
 
 #define RGB_TO_RGBA(x) ( ((x)<<8) | 0xFF)
 
+/* each instruction is one of these structs, in the draw sequence's buffer.  size is the bytes to the next one */
 struct d2d_instruction_hdr {
-    struct d2d_instruction_hdr *next;
+    unsigned long size;
     unsigned long type;
 };
 
@@ -47,10 +51,12 @@ struct d2dins_fillrect {
     double x,y,w,h;
 };
 
+/* a string argument is copied after the struct.  Its field is the copy's offset from the start of the record */
+
 struct d2dins_filltext {
     struct d2d_instruction_hdr hdr;
     double x,y;
-    const char* str;
+    unsigned long str;
 	 int code_page;
 };
 
@@ -60,6 +66,14 @@ struct d2dins_fillcodepoint {
     unsigned long c;
 };
 
+struct d2dins_fillcodepoints {
+    struct d2d_instruction_hdr hdr;
+    double x,y;
+    double advance;
+    unsigned long n;
+    unsigned long c[];
+};
+
 struct d2dins_measuretext {
     struct d2d_instruction_hdr hdr;
     const char* str;
@@ -72,6 +86,18 @@ struct d2dins_strokerect {
     double x,y,w,h;
 };
 
+struct d2dins_copyrect {
+    struct d2d_instruction_hdr hdr;
+    double sx,sy,w,h;
+    double dx,dy;
+};
+
+struct d2dins_fillblocks {
+    struct d2d_instruction_hdr hdr;
+    double x,y,w,h;
+    unsigned long bits;
+};
+
 struct d2dins_setlinewidth {
     struct d2d_instruction_hdr hdr;
     double width;
@@ -89,17 +115,17 @@ struct d2dins_setfillstylergba {
 
 struct d2dins_setstrokestyle {
     struct d2d_instruction_hdr hdr;
-    const char* css_color;
+    unsigned long css_color;
 };
 
 struct d2dins_setfillstyle {
     struct d2d_instruction_hdr hdr;
-    const char* css_color;
+    unsigned long css_color;
 };
 
 struct d2dins_setfont {
     struct d2d_instruction_hdr hdr;
-    const char* font;
+    unsigned long font;
 };
 
 struct d2dins_beginpath {
@@ -193,7 +219,7 @@ struct d2dins_set_color_stop {
     struct d2d_instruction_hdr hdr;
     long id;
     long position;
-    const char* csscolor;
+    unsigned long csscolor;
 };
 
 struct d2dins_set_fillstyle_gradient {
@@ -206,9 +232,15 @@ struct d2dins_release_id {
     long id;
 };
 
+/* the canvas a draw sequence is for.  A handle from d2d_get_canvas(), or D2D_DEFAULT_CANVAS.  (Not -1, which is
+   d2d_get_canvas() not finding the canvas) */
+#define D2D_DEFAULT_CANVAS (-2)
+
 struct d2d_draw_seq {
-    struct d2d_instruction_hdr* start;
-    struct d2d_instruction_hdr* last;
+    unsigned char* buf;     /* the instructions, one after another */
+    unsigned long len;      /* bytes of buf used */
+    int canvas;             /* twrcanvas.ts reads buf, len and canvas */
+    unsigned long size;     /* bytes of buf */
     int flush_at_ins_count;
     int ins_count;
     unsigned long last_fillstyle_color;
@@ -229,14 +261,22 @@ struct d2d_text_metrics {
 };
 
 struct d2d_draw_seq* d2d_start_draw_sequence(int flush_at_ins_count);
+struct d2d_draw_seq* d2d_start_draw_sequence_on(int canvas, int flush_at_ins_count);
 void d2d_end_draw_sequence(struct d2d_draw_seq* ds);
 void d2d_flush(struct d2d_draw_seq* ds);
+void d2d_begin_batch(void);
+void d2d_end_batch(void);
+int d2d_get_canvas(const char* element_id);
 int d2d_get_canvas_prop(const char* prop);
+int d2d_get_canvas_prop_on(int canvas, const char* prop);
 
 void d2d_fillrect(struct d2d_draw_seq* ds, double x, double y, double w, double h);
 void d2d_strokerect(struct d2d_draw_seq* ds, double x, double y, double w, double h);
+void d2d_copyrect(struct d2d_draw_seq* ds, double sx, double sy, double w, double h, double dx, double dy);
+void d2d_fillblocks(struct d2d_draw_seq* ds, unsigned long bits, double x, double y, double w, double h);
 void d2d_filltext(struct d2d_draw_seq* ds, const char* str, double x, double y);
 void d2d_fillcodepoint(struct d2d_draw_seq* ds, unsigned long c, double x, double y);
+void d2d_fillcodepoints(struct d2d_draw_seq* ds, const unsigned long* c, int n, double x, double y, double advance);
 
 void d2d_measuretext(struct d2d_draw_seq* ds, const char* str, struct d2d_text_metrics *tm);
 void d2d_save(struct d2d_draw_seq* ds);
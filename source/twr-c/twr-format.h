@@ -0,0 +1,313 @@
+#ifndef __TWR_FORMAT_H__
+#define __TWR_FORMAT_H__
+
+// twr::format is printf with the format string parsed at compile time (requires C++20)
+//
+//    twr::format<"%s: %5d items in %.2f ms\n">(name, count, ms);     // to stdout
+//    twr::format_to<"%d,%d\n">(stderr, x, y);                        // to a FILE (IoConsole)
+//    int n=twr::format_to<"id=%llx">(buffer, sizeof(buffer), id);    // same as snprintf
+//
+// Conversions, flags, width and precision are the same as printf, except that '*' is not supported.  Length modifiers
+// are accepted and ignored, since the C++ type of the argument is used.  A bad format, the wrong number of arguments,
+// or an argument type that doesn't match its conversion is a compile error.
+//
+// The format is parsed once by the compiler, so at runtime literal text is a fixed length copy, integers without
+// flags or width are converted in place with twr_u64toa_end(), and everything else goes to the same emitters that
+// printf uses (twr_printf_int, twr_printf_double, twr_printf_str in twr-crt.h).
+
+#ifndef __cplusplus
+#error twr-format.h is C++ only
+#endif
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <type_traits>
+#include <utility>
+#include <string_view>
+#include "twr-crt.h"
+
+namespace twr {
+
+namespace format_detail {
+
+template<size_t N>
+struct fixed_string {
+	char str[N];
+
+	consteval fixed_string(const char (&s)[N]) {
+		for (size_t i=0; i<N; i++) str[i]=s[i];
+	}
+};
+
+// not constexpr, so calling it while parsing makes the format a compile error, with this function in the message
+void twr_format_string_error(const char* msg);
+
+consteval int count_conversions(const char* f) {
+	int n=0;
+	while (*f) {
+		if (*f++=='%') {
+			if (*f=='%') f++;
+			else n++;
+		}
+	}
+	return n;
+}
+
+consteval bool is_digit(char c) {
+	return c>='0' && c<='9';
+}
+
+// the format as literal spans (with %% as %) between conversions: lit[0] spec[0] lit[1] spec[1] ... lit[NCONV]
+template<size_t N, int NCONV>
+struct parsed_format {
+	static constexpr int nconv=NCONV;
+	char text[N];
+	int lit_start[NCONV+1];
+	int lit_len[NCONV+1];
+	twr_printf_spec spec[NCONV+1];   // +1 so that the array is never zero length
+};
+
+template<fixed_string F>
+consteval auto parse() {
+	constexpr int NCONV=count_conversions(F.str);
+	parsed_format<sizeof(F.str), NCONV> p{};
+	const char* f=F.str;
+	int t=0;
+
+	for (int i=0; i<=NCONV; i++) {
+		p.lit_start[i]=t;
+		while (*f && !(f[0]=='%' && f[1]!='%')) {
+			if (f[0]=='%') f++;   // %%
+			p.text[t++]=*f++;
+		}
+		p.lit_len[i]=t-p.lit_start[i];
+		if (i==NCONV) break;
+
+		f++;  // %
+		twr_printf_spec s{};
+		s.precision=6;
+
+		for (;; f++) {
+			if (*f=='-') s.flag_minus=true;
+			else if (*f=='0') s.flag_zero=true;
+			else if (*f==' ') s.flag_space=true;
+			else if (*f=='+') s.flag_plus=true;
+			else if (*f=='#') s.flag_hash=true;
+			else break;
+		}
+
+		if (*f=='*') twr_format_string_error("'*' width is not supported by twr::format");
+		while (is_digit(*f)) s.width=s.width*10+(*f++-'0');
+
+		if (*f=='.') {
+			f++;
+			if (*f=='*') twr_format_string_error("'*' precision is not supported by twr::format");
+			s.precision_set=true;
+			s.precision=0;
+			while (is_digit(*f)) s.precision=s.precision*10+(*f++-'0');
+		}
+
+		while (*f=='h' || *f=='l' || *f=='j' || *f=='z' || *f=='t') f++;   // the argument's type is used instead
+
+		switch (*f) {
+			case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'p':
+			case 'c': case 's': case 'f': case 'e': case 'g':
+				s.specifier=*f++;
+				break;
+			default:
+				twr_format_string_error("invalid conversion in twr::format string");
+		}
+
+		p.spec[i]=s;
+	}
+
+	return p;
+}
+
+template<fixed_string F>
+inline constexpr auto parsed=parse<F>();
+
+template<class T>
+inline constexpr bool dependent_false=false;
+
+// a caller's buffer, with snprintf truncation rules.  pos is the length the result would have
+struct buffer_sink {
+	char* buffer;
+	size_t size;
+	size_t pos;
+
+	void write(const char* str, size_t len) {
+		if (pos+1 < size) {  // leave room for terminating zero
+			const size_t room=size-1-pos;
+			memcpy(buffer+pos, str, len<room?len:room);
+		}
+		pos+=len;
+	}
+
+	static void callback(void* self, const char* str, size_t len) {
+		static_cast<buffer_sink*>(self)->write(str, len);
+	}
+};
+
+// a FILE.  Output is collected in buf, and sent to io_write (which adds it to the stream's stdio buffer) a span at a time
+struct stream_sink {
+	FILE* stream;
+	size_t count;
+	int len;
+	char buf[128];
+
+	void write(const char* str, size_t n) {
+		count+=n;
+		if (len+n > sizeof(buf)) {
+			flush();
+			if (n >= sizeof(buf)) {
+				io_write(stream, str, n);
+				return;
+			}
+		}
+		memcpy(buf+len, str, n);
+		len+=n;
+	}
+
+	void flush() {
+		if (len) io_write(stream, buf, len);
+		len=0;
+	}
+
+	static void callback(void* self, const char* str, size_t n) {
+		static_cast<stream_sink*>(self)->write(str, n);
+	}
+};
+
+template<fixed_string F, int I, class Sink>
+inline void emit_literal(Sink& sink) {
+	constexpr auto& p=parsed<F>;
+	if constexpr (p.lit_len[I]>0)
+		sink.write(p.text+p.lit_start[I], p.lit_len[I]);
+}
+
+consteval bool is_plain(const twr_printf_spec& s) {
+	return s.width==0 && !s.precision_set && !s.flag_plus && !s.flag_space && !s.flag_hash;
+}
+
+// conversion N of format F
+template<fixed_string F, int N, class Sink, class T>
+inline void emit_arg(Sink& sink, const T& arg) {
+	using U=std::remove_cvref_t<T>;
+	constexpr const twr_printf_spec& S=parsed<F>.spec[N];
+	constexpr char sp=S.specifier;
+
+	if constexpr (sp=='d' || sp=='i' || sp=='u' || sp=='o' || sp=='x' || sp=='X' || sp=='c') {
+		static_assert(std::is_integral_v<U> || std::is_enum_v<U>, "twr::format: %d %i %u %o %x %X and %c need an integer argument");
+		using I=typename std::conditional_t<std::is_enum_v<U>, std::underlying_type<U>, std::type_identity<U>>::type;
+		using UI=std::make_unsigned_t<std::conditional_t<std::is_same_v<I, bool>, unsigned char, I>>;
+		const I v=static_cast<I>(arg);
+
+		if constexpr (sp=='c') {
+			const char c=(char)v;
+			if constexpr (S.width==0) sink.write(&c, 1);
+			else twr_printf_str(&Sink::callback, &sink, &S, &c, 1);
+		}
+		else {
+			uint64_t magnitude;
+			bool negative=false;
+			if constexpr ((sp=='d' || sp=='i') && std::is_signed_v<I>) {
+				negative=v<0;
+				magnitude=negative ? 0-(uint64_t)(int64_t)v : (uint64_t)v;
+			}
+			else {
+				magnitude=(uint64_t)(UI)v;
+			}
+
+			if constexpr (is_plain(S) && sp!='o' && sp!='x' && sp!='X') {
+				char digits[21];
+				int n=twr_u64toa_end(magnitude, digits+sizeof(digits), 10, false);
+				if (negative) digits[sizeof(digits)-(++n)]='-';
+				sink.write(digits+sizeof(digits)-n, n);
+			}
+			else {
+				twr_printf_int(&Sink::callback, &sink, &S, magnitude, negative);
+			}
+		}
+	}
+	else if constexpr (sp=='p') {
+		static_assert(std::is_pointer_v<U> || std::is_null_pointer_v<U>, "twr::format: %p needs a pointer argument");
+		twr_printf_int(&Sink::callback, &sink, &S, (uintptr_t)(const void*)arg, false);
+	}
+	else if constexpr (sp=='f' || sp=='e' || sp=='g') {
+		static_assert(std::is_arithmetic_v<U>, "twr::format: %f %e and %g need a numeric argument");
+		twr_printf_double(&Sink::callback, &sink, &S, (double)arg);
+	}
+	else if constexpr (sp=='s') {
+		const char* str;
+		size_t len;
+		if constexpr (std::is_convertible_v<const U&, const char*>) {
+			str=arg;
+			if (str==NULL) str="(null)";
+			if constexpr (S.precision_set) {
+				len=0;
+				while (len<(size_t)S.precision && str[len]) len++;
+			}
+			else {
+				len=strlen(str);
+			}
+		}
+		else if constexpr (std::is_convertible_v<const U&, std::string_view>) {
+			const std::string_view sv=arg;
+			str=sv.data();
+			len=sv.size();
+			if constexpr (S.precision_set) {
+				if (len>(size_t)S.precision) len=S.precision;
+			}
+		}
+		else {
+			static_assert(dependent_false<U>, "twr::format: %s needs a string argument (const char*, std::string or std::string_view)");
+		}
+
+		if constexpr (S.width==0) sink.write(str, len);
+		else twr_printf_str(&Sink::callback, &sink, &S, str, len);
+	}
+}
+
+template<fixed_string F, class Sink, class... Args, size_t... I>
+inline void emit_all(Sink& sink, std::index_sequence<I...>, const Args&... args) {
+	((emit_literal<F, I>(sink), emit_arg<F, I>(sink, args)), ...);
+	emit_literal<F, sizeof...(I)>(sink);
+}
+
+}  // namespace format_detail
+
+// same as snprintf.  Returns the length of the full result, which was truncated if it is >= size
+template<format_detail::fixed_string F, class... Args>
+inline int format_to(char* buffer, size_t size, const Args&... args) {
+	static_assert(format_detail::parsed<F>.nconv==sizeof...(Args), "twr::format: the number of arguments doesn't match the format");
+	format_detail::buffer_sink sink{buffer, size, 0};
+	format_detail::emit_all<F>(sink, std::make_index_sequence<sizeof...(Args)>(), args...);
+	if (size) buffer[sink.pos<size ? sink.pos : size-1]=0;
+	return (int)sink.pos;
+}
+
+// same as fprintf.  Returns the number of bytes written
+template<format_detail::fixed_string F, class... Args>
+inline int format_to(FILE* stream, const Args&... args) {
+	static_assert(format_detail::parsed<F>.nconv==sizeof...(Args), "twr::format: the number of arguments doesn't match the format");
+	format_detail::stream_sink sink;
+	sink.stream=stream;
+	sink.count=0;
+	sink.len=0;
+	format_detail::emit_all<F>(sink, std::make_index_sequence<sizeof...(Args)>(), args...);
+	sink.flush();
+	return (int)sink.count;
+}
+
+// same as printf
+template<format_detail::fixed_string F, class... Args>
+inline int format(const Args&... args) {
+	return format_to<F>(stdout, args...);
+}
+
+}  // namespace twr
+
+#endif
@@ -26,6 +26,7 @@ struct IoConsole;
 
 /* type of zero is default TTY (stream) */
 #define IO_TYPE_WINDOW (1<<0)
+#define IO_TYPE_FILE (1<<1)	/* a FILE from fopen().  bytes are written as is (see file.c) */
 
 struct IoConsoleHeader {
 	int type;
@@ -35,20 +36,47 @@ struct IoConsoleHeader {
 	int cursor; 
 	void (*io_close)  (struct IoConsole*);
 	int  (*io_chk_brk)(struct IoConsole*);
+	int handle;	/* div and window consoles: the div or canvas (see twr_new_divcon() and twr_new_windowcon()) */
 };
 
 struct IoCharRead {
 	int (*io_getc32)(struct IoConsole *);
 	char (*io_inkey)(struct IoConsole*);
+	int (*io_getkeys)(struct IoConsole*, int*, int);	/* optional. wait for key events, and return all there are (up to n).  see io_getkeys() */
+	bool (*io_begin_line)(struct IoConsole*);		/* optional. the JS console edits the next line.  see io_set_line_mode() */
 };
 
+/* a key event from io_getkeys() is a unicode code point, or'd with these flags */
+#define IO_KEY_CODE_MASK 0x1FFFFF
+#define IO_KEY_SHIFT (1<<24)
+#define IO_KEY_CTRL (1<<25)
+#define IO_KEY_ALT (1<<26)
+#define IO_KEY_ECHOED (1<<27)	/* already shown by the JS console (line mode) */
+#define IO_KEY_UP (1<<28)		/* a key release.  only sent if keyUpDiv() or keyUpCanvas() is hooked up */
+
 struct IoCharWrite {
 	void (*io_putc)(struct IoConsole*, unsigned char);
+	void (*io_write)(struct IoConsole*, const char*, int);	/* optional. write len bytes in one call.  if NULL, io_putc is used */
+};
+
+/* stdio style output buffering, used by stream (TTY) consoles.  see io_setvbuf() */
+/* a zeroed struct (the default) means unbuffered */
+struct IoOutBuffer {
+	int mode;	/* _IOFBF, _IOLBF or _IONBF (see stdio.h) */
+	int size;
+	int len;		/* bytes waiting in buf */
+	char* buf;
+	bool allocated;	/* buf was malloc'd by io_setvbuf */
 };
 
 struct IoConsoleWindow;
 
-typedef unsigned long cellsize_t;
+/* a character cell.  Colors are indexes into IoDisplay.palette, so a cell is 8 bytes */
+struct IoCell {
+	unsigned long c;		// unicode code point, or a TRS-80 graphic (see TRS80_GRAPHIC_MARKER)
+	unsigned short fore;
+	unsigned short back;
+};
 
 /* Windowed driver functions */
 struct IoDisplay {
@@ -56,9 +84,15 @@ struct IoDisplay {
 	int height;
 	int size;
 	bool cursor_visible;
-	cellsize_t* video_mem;
-	cellsize_t* back_color_mem;
-	cellsize_t* fore_color_mem;
+	struct IoCell* cells;	// the display.  Or with double buffering, what it will be after the next io_present()
+	struct IoCell* front;	// with double buffering, what is drawn.  Otherwise NULL
+	int scrolled;			// with double buffering, rows cells has scrolled up since the last io_present()
+
+	unsigned long* palette;	// RGBA, each color once
+	unsigned short* palette_hash;
+	int palette_len;
+	int palette_size;
+	int palette_nearest;	// colors given the nearest palette color since the palette was last compacted
 
 	struct d2d_draw_seq* ds;
 	int nest_level;
@@ -66,9 +100,12 @@ struct IoDisplay {
 	void (*io_draw_range)(struct IoConsoleWindow*, int, int);
 	void (*io_begin_draw)(struct IoConsoleWindow*);
 	void (*io_end_draw)(struct IoConsoleWindow*);
+	void (*io_scroll)(struct IoConsoleWindow*, int, int, int);	// optional.  move what is drawn in rows top to bottom up n rows (down if n<0).  The caller draws the uncovered rows
 
 	unsigned long fore_color;
 	unsigned long back_color;
+	unsigned short fore_index;	// fore_color and back_color in palette
+	unsigned short back_index;
 
 	int my_cx;
 	int my_cy;
@@ -80,10 +117,41 @@ struct IoDisplay {
 	int my_cell_h3;
 };
 
+/* key events read by io_mbgets() (or io_getkeys()) that haven't been used yet.  a zeroed struct is empty */
+#define IO_KEY_BUFFER_SIZE 64
+struct IoKeyBuffer {
+	int keys[IO_KEY_BUFFER_SIZE];
+	int len;
+	int next;		/* keys[next] to keys[len-1] are waiting */
+	bool line_mode;	/* see io_set_line_mode() */
+};
+
+/* VT100/xterm escape sequence state (see iovt.c).  a zeroed struct is the initial state */
+#define IO_VT_MAX_PARAMS 16
+struct IoVT {
+	unsigned char state;
+	char private_marker;	/* '?' etc, or 0 */
+	char intermediate;	/* the last intermediate byte, or 0 */
+	int nparams;
+	int params[IO_VT_MAX_PARAMS];
+
+	/* window consoles */
+	int fore, back;		/* SGR colors:  -1 for the default, 0 to 255 for the xterm palette, or IO_VT_RGB|rgb */
+	bool bold, reverse;
+	bool colors_saved;	/* default_fore and default_back are the colors before the first SGR */
+	unsigned long default_fore, default_back;
+	int top, bottom;		/* the scroll region (rows).  bottom==0 if there isn't one */
+	int saved_cursor;
+};
+#define IO_VT_RGB (1<<24)
+
 struct IoConsole {
 	struct IoConsoleHeader header;  	
 	struct IoCharRead charin;  			
 	struct IoCharWrite charout;		
+	struct IoOutBuffer outbuf;
+	struct IoKeyBuffer keys;
+	struct IoVT vt;
 };
 
 struct IoConsoleWindow {
@@ -111,12 +179,17 @@ struct IoConsole* io_nullcon(void);
 /* io.c */
 void io_putc(struct IoConsole* io, unsigned char c);
 void io_putstr(struct IoConsole* io, const char* s);
+void io_write(struct IoConsole* io, const char* buf, int len);
+int io_flush(struct IoConsole* io);
+int io_setvbuf(struct IoConsole* io, char* buf, int mode, size_t size);
 char io_inkey(struct IoConsole* io);
 int io_chk_brk(struct IoConsole* io);
 void io_close(struct IoConsole* io);
 void io_printf(struct IoConsole *io, const char *format, ...);
 int io_getc32(struct IoConsole* io);
 void io_mbgetc(struct IoConsole* io, char* strout);
+int io_getkeys(struct IoConsole* io, int* keys, int n);
+bool io_set_line_mode(struct IoConsole* io, bool on);
 char *io_mbgets(struct IoConsole* io, char *buffer );
 int io_get_cursor(struct IoConsole* io);
 void io_set_colors(struct IoConsole* io, unsigned long foreground, unsigned long background);
@@ -130,8 +203,15 @@ bool io_point(struct IoConsoleWindow* iow, int x, int y);
 void io_set_cursor(struct IoConsoleWindow* iow, int loc);
 void io_set_cursorxy(struct IoConsoleWindow* iow, int x, int y);
 void io_draw_range(struct IoConsoleWindow* iow, int x, int y);
+void io_draw_cells(struct IoConsoleWindow* iow, int start, int end);
+void io_scroll(struct IoConsoleWindow* iow, int top, int bottom, int rows);
 void io_begin_draw(struct IoConsole* io);
 void io_end_draw(struct IoConsole* io);
+bool io_set_double_buffer(struct IoConsole* io, bool on);
+void io_present(struct IoConsole* io);
+
+/* iovt.c */
+void io_vt_putc(struct IoConsole* io, unsigned char c);
 
 #ifdef __cplusplus
 }
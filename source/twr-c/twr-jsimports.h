@@ -11,15 +11,30 @@
 extern "C" {
 #endif
 
-__attribute__((import_name("twrDivCharOut"))) void twrDivCharOut(int c, int code_page);   
-__attribute__((import_name("twrDivCharIn"))) int twrDivCharIn(void);
-__attribute__((import_name("twrCanvasGetProp"))) int twrCanvasGetProp(const char *);
+/* div and canvas are handles (see twr_get_div and d2d_get_canvas).  canvas can be D2D_DEFAULT_CANVAS */
+__attribute__((import_name("twrDivCharOut"))) void twrDivCharOut(int div, int c, int code_page);   
+__attribute__((import_name("twrDivStrOut"))) void twrDivStrOut(int div, const char* str, int len, int code_page);
+__attribute__((import_name("twrDivCharIn"))) int twrDivCharIn(int div);
+__attribute__((import_name("twrDivKeysIn"))) int twrDivKeysIn(int div, int* keys, int n);
+__attribute__((import_name("twrDivLineBegin"))) int twrDivLineBegin(int div);
+__attribute__((import_name("twrDivGetHandle"))) int twrDivGetHandle(const char* element_id);
+__attribute__((import_name("twrCanvasGetProp"))) int twrCanvasGetProp(int canvas, const char *);
 __attribute__((import_name("twrCanvasDrawSeq"))) void twrCanvasDrawSeq(struct d2d_draw_seq *);
-__attribute__((import_name("twrCanvasCharIn"))) int twrCanvasCharIn(void);
-__attribute__((import_name("twrCanvasInkey"))) int twrCanvasInkey(void);
+__attribute__((import_name("twrCanvasDrawSeqs"))) void twrCanvasDrawSeqs(struct d2d_draw_seq **, int n);
+__attribute__((import_name("twrCanvasGetHandle"))) int twrCanvasGetHandle(const char* element_id);
+__attribute__((import_name("twrCanvasCharIn"))) int twrCanvasCharIn(int canvas);
+__attribute__((import_name("twrCanvasInkey"))) int twrCanvasInkey(int canvas);
+__attribute__((import_name("twrCanvasKeysIn"))) int twrCanvasKeysIn(int canvas, int* keys, int n);
+__attribute__((import_name("twrCanvasLineBegin"))) int twrCanvasLineBegin(int canvas, int cursor, unsigned long fore_color, unsigned long back_color);
+__attribute__((import_name("twrLineModeAvailable"))) int twrLineModeAvailable(void);	/* 0 with twrWasmModule */
 
 __attribute__((import_name("twrSleep"))) void twrSleep(int ms);
+__attribute__((import_name("twrRangeOpen"))) int twrRangeOpen(const char* url, long page_size, int max_pages, int prefetch);
+__attribute__((import_name("twrRangeSize"))) double twrRangeSize(int handle);
+__attribute__((import_name("twrRangeRead"))) long twrRangeRead(int handle, double offset, char* buf, long len);
+__attribute__((import_name("twrRangeClose"))) void twrRangeClose(int handle);
 __attribute__((import_name("twrDebugLog"))) int twrDebugLog(int c);	
+__attribute__((import_name("twrDebugLogStr"))) void twrDebugLogStr(const char* str, int len);
 __attribute__((import_name("twrTimeEpoch"))) double twrTimeEpoch(); 
 __attribute__((import_name("twrTimeTmLocal"))) void twrTimeTmLocal(struct tm*, const time_t);
 __attribute__((import_name("twrUserLconv"))) void twrUserLconv(struct lconv *, int code_page);
@@ -48,19 +63,7 @@ __attribute__((import_name("twrPow"))) double twrPow(double base, double exponen
 __attribute__((import_name("twrSqrt"))) double twrSqrt(double arg);
 __attribute__((import_name("twrTrunc"))) double twrTrunc(double arg);
 
-__attribute__((import_name("twrAtod"))) double twrAtod(const char* str, int len);
-__attribute__((import_name("twrToFixed"))) double twrToFixed(char* buffer, int buffer_size, double value, int dec_digits);
-__attribute__((import_name("twrToExponential"))) void twrToExponential(char* buffer, int buffer_size, double value, int dec_digits);
-
 __attribute__((import_name("twrDtoa"))) void twrDtoa(char* buffer, int buffer_size, double value, int max_precision);
-__attribute__((import_name("twrFcvtS"))) int twrFcvtS(
-   char* buffer,
-   unsigned long sizeInBytes,  //size_t 
-   double value,
-   int fracpart_numdigits,
-   int *dec,
-   int *sign
-);
 
 #ifdef __cplusplus
 }
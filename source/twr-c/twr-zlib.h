@@ -0,0 +1,55 @@
+#ifndef __TWR_ZLIB_H__
+#define __TWR_ZLIB_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* DEFLATE (RFC 1951) compression and decompression, with zlib (RFC 1950) or gzip (RFC 1952) framing, or none (raw) */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TWR_Z_RAW  0
+#define TWR_Z_ZLIB 1
+#define TWR_Z_GZIP 2
+#define TWR_Z_AUTO 3	/* inflate only: zlib or gzip, from the header */
+
+/* twr_inflate and twr_deflate return values */
+#define TWR_Z_OK    0		/* more input, or more room for output, is needed */
+#define TWR_Z_END   1		/* the end of the compressed data */
+#define TWR_Z_DATA_ERROR (-1)	/* the input isn't valid compressed data, or doesn't match its checksum */
+
+/* streaming.  Each call uses as much of in as it can (*in_used) and writes up to out_len bytes (*out_made).  Input */
+/* that isn't used must be passed again, at the start of in, with the next call.  twr_inflate uses none of an input */
+/* that ends in the middle of a block header (up to a few hundred bytes), so in_len shouldn't be less than 512 */
+/* unless it is the end of the data.  Pass finish to twr_deflate when in is the last of the input, and keep calling */
+/* with finish until it returns TWR_Z_END.  The _new functions return NULL if out of memory */
+struct twr_inflate;
+struct twr_inflate* twr_inflate_new(int format);
+int twr_inflate(struct twr_inflate* z, const void* in, size_t in_len, size_t* in_used, void* out, size_t out_len, size_t* out_made);
+void twr_inflate_free(struct twr_inflate* z);
+
+struct twr_deflate;
+struct twr_deflate* twr_deflate_new(int format, int level);	/* level 0 (store) to 9 (smallest), or -1 for 6 */
+int twr_deflate(struct twr_deflate* z, const void* in, size_t in_len, size_t* in_used, void* out, size_t out_len, size_t* out_made, int finish);
+void twr_deflate_free(struct twr_deflate* z);
+
+/* a whole buffer.  Return the output size, or -1 with errno set to EINVAL (bad data) or ENOSPC (out_len is too small) */
+long twr_inflate_buf(const void* in, size_t in_len, void* out, size_t out_len, int format);
+long twr_deflate_buf(const void* in, size_t in_len, void* out, size_t out_len, int format, int level);
+size_t twr_deflate_bound(size_t in_len);		/* the largest possible twr_deflate_buf output */
+
+/* a FILE that reads stream decompressed ("r"), or writes it compressed ("w", with an optional level digit, as in "w9") */
+/* fclose also closes stream */
+FILE* twr_zfopen(FILE* stream, const char* mode, int format);
+
+uint32_t twr_crc32(uint32_t crc, const void* data, size_t len);		/* start with 0 */
+uint32_t twr_adler32(uint32_t adler, const void* data, size_t len);	/* start with 1 */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
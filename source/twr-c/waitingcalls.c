@@ -1,10 +1,12 @@
 
+#include <stdio.h>
 #include "twr-crt.h"
 #include "twr-jsimports.h"
 
 // Matches TS class twrWaitingCalls
 
 void twr_sleep(int ms) {
+    fflush(NULL);  // show any pending output while sleeping
     twrSleep(ms);  // blocking call implemented by twrWasModuleAsync
 }
 
@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdlib.h>
+#include "twr-crt.h"
+
+// native, exact, fixed and exponential formatting of doubles.  Used by printf %f and %e, twr_tofixed, twr_toexponential and _fcvt_s.
+// A finite double is m*2^e2, which has a finite decimal expansion.  That expansion is generated exactly using base 1e9 limbs
+// (m*2^e2 for e2>0, m*5^-e2 for e2<0), and then rounded in decimal.  Rounding is half up (like JavaScript toFixed),
+// and there are no limits on the range or number of digits (except the size of the output buffer).
+
+#define LIMB_BASE 1000000000U
+#define MAX_LIMBS 90				// 5^1074*2^52 is 767 digits
+#define MAX_DIGITS (MAX_LIMBS*9)
+
+struct exact_decimal {
+	char digits[MAX_DIGITS];   // no leading or trailing zeros
+	int nd;		// number of digits
+	int decpt;	// value is 0.digits * 10^decpt
+};
+
+// multiply in place by f, where f*LIMB_BASE fits in 64 bits
+static int limbs_mult(uint32_t* limb, int n, uint32_t f) {
+	uint64_t carry=0;
+	for (int i=0; i<n; i++) {
+		const uint64_t t=(uint64_t)limb[i]*f+carry;
+		limb[i]=(uint32_t)(t%LIMB_BASE);
+		carry=t/LIMB_BASE;
+	}
+	while (carry) {
+		limb[n++]=(uint32_t)(carry%LIMB_BASE);
+		carry/=LIMB_BASE;
+	}
+	return n;
+}
+
+// value must be finite and > 0
+static void exact_decimal_new(struct exact_decimal* ed, double value) {
+	uint64_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	int be=(int)((bits>>52)&0x7FF);
+	uint64_t m=bits&0x000FFFFFFFFFFFFFULL;
+	if (be==0) be=1;
+	else m|=(uint64_t)1<<52;
+	int e2=be-1075;
+
+	const int tz=__builtin_ctzll(m);   // less work in the loops below
+	m>>=tz;
+	e2+=tz;
+
+	uint32_t limb[MAX_LIMBS];
+	int n=0;
+	while (m) {
+		limb[n++]=(uint32_t)(m%LIMB_BASE);
+		m/=LIMB_BASE;
+	}
+
+	int dexp=0;
+	if (e2>0) {
+		while (e2>0) {
+			const int sh=e2>29?29:e2;
+			n=limbs_mult(limb, n, 1U<<sh);
+			e2-=sh;
+		}
+	}
+	else if (e2<0) {
+		static const uint32_t pow5[]={1, 5, 25, 125, 625, 3125, 15625, 78125, 390625, 1953125, 9765625, 48828125, 244140625, 1220703125};
+		dexp=e2;   // m*2^e2 == m*5^-e2 * 10^e2
+		int k=-e2;
+		while (k>0) {
+			const int s=k>13?13:k;
+			n=limbs_mult(limb, n, pow5[s]);
+			k-=s;
+		}
+	}
+
+	// limbs to digits, most significant first
+	char* d=ed->digits;
+	uint32_t top=limb[n-1];
+	char tmp[10];
+	int t=0;
+	do {
+		tmp[t++]='0'+top%10;
+		top/=10;
+	} while (top);
+	while (t) *d++=tmp[--t];
+	for (int i=n-2; i>=0; i--) {
+		uint32_t v=limb[i];
+		for (int j=8; j>=0; j--) {
+			d[j]='0'+v%10;
+			v/=10;
+		}
+		d+=9;
+	}
+
+	ed->nd=d-ed->digits;
+	ed->decpt=ed->nd+dexp;
+	while (ed->nd>0 && ed->digits[ed->nd-1]=='0') ed->nd--;
+}
+
+// keep nkeep digits, rounding half up.  decpt is adjusted if the rounding carries out (eg .999 -> 1.00)
+// if nkeep<0, the value rounds to zero
+static void exact_decimal_round(struct exact_decimal* ed, int nkeep) {
+	if (nkeep<0) {
+		ed->nd=0;
+		return;
+	}
+	if (nkeep>=ed->nd) return;
+
+	const bool roundup=ed->digits[nkeep]>='5';
+	ed->nd=nkeep;
+	if (roundup) {
+		int i=nkeep-1;
+		while (i>=0 && ed->digits[i]=='9') i--;
+		if (i<0) {
+			ed->digits[0]='1';
+			ed->nd=1;
+			ed->decpt++;
+		}
+		else {
+			ed->digits[i]++;
+			ed->nd=i+1;
+		}
+	}
+}
+
+static inline char ed_digit(const struct exact_decimal* ed, int i) {
+	return (i<0 || i>=ed->nd) ? '0' : ed->digits[i];
+}
+
+/****************************************************************/
+
+// bounded string output; always zero terminated (if size>0).  Truncates silently.
+struct strout {
+	char* buffer;
+	int size;
+	int pos;
+};
+
+static inline void so_putc(struct strout* so, char c) {
+	if (so->pos+1 < so->size) so->buffer[so->pos++]=c;
+}
+
+static void so_puts(struct strout* so, const char* s) {
+	while (*s) so_putc(so, *s++);
+}
+
+static void so_putexp(struct strout* so, int e) {
+	char tmp[8];
+	int t=0;
+	so_putc(so, 'e');
+	so_putc(so, e<0?'-':'+');
+	if (e<0) e=-e;
+	do {
+		tmp[t++]='0'+e%10;
+		e/=10;
+	} while (e);
+	while (t) so_putc(so, tmp[--t]);
+}
+
+// returns true if value is NaN or Infinity (and outputs it like JavaScript does)
+static bool so_special(struct strout* so, double value) {
+	if (__builtin_isnan(value)) {
+		so_puts(so, "NaN");
+		return true;
+	}
+	if (__builtin_isinf(value)) {
+		so_puts(so, value<0?"-Infinity":"Infinity");
+		return true;
+	}
+	return false;
+}
+
+/****************************************************************/
+
+// Output matches JavaScript Number.toFixed(), except that values >= 1e21 are not switched to exponential format,
+// and dec_digits is not limited to 100.
+// does not use locale information; it always uses . (a dot) as the decimal separator.
+void twr_tofixed(char* buffer, int buffer_size, double value, int dec_digits) {
+	struct strout so={buffer, buffer_size, 0};
+	struct exact_decimal ed;
+
+	if (buffer_size<=0) return;
+	if (dec_digits<0) dec_digits=0;
+	if (dec_digits>buffer_size) dec_digits=buffer_size;  // won't fit anyway
+
+	if (!so_special(&so, value)) {
+		if (value<0) {  // -0 is printed as 0, like JavaScript
+			so_putc(&so, '-');
+			value=-value;
+		}
+
+		if (value==0) {
+			ed.nd=0;
+			ed.decpt=0;
+		}
+		else {
+			exact_decimal_new(&ed, value);
+			exact_decimal_round(&ed, ed.decpt+dec_digits);
+		}
+
+		if (ed.decpt<=0) {
+			so_putc(&so, '0');
+		}
+		else {
+			for (int i=0; i<ed.decpt; i++)
+				so_putc(&so, ed_digit(&ed, i));
+		}
+
+		if (dec_digits>0) {
+			so_putc(&so, '.');
+			for (int i=0; i<dec_digits; i++) so_putc(&so, ed_digit(&ed, ed.decpt+i));
+		}
+	}
+
+	buffer[so.pos]=0;
+}
+
+// Output matches JavaScript Number.toExponential(), except that dec_digits is not limited to 100.
+// does not use locale information; it always uses . (a dot) as the decimal separator.
+void twr_toexponential(char* buffer, int buffer_size, double value, int dec_digits) {
+	struct strout so={buffer, buffer_size, 0};
+	struct exact_decimal ed;
+	int e;
+
+	if (buffer_size<=0) return;
+	if (dec_digits<0) dec_digits=0;
+	if (dec_digits>buffer_size) dec_digits=buffer_size;  // won't fit anyway
+
+	if (!so_special(&so, value)) {
+		if (value<0) {
+			so_putc(&so, '-');
+			value=-value;
+		}
+
+		if (value==0) {
+			ed.nd=0;
+			e=0;
+		}
+		else {
+			exact_decimal_new(&ed, value);
+			exact_decimal_round(&ed, dec_digits+1);
+			e=ed.decpt-1;
+		}
+
+		so_putc(&so, ed_digit(&ed, 0));
+		if (dec_digits>0) {
+			so_putc(&so, '.');
+			for (int i=1; i<=dec_digits; i++) so_putc(&so, ed_digit(&ed, i));
+		}
+		so_putexp(&so, e);
+	}
+
+	buffer[so.pos]=0;
+}
+
+//The fcvt_s() function in C does not use locale information; it always uses . (a dot) as the decimal separator.
+// digits after the decimal point are limited only by sizeInBytes
+int _fcvt_s(
+   char* buffer,
+   unsigned long sizeInBytes, //size_t
+   double value,
+   int fracpart_numdigits,
+   int *dec,
+   int *sign
+) {
+	struct exact_decimal ed;
+
+	if (buffer==NULL || sign==NULL || dec==NULL || sizeInBytes<1) return 1;
+	if (fracpart_numdigits<0) fracpart_numdigits=0;
+
+	*sign=0;
+
+	if (__builtin_isnan(value)) {
+		char nanstr[]="1#QNAN00000000000000000000000000000";
+		nstrcopy(buffer, sizeInBytes, nanstr, sizeof(nanstr)-1, fracpart_numdigits+1);
+		*dec=1;
+		return 0;
+	}
+	else if (__builtin_isinf(value)) {
+		char infstr[]="1#INF00000000000000000000000000000";
+		nstrcopy(buffer, sizeInBytes, infstr, sizeof(infstr)-1, fracpart_numdigits+1);
+		*dec=1;
+		return 0;
+	}
+	else if (value==0) {
+		if (sizeInBytes-1 < (unsigned long)fracpart_numdigits) return 1;
+		memset(buffer, '0', fracpart_numdigits);
+		buffer[fracpart_numdigits]=0;
+		*dec=0;
+		return 0;
+	}
+
+	if (value<0) {
+		*sign=1;
+		value=-value;
+	}
+
+	exact_decimal_new(&ed, value);
+	exact_decimal_round(&ed, ed.decpt+fracpart_numdigits);
+
+	if (ed.nd==0) {   // rounds to zero
+		buffer[0]=0;
+		*dec=-fracpart_numdigits;
+		return 0;
+	}
+
+	const int len=ed.decpt+fracpart_numdigits;
+	if (sizeInBytes-1 < (unsigned long)len) return 1;
+	for (int i=0; i<len; i++) buffer[i]=ed_digit(&ed, i);
+	buffer[len]=0;
+	*dec=ed.decpt;
+
+	return 0;
+}
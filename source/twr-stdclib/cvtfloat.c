@@ -2,6 +2,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <math.h>
+#include <errno.h>
 #include "twr-crt.h"
 #include "twr-jsimports.h"
 
@@ -11,103 +12,13 @@ void twr_dtoa(char* buffer, int buffer_size, double value, int max_precision) {
     twrDtoa(buffer, buffer_size, value, max_precision);
 }
 
-// does not use locale information; it always uses . (a dot) as the decimal separator.
-void twr_tofixed(char* buffer, int buffer_size, double value, int dec_digits) {
-    twrToFixed(buffer, buffer_size, value, dec_digits);
-}
-
-// does not use locale information; it always uses . (a dot) as the decimal separator.
-void twr_toexponential(char* buffer, int buffer_size, double value, int dec_digits) {
-    twrToExponential(buffer, buffer_size, value, dec_digits);
-}
-
-//The fcvt_s() function in C does not use locale information; it always uses . (a dot) as the decimal separator.
-int _fcvt_s(
-   char* buffer,
-   unsigned long sizeInBytes, //size_t
-   double value,
-   int fracpart_numdigits,
-   int *dec,
-   int *sign
-) {
-    return twrFcvtS(buffer, sizeInBytes, value, fracpart_numdigits, dec, sign);
-}
+// twr_tofixed(), twr_toexponential() and _fcvt_s() are in cvtfixed.c
 
 /****************************************************************/
 /****************************************************************/
 /****************************************************************/
 
-// [whitespace] [sign] [digits] [.digits] [ {e | E }[sign]digits]
-// also allow (fortran style) d/D instead of e/E
-// use locale-specific decimal separators. 
-static void parse_ascfloat(char **str, char ** str_end, int *sign, bool *isInf, bool *isNan, char* decimal, locale_t locale) {
-	int len;
-
-	*decimal=__get_lconv_lc_numeric(locale)->decimal_point[0];
-
-	/** ignore leading space */
-	while (isspace_l(**str, locale)) (*str)++;
-	*sign=__atosign(*str, &len);
-	*isInf=false;
-	*isNan=false;
-	if (0==strnicmp(*str, "INFINITE", 8)) {
-		*isInf=true;
-		*str_end=*str+len+8;
-		return;
-	}
-	else if (0==strnicmp(*str, "INF", 3)) {
-		*isInf=true;
-		*str_end=*str+len+3;
-		return;
-	}
-	else if (0==strnicmp(*str, "NAN", 3)) {
-		*isNan=true;
-		*str_end=*str+len+3;
-		return;
-	}
-
-	*str_end=*str+len;
-	while (isdigit(**str_end)) (*str_end)++;
-	if (**str_end==*decimal) {
-		(*str_end)++;
-		while (isdigit(**str_end)) (*str_end)++;
-	}
-	if (**str_end=='e' || **str_end=='E' || **str_end=='d' || **str_end=='D') {
-		(*str_end)++;
-		if (**str_end=='+' || **str_end=='-') (*str_end)++;
-		while (isdigit(**str_end)) (*str_end)++;
-	}
-
-	return;
-}
-
-double strtod_l(const char *str, char **str_end, locale_t locale) {
-	const char *p=str;
-	bool isinf, isnan;
-	int sign;
-	char decimal;
-	char *dummy;
-	char **end;
-
-	if (str_end==NULL) 
-		end=&dummy;
-	else
-		end=str_end;
-
-	parse_ascfloat((char**)&p, end, &sign, &isinf, &isnan, &decimal, locale);
-
-	const int len=*end-p;
-	if (decimal=='.') {
-   	return twrAtod(p, len);
-	}
-	else {
-		char tmp[len];
-		memcpy(tmp, p, len);
-		char* dp=memchr(tmp, decimal, len);
-		if (dp) *dp='.';
-   	return twrAtod(tmp, len);
-	}
-}
+// strtod_l() and twr_from_chars_d() are in fastatod.c
 
 // strtod() does use locale-specific decimal separators. 
 // its behavior regarding the decimal point depends on the current locale settings.
@@ -155,62 +66,55 @@ double twr_infval() {
 }
 
 /**************************************************/
+static int same_double(double a, double b) {
+	return memcmp(&a, &b, sizeof(double))==0;
+}
+
 int cvtfloat_unit_test() {
-	bool isinf, isnan;
-	int sign;
 	char* end;
-	char dec;
+	double r;
+	struct twr_from_chars_result fc;
 
 	char *x="1";
-	parse_ascfloat(&x, &end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (end!=x+1 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=1.0 || end!=x+1) return 0;
 
 	x="-1";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (end!=x+2 || sign!=-1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=-1.0 || end!=x+2) return 0;
 
 	x="1.1";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (end!=x+3 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=1.1 || end!=x+3) return 0;
 
 	x=" +123";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (*x!='+' || end!=x+4 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=123.0 || end!=x+5) return 0;
 
 	x="-1.1e+3";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (end!=x+7 || sign!=-1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=-1100.0 || end!=x+7) return 0;
 
 	x="1.1D4";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec, twr_get_current_locale());
-	if (end!=x+5 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=11000.0 || end!=x+5) return 0;
 
 	x="1.1D-4";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec,  twr_get_current_locale());
-	if (end!=x+6 || sign!=1 || isinf!=false || isnan!=false) return 0;
-
-	x="1d1";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec,  twr_get_current_locale());
-	if (end!=x+3 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=1.1e-4 || end!=x+6) return 0;
 
 	x="1fd1";
-	parse_ascfloat(&x,&end, &sign, &isinf, &isnan, &dec,  twr_get_current_locale());
-	if (end!=x+1 || sign!=1 || isinf!=false || isnan!=false) return 0;
+	if (strtod(x, &end)!=1.0 || end!=x+1) return 0;
 
 	x="1d1";
 	if (10.0 != strtod(x,&end)) return 0;
 	if (end!=x+3) return 0;
 
-	x="1d1";
-	if (10.0 != strtod(x,&end)) return 0;
-	if (end!=x+3) return 0;
+	x="2e";  // exponent without digits isn't part of the number
+	if (strtod(x, &end)!=2.0 || end!=x+1) return 0;
+
+	x=" .";
+	if (strtod(x, &end)!=0.0 || end!=x) return 0;
 
 	x = "111.11 -2.22 Nan inF 1.18973e+33zzz";
    if (strtod(x, &end)!=111.11) return 0;
 	x = end;
    if (strtod(x, &end)!=-2.22) return 0;
 	x = end;
-   double r=strtod(x, &end);
+   r=strtod(x, &end);
 	if (!isnan(r)) return 0;
 	x = end;
    r=strtod(x, &end);
@@ -218,14 +122,42 @@ int cvtfloat_unit_test() {
 	x = end;
    if (strtod(x, &end)!=1.18973e+33) return 0;
 
+	// these need Eisel-Lemire, not the fast path
+	if (!same_double(strtod("2.2250738585072014e-308", NULL), 2.2250738585072014e-308)) return 0;
+	if (!same_double(strtod("1.7976931348623157e308", NULL), 1.7976931348623157e308)) return 0;
+	if (!same_double(strtod("4.9406564584124654e-324", NULL), 4.9406564584124654e-324)) return 0;
+	if (!same_double(strtod("9007199254740993", NULL), 9007199254740992.0)) return 0;
+	if (!same_double(strtod("123456789012345678", NULL), 123456789012345678.0)) return 0;
+	if (!same_double(strtod("0.30000000000000004", NULL), 0.30000000000000004)) return 0;
+	if (!same_double(strtod("-8.41e-300", NULL), -8.41e-300)) return 0;
+	if (!same_double(strtod("3.14159265358979323846264338327950288", NULL), 3.14159265358979323846264338327950288)) return 0;
+	if (!same_double(strtod("0.000000000000000000000000000001234567890123456789012", NULL), 1.234567890123456789012e-30)) return 0;
+	if (!same_double(strtod("-0", NULL), -0.0)) return 0;
+
+	errno=0;
+	if (!isinf(strtod("1e309", NULL)) || errno!=ERANGE) return 0;
+	errno=0;
+	if (strtod("1e-400", NULL)!=0.0 || errno!=ERANGE) return 0;
+
+	// from_chars doesn't need a zero terminated string
+	x="12.5e1";
+	fc=twr_from_chars_d(x, x+4, &r);
+	if (r!=12.5 || fc.ptr!=x+4 || fc.ec!=0) return 0;
+	r=7.0;
+	fc=twr_from_chars_d(x, x, &r);
+	if (r!=7.0 || fc.ptr!=x || fc.ec!=EINVAL) return 0;
+	fc=twr_from_chars_d(x, x+6, &r);
+	if (r!=125.0 || fc.ptr!=x+6) return 0;
+
 	const char *lstr=setlocale(LC_ALL, "");
 	if (strncmp(lstr,"fr",2)==0) {
 		x="100,12";
 		r=strtod(x,&end);
 		if (100.12 != r) return 0;
 		if (end!=x+6) return 0;
+		fc=twr_from_chars_d_l(x, x+6, &r, twr_get_current_locale());
+		if (100.12 != r || fc.ptr!=x+6) return 0;
 	}
 
-
 	return 1;
 }
@@ -4,6 +4,7 @@
 #include <string.h>
 #include <stdlib.h>
 #include <limits.h>
+#include <stdint.h>
 #include "twr-crt.h"
 
 static int detect_base(const char* str, int * len) {
@@ -170,34 +171,91 @@ unsigned long strtoul(const char *str, char **str_end,  int base) {
 /****************************************************************/
 /****************************************************************/
 
+static const char digit_pairs[201]=
+	"00010203040506070809"
+	"10111213141516171819"
+	"20212223242526272829"
+	"30313233343536373839"
+	"40414243444546474849"
+	"50515253545556575859"
+	"60616263646566676869"
+	"70717273747576777879"
+	"80818283848586878889"
+	"90919293949596979899";
+
+// two digits per division, copied from digit_pairs
+static inline char* u32toa_dec_end(uint32_t value, char* p) {
+	while (value>=100) {
+		const uint32_t r=value%100;
+		value/=100;
+		p-=2;
+		memcpy(p, digit_pairs+r*2, 2);
+	}
+	if (value>=10) {
+		p-=2;
+		memcpy(p, digit_pairs+value*2, 2);
+	}
+	else {
+		*--p='0'+value;
+	}
+	return p;
+}
+
+// The digits of value are written backwards, so that the last digit is at end[-1].  Returns the number of digits, which is
+// at least one (for zero) and at most 64 (radix 2).  radix must be 2 to 36.
+// Used by printf and _itoa_s.  Base 10 is converted two digits at a time, and 32 bits at a time once the value fits.
+int twr_u64toa_end(uint64_t value, char* end, int radix, bool uppercase) {
+	const char *digitchars=uppercase?"0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ":"0123456789abcdefghijklmnopqrstuvwxyz";
+	char* p=end;
+
+	if (radix==10) {
+		while (value>UINT32_MAX) {
+			uint32_t low=(uint32_t)(value%1000000000);   // 9 digits
+			value/=1000000000;
+			for (int i=0; i<4; i++) {
+				p-=2;
+				memcpy(p, digit_pairs+(low%100)*2, 2);
+				low/=100;
+			}
+			*--p='0'+low;
+		}
+		p=u32toa_dec_end((uint32_t)value, p);
+	}
+	else if (radix==16 || radix==8 || radix==2) {
+		const int shift=radix==16?4:(radix==8?3:1);
+		do {
+			*--p=digitchars[value&(radix-1)];
+			value>>=shift;
+		} while (value);
+	}
+	else {
+		do {
+			*--p=digitchars[value%radix];
+			value/=radix;
+		} while (value);
+	}
+
+	return end-p;
+}
+
 int _itoa_s(int64_t value, char * buffer, size_t size, int radix) {
-	size_t i=0;
-	const char *digitchars="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	char digits[64];
 
 	if (size < 1) return 1;  /* error - buffer too small */
 		
 	if (radix < 2 || radix > 36)
 		return 2;  /* invalid radix */
 
-	if (value<0) {
-		value=-value;
-		if (size < 3) return 1;  /* error - buffer too small */
-		buffer[i++]='-';
-	}
+	const bool negative=value<0;
+	const uint64_t magnitude=negative ? 0-(uint64_t)value : (uint64_t)value;  // INT64_MIN safe
+	const size_t n=twr_u64toa_end(magnitude, digits+sizeof(digits), radix, true);
 
-	const int istart=i;
+	if (negative+n+1 > size) return 1; /* error - buffer too small */
 
-	while (1) {
-		if (i>=(size-1)) return 1; /* error - buffer too small */
-		int digit=value%radix;
-		buffer[i++]=digitchars[digit];
-		value=value/radix;
-		if (value==0) {
-			twr_strhorizflip(buffer+istart, i-istart);
-			buffer[i]=0;
-			return 0;
-		}
-	}
+	if (negative) *buffer++='-';
+	memcpy(buffer, digits+sizeof(digits)-n, n);
+	buffer[n]=0;
+	return 0;
 }
 
 #pragma clang optimize off
@@ -342,6 +400,20 @@ int cvtint_unit_test() {
 	if (_itoa_s(0, buffer, 2, 10)!=0) return 0;
 	if (strcmp(buffer, "0")!=0) return 0;
 
+	if (_itoa_s(INT64_MIN, buffer, sizeof(buffer), 10)!=0) return 0;
+	if (strcmp(buffer, "-9223372036854775808")!=0) return 0;
+	if (_itoa_s(1234567890123456789LL, buffer, 20, 10)!=0) return 0;
+	if (strcmp(buffer, "1234567890123456789")!=0) return 0;
+	if (_itoa_s(1234567890123456789LL, buffer, 19, 10)==0) return 0;
+	if (_itoa_s(-255, buffer, sizeof(buffer), 16)!=0) return 0;
+	if (strcmp(buffer, "-FF")!=0) return 0;
+	if (_itoa_s(35, buffer, sizeof(buffer), 36)!=0) return 0;
+	if (strcmp(buffer, "Z")!=0) return 0;
+	if (twr_u64toa_end(UINT64_MAX, buffer+64, 10, false)!=20 || strncmp(buffer+44, "18446744073709551615", 20)!=0) return 0;
+	if (twr_u64toa_end(UINT64_MAX, buffer+64, 8, false)!=22 || strncmp(buffer+42, "1777777777777777777777", 22)!=0) return 0;
+	if (twr_u64toa_end(0xABCDEF, buffer+64, 16, false)!=6 || strncmp(buffer+58, "abcdef", 6)!=0) return 0;
+	if (twr_u64toa_end(100, buffer+64, 10, false)!=3 || strncmp(buffer+61, "100", 3)!=0) return 0;
+
 	return 1;
 }
 
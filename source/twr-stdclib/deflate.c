@@ -0,0 +1,883 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "twr-zlib.h"
+
+// DEFLATE compression (RFC 1951), with zlib (RFC 1950) or gzip (RFC 1952) framing
+//
+// Matches are found with hash chains, as in zlib, but over a 16K window so that a compressor needs about 100K of
+// memory.  Levels 1 to 3 use the first match that is long enough, and 4 to 9 check whether a longer match starts at
+// the next byte (lazy matching).  Higher levels follow the hash chains further.  Each block of up to LIT_BUFSIZE
+// symbols is sent with whichever of its own Huffman code, the fixed code, or no compression (stored) is smallest.
+//
+// Output is written straight to the caller's buffer.  If it fills part way through a block, the rest of the block is
+// sent on the next call, before any more input is used.
+
+#define WBITS 14
+#define WSIZE (1<<WBITS)
+#define WMASK (WSIZE-1)
+#define HASH_BITS 13
+#define MIN_MATCH 3
+#define MAX_MATCH 258
+#define MIN_LOOKAHEAD (MAX_MATCH+MIN_MATCH+1)
+#define MAX_DIST (WSIZE-MIN_LOOKAHEAD)
+#define TOO_FAR 4096		// a 3 byte match further back than this costs more than 3 literals
+#define LIT_BUFSIZE 8192
+#define L_CODES 286
+#define D_CODES 30
+#define BL_CODES 19
+#define MAX_BITS 15
+#define MAX_BL_BITS 7
+
+static const struct {uint16_t good, lazy, nice, chain;} config[10]={
+	{0, 0, 0, 0},		// stored
+	{4, 4, 8, 4},		// levels 1 to 3: lazy is the longest match that every position of is hashed
+	{4, 5, 16, 8},
+	{4, 6, 32, 32},
+	{4, 4, 16, 16},
+	{8, 16, 32, 32},
+	{8, 16, 128, 128},
+	{8, 32, 128, 256},
+	{32, 128, 258, 1024},
+	{32, 258, 258, 4096}
+};
+
+struct tree {
+	uint16_t code[288];	// bit reversed, so that it can be sent low bit first
+	uint8_t len[288];
+};
+
+enum {PH_IDLE, PH_PEND, PH_HEADER, PH_BL, PH_LENS, PH_SYMS, PH_EOB, PH_STORED, PH_STORED_DATA, PH_FINISH, PH_DONE};
+enum {NEED_INPUT, BLOCK_FULL, INPUT_DONE};
+
+struct outbuf {
+	uint8_t* out;
+	uint8_t* end;
+};
+
+struct twr_deflate {
+	int format;
+	int level;
+	unsigned good_length, max_lazy, nice_length, max_chain;
+
+	// output
+	int phase;
+	uint64_t bitbuf;
+	int bitcnt;
+	uint8_t pend[16];	// header or trailer bytes
+	int pend_len, pend_pos, after_pend;
+
+	// input, and matching
+	uint8_t* window;	// 2*WSIZE.  Slides down by WSIZE when strstart gets near the end
+	uint16_t* head;		// the latest position with each hash, or 0
+	uint16_t* prev;		// the previous position with the same hash as position&WMASK
+	unsigned strstart, lookahead;
+	unsigned match_start, match_length, prev_length;
+	bool match_available;	// lazy matching: the byte before strstart hasn't been sent yet
+	long block_start, block_end;	// the input in the current block.  block_start is <0 once it slides out of the window
+	uint32_t check, total;
+
+	// the current block
+	uint8_t* sym_lit;	// literal, or match length-3
+	uint16_t* sym_dist;	// match distance, or 0 for a literal
+	unsigned nsyms;
+	uint16_t freq_l[L_CODES], freq_d[D_CODES];
+	bool last;
+	int btype;
+	const struct tree* ltree;
+	const struct tree* dtree;
+	struct tree lt, dt, bt;
+	int hlit, hdist, hclen;
+	uint8_t rle[L_CODES+D_CODES];		// code lengths, run length coded with the bt symbols 0-18
+	uint8_t rle_extra[L_CODES+D_CODES];
+	int nrle;
+	unsigned emit_i;
+};
+
+static const uint8_t len_extra[29]={0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint8_t dist_extra[30]={0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+static const uint8_t clen_order[BL_CODES]={16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+
+static uint8_t len_code[256];		// match length-3 to length code
+static uint16_t len_base[29];		// length code to the first length-3
+static uint8_t dist_code[512];		// see d_code()
+static uint16_t dist_base[30];		// distance code to the first distance-1
+static struct tree fixed_lt, fixed_dt;
+static bool tables_built;
+
+static int reverse(int code, int len) {
+	int rev=0;
+	for (int b=0; b<len; b++)
+		rev|=((code>>b)&1)<<(len-1-b);
+	return rev;
+}
+
+// canonical codes for the lengths in t
+static void build_codes(struct tree* t, int n) {
+	int count[MAX_BITS+1]={0}, next[MAX_BITS+1];
+	for (int i=0; i<n; i++)
+		count[t->len[i]]++;
+	count[0]=0;
+
+	int code=0;
+	for (int len=1; len<=MAX_BITS; len++) {
+		code=(code+count[len-1])<<1;
+		next[len]=code;
+	}
+	for (int i=0; i<n; i++)
+		if (t->len[i]) t->code[i]=reverse(next[t->len[i]]++, t->len[i]);
+}
+
+static void build_tables(void) {
+	int len=0;
+	for (int code=0; code<28; code++) {
+		len_base[code]=len;
+		for (int n=0; n<(1<<len_extra[code]); n++)
+			len_code[len++]=code;
+	}
+	len_base[28]=255;
+	len_code[255]=28;		// length 258 has its own code
+
+	int dist=0, code;
+	for (code=0; code<16; code++) {
+		dist_base[code]=dist;
+		for (int n=0; n<(1<<dist_extra[code]); n++)
+			dist_code[dist++]=code;
+	}
+	dist>>=7;
+	for (; code<D_CODES; code++) {
+		dist_base[code]=dist<<7;
+		for (int n=0; n<(1<<(dist_extra[code]-7)); n++)
+			dist_code[256+dist++]=code;
+	}
+
+	int i=0;
+	while (i<144) fixed_lt.len[i++]=8;
+	while (i<256) fixed_lt.len[i++]=9;
+	while (i<280) fixed_lt.len[i++]=7;
+	while (i<288) fixed_lt.len[i++]=8;
+	build_codes(&fixed_lt, 288);
+	for (i=0; i<D_CODES; i++) fixed_dt.len[i]=5;
+	build_codes(&fixed_dt, D_CODES);
+
+	tables_built=true;
+}
+
+// the distance code of distance-1
+static inline int d_code(unsigned d) {
+	return d<256 ? dist_code[d] : dist_code[256+(d>>7)];
+}
+
+//*************************************************
+// Huffman code lengths
+
+struct sym_freq {
+	uint32_t key;		// the frequency, then (in minimum_redundancy) the code length
+	uint16_t sym;
+};
+
+// Moffat and Katajainen's in place calculation of the code lengths for frequencies sorted lowest first
+static void minimum_redundancy(struct sym_freq* a, int n) {
+	int root, leaf, next, avbl, used, dpth;
+
+	if (n==1) {
+		a[0].key=1;
+		return;
+	}
+
+	a[0].key+=a[1].key;
+	root=0;
+	leaf=2;
+	for (next=1; next<n-1; next++) {
+		if (leaf>=n || a[root].key<a[leaf].key) {
+			a[next].key=a[root].key;
+			a[root++].key=next;
+		}
+		else {
+			a[next].key=a[leaf++].key;
+		}
+		if (leaf>=n || (root<next && a[root].key<a[leaf].key)) {
+			a[next].key+=a[root].key;
+			a[root++].key=next;
+		}
+		else {
+			a[next].key+=a[leaf++].key;
+		}
+	}
+
+	a[n-2].key=0;
+	for (next=n-3; next>=0; next--)
+		a[next].key=a[a[next].key].key+1;
+
+	avbl=1;
+	used=dpth=0;
+	root=n-2;
+	next=n-1;
+	while (avbl>0) {
+		while (root>=0 && (int)a[root].key==dpth) {
+			used++;
+			root--;
+		}
+		while (avbl>used) {
+			a[next--].key=dpth;
+			avbl--;
+		}
+		avbl=2*used;
+		dpth++;
+		used=0;
+	}
+}
+
+// code lengths of at most max_len bits for the n symbols with frequencies freq.  There are always at least two codes,
+// since some decoders need them
+static void build_lengths(struct tree* t, const uint16_t* freq, int n, int max_len) {
+	struct sym_freq a[L_CODES];
+	int used=0;
+
+	memset(t->len, 0, n);
+	for (int i=0; i<n; i++)
+		if (freq[i]) a[used++]=(struct sym_freq){freq[i], i};
+	for (int i=0; used<2; i++)
+		if (!freq[i]) a[used++]=(struct sym_freq){1, i};
+
+	for (int i=1; i<used; i++) {		// insertion sort, lowest frequency first
+		const struct sym_freq x=a[i];
+		int j=i;
+		for (; j>0 && a[j-1].key>x.key; j--)
+			a[j]=a[j-1];
+		a[j]=x;
+	}
+
+	minimum_redundancy(a, used);
+
+	int count[33]={0};
+	for (int i=0; i<used; i++)
+		count[a[i].key<32 ? a[i].key : 32]++;
+
+	// move codes that are too long up, and make the code complete again by lengthening shorter ones
+	for (int i=max_len+1; i<=32; i++)
+		count[max_len]+=count[i];
+	uint32_t total=0;
+	for (int i=max_len; i>0; i--)
+		total+=(uint32_t)count[i]<<(max_len-i);
+	while (total!=(1u<<max_len)) {
+		count[max_len]--;
+		for (int i=max_len-1; i>0; i--) {
+			if (count[i]) {
+				count[i]--;
+				count[i+1]+=2;
+				break;
+			}
+		}
+		total--;
+	}
+
+	// the most frequent symbols get the shortest codes
+	int j=used;
+	for (int len=1; len<=max_len; len++)
+		for (int c=count[len]; c>0; c--)
+			t->len[a[--j].sym]=len;
+
+	build_codes(t, n);
+}
+
+//*************************************************
+// output
+
+#define PUT(z, value, n) do { (z)->bitbuf|=(uint64_t)(value)<<(z)->bitcnt; (z)->bitcnt+=(n); } while (0)
+
+// move whole bytes of bitbuf to the output.  Returns true if there is room in bitbuf for 48 more bits
+static inline bool room(struct twr_deflate* z, struct outbuf* w) {
+	if (w->end-w->out>=8) {
+		memcpy(w->out, &z->bitbuf, 8);
+		w->out+=z->bitcnt>>3;
+		z->bitbuf>>=z->bitcnt&~7;
+		z->bitcnt&=7;
+		return true;
+	}
+
+	while (z->bitcnt>=8 && w->out<w->end) {
+		*w->out++=(uint8_t)z->bitbuf;
+		z->bitbuf>>=8;
+		z->bitcnt-=8;
+	}
+	return z->bitcnt<16;
+}
+
+static bool flush_bits(struct twr_deflate* z, struct outbuf* w) {
+	while (z->bitcnt>0) {
+		if (w->out==w->end) return false;
+		*w->out++=(uint8_t)z->bitbuf;
+		z->bitbuf>>=8;
+		z->bitcnt=z->bitcnt>8 ? z->bitcnt-8 : 0;
+	}
+	return true;
+}
+
+static void put_be32(uint8_t* p, uint32_t v) {
+	p[0]=v>>24;
+	p[1]=v>>16;
+	p[2]=v>>8;
+	p[3]=v;
+}
+
+static void put_le32(uint8_t* p, uint32_t v) {
+	p[0]=v;
+	p[1]=v>>8;
+	p[2]=v>>16;
+	p[3]=v>>24;
+}
+
+static void block_done(struct twr_deflate* z) {
+	z->block_start=z->block_end;
+	z->nsyms=0;
+	memset(z->freq_l, 0, sizeof(z->freq_l));
+	memset(z->freq_d, 0, sizeof(z->freq_d));
+	z->phase=z->last ? PH_FINISH : PH_IDLE;
+}
+
+// send what is pending: a header or trailer, or the current block.  Returns false if the output fills first
+static bool emit(struct twr_deflate* z, struct outbuf* w) {
+	for (;;) {
+		switch (z->phase) {
+			case PH_IDLE:
+			case PH_DONE:
+				return true;
+
+			case PH_PEND:
+				while (z->pend_pos<z->pend_len) {
+					if (w->out==w->end) return false;
+					*w->out++=z->pend[z->pend_pos++];
+				}
+				z->phase=z->after_pend;
+				break;
+
+			case PH_HEADER:
+				if (!room(z, w)) return false;
+				PUT(z, z->last | z->btype<<1, 3);
+				if (z->btype==2) {
+					PUT(z, z->hlit-257, 5);
+					PUT(z, z->hdist-1, 5);
+					PUT(z, z->hclen-4, 4);
+					z->phase=PH_BL;
+				}
+				else {
+					z->phase=z->btype==1 ? PH_SYMS : PH_STORED;
+				}
+				z->emit_i=0;
+				break;
+
+			case PH_BL:
+				for (; z->emit_i<(unsigned)z->hclen; z->emit_i++) {
+					if (!room(z, w)) return false;
+					PUT(z, z->bt.len[clen_order[z->emit_i]], 3);
+				}
+				z->emit_i=0;
+				z->phase=PH_LENS;
+				break;
+
+			case PH_LENS:
+				for (; z->emit_i<(unsigned)z->nrle; z->emit_i++) {
+					if (!room(z, w)) return false;
+					const int sym=z->rle[z->emit_i];
+					PUT(z, z->bt.code[sym], z->bt.len[sym]);
+					if (sym==16) PUT(z, z->rle_extra[z->emit_i], 2);
+					else if (sym==17) PUT(z, z->rle_extra[z->emit_i], 3);
+					else if (sym==18) PUT(z, z->rle_extra[z->emit_i], 7);
+				}
+				z->emit_i=0;
+				z->phase=PH_SYMS;
+				break;
+
+			case PH_SYMS:
+			{
+				const struct tree* const lt=z->ltree;
+				const struct tree* const dt=z->dtree;
+				for (; z->emit_i<z->nsyms; z->emit_i++) {
+					if (!room(z, w)) return false;
+					const unsigned lc=z->sym_lit[z->emit_i];
+					const unsigned dist=z->sym_dist[z->emit_i];
+					if (dist==0) {
+						PUT(z, lt->code[lc], lt->len[lc]);
+					}
+					else {
+						const int code=len_code[lc];
+						PUT(z, lt->code[257+code], lt->len[257+code]);
+						PUT(z, lc-len_base[code], len_extra[code]);
+						const int dcode=d_code(dist-1);
+						PUT(z, dt->code[dcode], dt->len[dcode]);
+						PUT(z, dist-1-dist_base[dcode], dist_extra[dcode]);
+					}
+				}
+				z->phase=PH_EOB;
+				break;
+			}
+
+			case PH_EOB:
+				if (!room(z, w)) return false;
+				PUT(z, z->ltree->code[256], z->ltree->len[256]);
+				block_done(z);
+				break;
+
+			case PH_STORED:
+			{
+				if (!room(z, w)) return false;
+				const unsigned len=z->block_end-z->block_start;
+				z->bitcnt=(z->bitcnt+7)&~7;
+				PUT(z, len, 16);
+				PUT(z, ~len&0xffff, 16);
+				z->phase=PH_STORED_DATA;
+				break;
+			}
+
+			case PH_STORED_DATA:
+			{
+				if (!flush_bits(z, w)) return false;
+				const unsigned len=z->block_end-z->block_start;
+				size_t n=len-z->emit_i;
+				if (n>(size_t)(w->end-w->out)) n=w->end-w->out;
+				memcpy(w->out, z->window+z->block_start+z->emit_i, n);
+				w->out+=n;
+				z->emit_i+=n;
+				if (z->emit_i<len) return false;
+				block_done(z);
+				break;
+			}
+
+			case PH_FINISH:
+				z->bitcnt=(z->bitcnt+7)&~7;
+				if (!flush_bits(z, w)) return false;
+				z->pend_pos=0;
+				z->pend_len=0;
+				if (z->format==TWR_Z_ZLIB) {
+					put_be32(z->pend, z->check);
+					z->pend_len=4;
+				}
+				else if (z->format==TWR_Z_GZIP) {
+					put_le32(z->pend, z->check);
+					put_le32(z->pend+4, z->total);
+					z->pend_len=8;
+				}
+				z->after_pend=PH_DONE;
+				z->phase=PH_PEND;
+				break;
+		}
+	}
+}
+
+// choose how to send the current block, and start sending it
+static void start_block(struct twr_deflate* z, bool last) {
+	z->last=last;
+	const unsigned raw=z->block_end-z->block_start;
+
+	if (z->level==0) {
+		z->btype=0;
+		z->phase=PH_HEADER;
+		return;
+	}
+
+	z->freq_l[256]=1;
+	build_lengths(&z->lt, z->freq_l, L_CODES, MAX_BITS);
+	build_lengths(&z->dt, z->freq_d, D_CODES, MAX_BITS);
+
+	z->hlit=L_CODES;
+	while (z->hlit>257 && z->lt.len[z->hlit-1]==0) z->hlit--;
+	z->hdist=D_CODES;
+	while (z->hdist>1 && z->dt.len[z->hdist-1]==0) z->hdist--;
+
+	// run length code the code lengths
+	uint8_t lens[L_CODES+D_CODES];
+	uint16_t bl_freq[BL_CODES]={0};
+	const int n=z->hlit+z->hdist;
+	memcpy(lens, z->lt.len, z->hlit);
+	memcpy(lens+z->hlit, z->dt.len, z->hdist);
+	z->nrle=0;
+
+#define ADD_RLE(sym, extra) do { z->rle[z->nrle]=(sym); z->rle_extra[z->nrle++]=(extra); bl_freq[sym]++; } while (0)
+	for (int i=0; i<n; ) {
+		const int v=lens[i];
+		int run=1;
+		while (i+run<n && lens[i+run]==v) run++;
+
+		if (v==0 && run>=3) {
+			const int r=run>138 ? 138 : run;
+			if (r>=11) ADD_RLE(18, r-11);
+			else ADD_RLE(17, r-3);
+			i+=r;
+		}
+		else if (v!=0 && run>=4) {
+			ADD_RLE(v, 0);
+			i++;
+			run--;
+			while (run>=3) {
+				const int r=run>6 ? 6 : run;
+				ADD_RLE(16, r-3);
+				i+=r;
+				run-=r;
+			}
+		}
+		else {
+			ADD_RLE(v, 0);
+			i++;
+		}
+	}
+#undef ADD_RLE
+
+	build_lengths(&z->bt, bl_freq, BL_CODES, MAX_BL_BITS);
+	z->hclen=BL_CODES;
+	while (z->hclen>4 && z->bt.len[clen_order[z->hclen-1]]==0) z->hclen--;
+
+	// the size in bits of each way of sending the block
+	unsigned long dyn=3+14+3*z->hclen;
+	for (int i=0; i<z->nrle; i++) {
+		const int sym=z->rle[i];
+		dyn+=z->bt.len[sym] + (sym==16 ? 2 : sym==17 ? 3 : sym==18 ? 7 : 0);
+	}
+	unsigned long fixed=3;
+	for (int i=0; i<L_CODES; i++) {
+		const int extra=i>=257 ? len_extra[i-257] : 0;
+		dyn+=(unsigned long)z->freq_l[i]*(z->lt.len[i]+extra);
+		fixed+=(unsigned long)z->freq_l[i]*(fixed_lt.len[i]+extra);
+	}
+	for (int i=0; i<D_CODES; i++) {
+		dyn+=(unsigned long)z->freq_d[i]*(z->dt.len[i]+dist_extra[i]);
+		fixed+=(unsigned long)z->freq_d[i]*(5+dist_extra[i]);
+	}
+	unsigned long stored=(unsigned long)-1;
+	if (z->block_start>=0 && raw<=65535)
+		stored=((z->bitcnt+3+7)&~7)-z->bitcnt+32+8UL*raw;
+
+	if (stored<=fixed && stored<=dyn) {
+		z->btype=0;
+	}
+	else if (fixed<=dyn) {
+		z->btype=1;
+		z->ltree=&fixed_lt;
+		z->dtree=&fixed_dt;
+	}
+	else {
+		z->btype=2;
+		z->ltree=&z->lt;
+		z->dtree=&z->dt;
+	}
+	z->phase=PH_HEADER;
+}
+
+//*************************************************
+// input, and finding matches
+
+static inline unsigned hash(const uint8_t* p) {
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return ((v&0xffffff)*2654435761u)>>(32-HASH_BITS);
+}
+
+// add pos to its hash chain, and return the previous position with the same hash (or 0)
+static inline unsigned insert(struct twr_deflate* z, unsigned pos) {
+	const unsigned h=hash(z->window+pos);
+	const unsigned prev=z->head[h];
+	z->prev[pos&WMASK]=prev;
+	z->head[h]=pos;
+	return prev;
+}
+
+static void fill_window(struct twr_deflate* z, const uint8_t** in, const uint8_t* in_end) {
+	if (z->strstart>=WSIZE+MAX_DIST) {	// slide
+		memcpy(z->window, z->window+WSIZE, z->strstart+z->lookahead-WSIZE);
+		z->match_start-=WSIZE;
+		z->strstart-=WSIZE;
+		z->block_start-=WSIZE;
+		if (z->head) {
+			for (int i=0; i<(1<<HASH_BITS); i++)
+				z->head[i]=z->head[i]>=WSIZE ? z->head[i]-WSIZE : 0;
+			for (int i=0; i<WSIZE; i++)
+				z->prev[i]=z->prev[i]>=WSIZE ? z->prev[i]-WSIZE : 0;
+		}
+	}
+
+	size_t n=2*WSIZE-(z->strstart+z->lookahead);
+	if (n>(size_t)(in_end-*in)) n=in_end-*in;
+	uint8_t* const dest=z->window+z->strstart+z->lookahead;
+	memcpy(dest, *in, n);
+	if (z->format==TWR_Z_ZLIB) z->check=twr_adler32(z->check, dest, n);
+	else if (z->format==TWR_Z_GZIP) z->check=twr_crc32(z->check, dest, n);
+	z->total+=n;
+	*in+=n;
+	z->lookahead+=n;
+}
+
+// the longest match at strstart that is longer than prev_length, starting with the chain at cur.  Sets match_start
+static unsigned longest_match(struct twr_deflate* z, unsigned cur) {
+	const uint8_t* const scan=z->window+z->strstart;
+	const unsigned limit=z->strstart>MAX_DIST ? z->strstart-MAX_DIST : 0;
+	const unsigned maxlen=z->lookahead<MAX_MATCH ? z->lookahead : MAX_MATCH;
+	unsigned chain=z->max_chain;
+	unsigned nice=z->nice_length;
+	unsigned best=z->prev_length;
+
+	if (best>=maxlen) return best;
+	if (best>=z->good_length) chain>>=2;
+	if (nice>maxlen) nice=maxlen;
+
+	do {
+		const uint8_t* const m=z->window+cur;
+		if (m[best]!=scan[best] || m[0]!=scan[0] || m[1]!=scan[1] || m[2]!=scan[2]) continue;
+
+		// 8 bytes at a time.  The window has 8 bytes of padding, and len is limited to maxlen after
+		unsigned len=3;
+		for (;;) {
+			uint64_t a, b;
+			memcpy(&a, m+len, 8);
+			memcpy(&b, scan+len, 8);
+			if (a!=b) {
+				len+=__builtin_ctzll(a^b)>>3;
+				break;
+			}
+			len+=8;
+			if (len>=maxlen) break;
+		}
+		if (len>maxlen) len=maxlen;
+
+		if (len>best) {
+			z->match_start=cur;
+			best=len;
+			if (len>=nice) break;
+		}
+	} while ((cur=z->prev[cur&WMASK])>limit && --chain);
+
+	return best;
+}
+
+static inline void tally_lit(struct twr_deflate* z, unsigned c) {
+	z->sym_lit[z->nsyms]=c;
+	z->sym_dist[z->nsyms++]=0;
+	z->freq_l[c]++;
+}
+
+static inline void tally_match(struct twr_deflate* z, unsigned dist, unsigned len) {
+	z->sym_lit[z->nsyms]=len-MIN_MATCH;
+	z->sym_dist[z->nsyms++]=dist;
+	z->freq_l[257+len_code[len-MIN_MATCH]]++;
+	z->freq_d[d_code(dist-1)]++;
+}
+
+// add symbols to the block until it is full, or the input runs out
+static int compress(struct twr_deflate* z, const uint8_t** in, const uint8_t* in_end, bool finish) {
+	for (;;) {
+		if (z->lookahead<MIN_LOOKAHEAD) {
+			fill_window(z, in, in_end);
+			if (z->lookahead<MIN_LOOKAHEAD && !finish) return NEED_INPUT;
+			if (z->lookahead==0) break;
+		}
+
+		unsigned hash_head=0;
+		if (z->lookahead>=MIN_MATCH) hash_head=insert(z, z->strstart);
+
+		if (z->level<=3) {
+			unsigned len=0;
+			if (hash_head && z->strstart-hash_head<=MAX_DIST) {
+				z->prev_length=MIN_MATCH-1;
+				len=longest_match(z, hash_head);
+			}
+
+			if (len>=MIN_MATCH) {
+				tally_match(z, z->strstart-z->match_start, len);
+				z->lookahead-=len;
+				if (len<=z->max_lazy && z->lookahead>=MIN_MATCH) {
+					while (--len) insert(z, ++z->strstart);
+					z->strstart++;
+				}
+				else {
+					z->strstart+=len;
+				}
+			}
+			else {
+				tally_lit(z, z->window[z->strstart]);
+				z->strstart++;
+				z->lookahead--;
+			}
+
+			if (z->nsyms>=LIT_BUFSIZE-1) {
+				z->block_end=z->strstart;
+				return BLOCK_FULL;
+			}
+		}
+		else {
+			z->prev_length=z->match_length;
+			const unsigned prev_match=z->match_start;
+			z->match_length=MIN_MATCH-1;
+
+			if (hash_head && z->prev_length<z->max_lazy && z->strstart-hash_head<=MAX_DIST) {
+				z->match_length=longest_match(z, hash_head);
+				if (z->match_length==MIN_MATCH && z->strstart-z->match_start>TOO_FAR)
+					z->match_length=MIN_MATCH-1;
+			}
+
+			if (z->prev_length>=MIN_MATCH && z->match_length<=z->prev_length) {
+				// the match at the previous byte is better
+				const unsigned max_insert=z->strstart+z->lookahead-MIN_MATCH;
+				tally_match(z, z->strstart-1-prev_match, z->prev_length);
+				z->lookahead-=z->prev_length-1;
+				z->prev_length-=2;
+				do {
+					if (++z->strstart<=max_insert) insert(z, z->strstart);
+				} while (--z->prev_length);
+				z->match_available=false;
+				z->match_length=MIN_MATCH-1;
+				z->strstart++;
+
+				if (z->nsyms>=LIT_BUFSIZE-1) {
+					z->block_end=z->strstart;
+					return BLOCK_FULL;
+				}
+			}
+			else if (z->match_available) {
+				tally_lit(z, z->window[z->strstart-1]);
+				z->strstart++;
+				z->lookahead--;
+
+				if (z->nsyms>=LIT_BUFSIZE-1) {
+					z->block_end=z->strstart-1;
+					return BLOCK_FULL;
+				}
+			}
+			else {
+				z->match_available=true;
+				z->strstart++;
+				z->lookahead--;
+			}
+		}
+	}
+
+	if (z->match_available) {
+		tally_lit(z, z->window[z->strstart-1]);
+		z->match_available=false;
+	}
+	z->block_end=z->strstart;
+	return INPUT_DONE;
+}
+
+// level 0: blocks of up to 2*WSIZE bytes, stored
+static int store(struct twr_deflate* z, const uint8_t** in, const uint8_t* in_end, bool finish) {
+	for (;;) {
+		fill_window(z, in, in_end);
+		z->strstart+=z->lookahead;
+		z->lookahead=0;
+		z->block_end=z->strstart;
+
+		if (z->block_end-z->block_start>=WSIZE) return BLOCK_FULL;
+		if (*in==in_end) return finish ? INPUT_DONE : NEED_INPUT;
+	}
+}
+
+//*************************************************
+
+struct twr_deflate* twr_deflate_new(int format, int level) {
+	if (level==-1) level=6;
+	if (format<TWR_Z_RAW || format>TWR_Z_GZIP || level<0 || level>9) {
+		errno=EINVAL;
+		return NULL;
+	}
+
+	if (!tables_built) build_tables();
+
+	struct twr_deflate* z=calloc(1, sizeof(struct twr_deflate));
+	if (z==NULL) return NULL;
+
+	z->format=format;
+	z->level=level;
+	z->good_length=config[level].good;
+	z->max_lazy=config[level].lazy;
+	z->nice_length=config[level].nice;
+	z->max_chain=config[level].chain;
+	z->match_length=z->prev_length=MIN_MATCH-1;
+	z->check=format==TWR_Z_ZLIB ? 1 : 0;
+
+	z->window=calloc(2*WSIZE+8, 1);
+	if (level>0) {
+		z->head=calloc(1<<HASH_BITS, sizeof(uint16_t));
+		z->prev=calloc(WSIZE, sizeof(uint16_t));
+		z->sym_lit=malloc(LIT_BUFSIZE);
+		z->sym_dist=malloc(LIT_BUFSIZE*sizeof(uint16_t));
+	}
+	if (z->window==NULL || (level>0 && (z->head==NULL || z->prev==NULL || z->sym_lit==NULL || z->sym_dist==NULL))) {
+		twr_deflate_free(z);
+		return NULL;
+	}
+
+	if (format==TWR_Z_ZLIB) {
+		const int cmf=((WBITS-8)<<4)|8;
+		int flg=(level<2 ? 0 : level<6 ? 1 : level==6 ? 2 : 3)<<6;
+		flg+=31-(cmf*256+flg)%31;
+		z->pend[0]=cmf;
+		z->pend[1]=flg;
+		z->pend_len=2;
+	}
+	else if (format==TWR_Z_GZIP) {
+		static const uint8_t gzip_header[10]={0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 255};
+		memcpy(z->pend, gzip_header, 10);
+		z->pend[8]=level==9 ? 2 : level==1 ? 4 : 0;
+		z->pend_len=10;
+	}
+	z->phase=PH_PEND;
+	z->after_pend=PH_IDLE;
+
+	return z;
+}
+
+int twr_deflate(struct twr_deflate* z, const void* in, size_t in_len, size_t* in_used, void* out, size_t out_len, size_t* out_made, int finish) {
+	const uint8_t* i=in;
+	const uint8_t* const in_end=i+in_len;
+	struct outbuf w={out, (uint8_t*)out+out_len};
+	int rv=TWR_Z_OK;
+
+	for (;;) {
+		if (!emit(z, &w)) break;
+		if (z->phase==PH_DONE) {
+			rv=TWR_Z_END;
+			break;
+		}
+
+		const int r=z->level ? compress(z, &i, in_end, finish) : store(z, &i, in_end, finish);
+		if (r==NEED_INPUT) break;
+		start_block(z, r==INPUT_DONE);
+	}
+
+	*in_used=i-(const uint8_t*)in;
+	*out_made=w.out-(uint8_t*)out;
+	return rv;
+}
+
+void twr_deflate_free(struct twr_deflate* z) {
+	if (z) {
+		free(z->window);
+		free(z->head);
+		free(z->prev);
+		free(z->sym_lit);
+		free(z->sym_dist);
+		free(z);
+	}
+}
+
+// stored blocks, which are the most a block can be, have at least LIT_BUFSIZE-1 bytes, and 5 bytes of overhead
+size_t twr_deflate_bound(size_t in_len) {
+	return in_len + 5*(in_len/(LIT_BUFSIZE-1)+2) + 18;
+}
+
+long twr_deflate_buf(const void* in, size_t in_len, void* out, size_t out_len, int format, int level) {
+	struct twr_deflate* z=twr_deflate_new(format, level);
+	if (z==NULL) return -1;
+
+	size_t used, made;
+	const int rv=twr_deflate(z, in, in_len, &used, out, out_len, &made, 1);
+	twr_deflate_free(z);
+
+	if (rv!=TWR_Z_END) {
+		errno=ENOSPC;
+		return -1;
+	}
+	return made;
+}
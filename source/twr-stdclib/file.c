@@ -0,0 +1,754 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include "twr-crt.h"
+
+// buffered FILE streams over a struct twr_fs_backend.
+//
+// A FILE is a struct IoConsole, so a file is an IoConsole "driver" with header.type IO_TYPE_FILE.  io_putc() and
+// io_write() pass bytes straight to charout (file_putc and file_write below), so fprintf, fwrite, twr::format, etc
+// work on files without changes.  The stdio functions that read or seek check for IO_TYPE_FILE.
+//
+// One buffer is used for both reading and writing.  It holds the bytes of the file at [pos, pos+len), and the stream
+// position is pos+off.  When writing, off==len.  If the backend can map a file opened read only (the in-memory file
+// system can), the mapped contents are used as the buffer, so fread() and getc() read the file's memory directly.
+
+enum bufstate {BUF_EMPTY, BUF_READ, BUF_WRITE};
+
+struct twr_file {
+	struct IoConsole con;	// must be first
+	const struct twr_fs_backend* fs;
+	void* handle;
+	int flags;			// TWR_FS_
+	int vbufmode;		// _IOFBF, _IOLBF or _IONBF
+	enum bufstate state;
+	char* buf;
+	long bufsize;
+	long pos;
+	long len;
+	long off;
+	int ungot;			// a character pushed back by ungetc, or EOF
+	bool mapped;
+	bool buf_allocated;
+	bool eof;
+	bool error;
+	struct twr_file* next;	// open files, for fflush(NULL)
+};
+
+#define FILE_BUFSIZE 4096
+#define MAX_MOUNTS 8
+
+static struct twr_file* open_files;
+
+static struct {
+	char* prefix;		// a copy
+	int prefix_len;
+	const struct twr_fs_backend* fs;
+} mounts[MAX_MOUNTS];
+static int num_mounts;
+
+static inline bool is_file(FILE* stream) {
+	return stream && (stream->header.type&IO_TYPE_FILE);
+}
+
+//*************************************************
+
+// fs NULL unmounts prefix
+int twr_fs_mount(const char* prefix, const struct twr_fs_backend* fs) {
+	for (int i=0; i<num_mounts; i++) {
+		if (strcmp(mounts[i].prefix, prefix)==0) {
+			if (fs) {
+				mounts[i].fs=fs;
+			}
+			else {
+				free(mounts[i].prefix);
+				mounts[i]=mounts[--num_mounts];
+			}
+			return 0;
+		}
+	}
+
+	if (fs==NULL) return -1;
+	if (num_mounts==MAX_MOUNTS) return -1;
+
+	char* copy=strdup(prefix);
+	if (copy==NULL) return -1;
+	mounts[num_mounts].prefix=copy;
+	mounts[num_mounts].prefix_len=strlen(copy);
+	mounts[num_mounts].fs=fs;
+	num_mounts++;
+	return 0;
+}
+
+// the backend for path, with *rest set to the part of path after the mount prefix
+static const struct twr_fs_backend* find_mount(const char* path, const char** rest) {
+	int best=-1;
+
+	for (int i=0; i<num_mounts; i++)
+		if (strncmp(path, mounts[i].prefix, mounts[i].prefix_len)==0 && (best<0 || mounts[i].prefix_len>mounts[best].prefix_len))
+			best=i;
+
+	if (best<0) {
+		*rest=path;
+		return twr_memfs();
+	}
+
+	*rest=path+mounts[best].prefix_len;
+	return mounts[best].fs;
+}
+
+//*************************************************
+
+// "r" "w" "a" "r+" "w+" "a+", with optional "b" (ignored) and "x" (with w)
+static int parse_mode(const char* mode) {
+	int flags;
+
+	switch (*mode++) {
+		case 'r': flags=TWR_FS_READ; break;
+		case 'w': flags=TWR_FS_WRITE|TWR_FS_CREATE|TWR_FS_TRUNC; break;
+		case 'a': flags=TWR_FS_WRITE|TWR_FS_CREATE|TWR_FS_APPEND; break;
+		default: return -1;
+	}
+
+	for (; *mode; mode++) {
+		if (*mode=='+') flags|=TWR_FS_READ|TWR_FS_WRITE;
+		else if (*mode=='x' && (flags&TWR_FS_TRUNC)) flags|=TWR_FS_EXCL;
+		else if (*mode!='b') return -1;
+	}
+
+	return flags;
+}
+
+// write len bytes at the stream position (the end of the file if appending), and advance it.  returns 0, or EOF on error
+static int write_at(struct twr_file* f, const char* data, long len) {
+	if (f->flags&TWR_FS_APPEND) {
+		const long size=f->fs->size(f->handle);
+		if (size>=0) f->pos=size;
+	}
+
+	while (len>0) {
+		const long n=f->fs->write(f->handle, f->pos, data, len);
+		if (n<=0) {
+			f->error=true;
+			return EOF;
+		}
+		f->pos+=n;
+		data+=n;
+		len-=n;
+	}
+
+	return 0;
+}
+
+// flush the write buffer to the backend.  returns 0, or EOF on error
+static int flush_write(struct twr_file* f) {
+	if (f->state==BUF_WRITE && f->len>0) {
+		const long len=f->len;
+		f->len=f->off=0;
+		return write_at(f, f->buf, len);
+	}
+
+	return 0;
+}
+
+// drop the buffer's contents, keeping the stream position.  a mapped file keeps its contents
+static int reset_buffer(struct twr_file* f) {
+	if (f->state==BUF_WRITE) {
+		if (flush_write(f)) return EOF;
+	}
+	else if (!f->mapped) {
+		f->pos+=f->off;
+		f->len=f->off=0;
+	}
+
+	f->state=f->mapped ? BUF_READ : BUF_EMPTY;
+	return 0;
+}
+
+// read the next bufsize bytes into the buffer.  returns false at end of file or on error
+static bool fill(struct twr_file* f) {
+	if (f->mapped) {
+		f->eof=true;
+		return false;
+	}
+
+	if (f->state==BUF_WRITE && flush_write(f)) return false;
+
+	f->state=BUF_READ;
+	f->pos+=f->len;
+	f->len=f->off=0;
+
+	const long n=f->fs->read(f->handle, f->pos, f->buf, f->bufsize);
+	if (n<=0) {
+		if (n<0) f->error=true;
+		else f->eof=true;
+		return false;
+	}
+
+	f->len=n;
+	return true;
+}
+
+//*************************************************
+
+static void file_write(struct IoConsole* io, const char* str, int len) {
+	struct twr_file* f=(struct twr_file*)io;
+
+	if (len<=0) return;
+
+	if (!(f->flags&TWR_FS_WRITE) || f->mapped) {
+		f->error=true;
+		errno=EBADF;
+		return;
+	}
+
+	if (f->state!=BUF_WRITE) {
+		if (reset_buffer(f)) return;
+		f->ungot=EOF;
+		f->state=BUF_WRITE;
+	}
+
+	if (f->len+len > f->bufsize) {
+		if (flush_write(f)) return;
+		if (len>=f->bufsize) {	// too big to buffer
+			write_at(f, str, len);
+			return;
+		}
+	}
+
+	memcpy(f->buf+f->len, str, len);
+	f->len+=len;
+	f->off=f->len;
+
+	if (f->vbufmode==_IONBF || f->len==f->bufsize || (f->vbufmode==_IOLBF && memchr(str, '\n', len)))
+		flush_write(f);
+}
+
+static void file_putc(struct IoConsole* io, unsigned char c) {
+	struct twr_file* f=(struct twr_file*)io;
+
+	if (f->state==BUF_WRITE && f->len<f->bufsize-1 && f->vbufmode==_IOFBF) {	// fast path
+		f->buf[f->len++]=c;
+		f->off=f->len;
+		return;
+	}
+
+	file_write(io, (const char*)&c, 1);
+}
+
+static void file_close(struct IoConsole* io) {
+	fclose(io);
+}
+
+//*************************************************
+
+static FILE* open_handle(const struct twr_fs_backend* fs, void* handle, int flags) {
+	struct twr_file* f=calloc(1, sizeof(struct twr_file));
+	if (f==NULL) {
+		fs->close(handle);
+		errno=ENOMEM;
+		return NULL;
+	}
+
+	f->con.header.type=IO_TYPE_FILE;
+	f->con.header.io_close=file_close;
+	f->con.charout.io_putc=file_putc;
+	f->con.charout.io_write=file_write;
+	f->fs=fs;
+	f->handle=handle;
+	f->flags=flags;
+	f->vbufmode=_IOFBF;
+	f->ungot=EOF;
+
+	if (flags==TWR_FS_READ && fs->map) {
+		const char* data=fs->map(handle, &f->len);
+		if (data) {
+			f->buf=(char*)data;
+			f->bufsize=f->len;
+			f->mapped=true;
+			f->state=BUF_READ;
+		}
+	}
+
+	if (!f->mapped) {
+		f->buf=malloc(FILE_BUFSIZE);
+		if (f->buf==NULL) {
+			fs->close(handle);
+			free(f);
+			errno=ENOMEM;
+			return NULL;
+		}
+		f->bufsize=FILE_BUFSIZE;
+		f->buf_allocated=true;
+	}
+
+	f->next=open_files;
+	open_files=f;
+
+	return &f->con;
+}
+
+FILE* fopen(const char* filename, const char* mode) {
+	const int flags=parse_mode(mode);
+	if (flags<0) {
+		errno=EINVAL;
+		return NULL;
+	}
+
+	const char* path;
+	const struct twr_fs_backend* fs=find_mount(filename, &path);
+	if ((flags&TWR_FS_WRITE) && fs->write==NULL) {
+		errno=EROFS;
+		return NULL;
+	}
+
+	void* handle=fs->open(path, flags);
+	if (handle==NULL) return NULL;
+
+	return open_handle(fs, handle, flags);
+}
+
+// a FILE for a handle that was opened directly with a backend (for example, a stream that doesn't have a path)
+struct IoConsole* twr_fopen_handle(const struct twr_fs_backend* fs, void* handle, const char* mode) {
+	const int flags=parse_mode(mode);
+	if (flags<0) {
+		errno=EINVAL;
+		return NULL;
+	}
+
+	return open_handle(fs, handle, flags);
+}
+
+int fclose(FILE* stream) {
+	if (!is_file(stream)) {
+		io_close(stream);
+		return 0;
+	}
+
+	struct twr_file* f=(struct twr_file*)stream;
+	int rv=0;
+
+	if (f->state==BUF_WRITE && flush_write(f)) rv=EOF;
+	if (f->fs->close(f->handle)) rv=EOF;
+
+	for (struct twr_file** p=&open_files; *p; p=&(*p)->next) {
+		if (*p==f) {
+			*p=f->next;
+			break;
+		}
+	}
+
+	if (f->buf_allocated) free(f->buf);
+	free(f);
+
+	return rv;
+}
+
+int remove(const char* pathname) {
+	const char* path;
+	const struct twr_fs_backend* fs=find_mount(pathname, &path);
+
+	if (fs->remove==NULL) {
+		errno=EROFS;
+		return -1;
+	}
+
+	return fs->remove(path);
+}
+
+//*************************************************
+
+size_t __twr_file_read(FILE* stream, char* dest, size_t total) {
+	struct twr_file* f=(struct twr_file*)stream;
+	size_t done=0;
+
+	if (total==0) return 0;
+
+	if (!(f->flags&TWR_FS_READ)) {
+		f->error=true;
+		errno=EBADF;
+		return 0;
+	}
+
+	if (f->state==BUF_WRITE && reset_buffer(f)) return 0;
+
+	if (f->ungot!=EOF) {
+		dest[done++]=(char)f->ungot;
+		f->ungot=EOF;
+	}
+
+	while (done<total) {
+		if (f->state==BUF_READ && f->off<f->len) {
+			long n=f->len-f->off;
+			if ((size_t)n>total-done) n=total-done;
+			memcpy(dest+done, f->buf+f->off, n);
+			f->off+=n;
+			done+=n;
+		}
+		else if (!f->mapped && (long)(total-done)>=f->bufsize) {	// read straight into the caller's buffer
+			f->pos+=f->len;
+			f->len=f->off=0;
+			f->state=BUF_EMPTY;
+			const long n=f->fs->read(f->handle, f->pos, dest+done, total-done);
+			if (n<=0) {
+				if (n<0) f->error=true;
+				else f->eof=true;
+				break;
+			}
+			f->pos+=n;
+			done+=n;
+		}
+		else if (!fill(f)) {
+			break;
+		}
+	}
+
+	return done;
+}
+
+int __twr_file_getc(FILE* stream) {
+	struct twr_file* f=(struct twr_file*)stream;
+
+	if (f->ungot!=EOF) {
+		const int c=f->ungot;
+		f->ungot=EOF;
+		return c;
+	}
+
+	if (f->state==BUF_READ && f->off<f->len)
+		return (unsigned char)f->buf[f->off++];
+
+	unsigned char c;
+	if (__twr_file_read(stream, (char*)&c, 1)!=1) return EOF;
+	return c;
+}
+
+int __twr_file_ungetc(int ch, FILE* stream) {
+	struct twr_file* f=(struct twr_file*)stream;
+
+	if (ch==EOF || f->ungot!=EOF) return EOF;
+	if (f->state==BUF_WRITE && reset_buffer(f)) return EOF;
+
+	if (f->state==BUF_READ && f->off>0 && f->off<=f->len && (unsigned char)f->buf[f->off-1]==(unsigned char)ch)
+		f->off--;	// the common case: the character just read
+	else
+		f->ungot=(unsigned char)ch;
+
+	f->eof=false;
+	return (unsigned char)ch;
+}
+
+// fgets, using memchr on the buffer
+char* __twr_file_gets(char* str, int count, FILE* stream) {
+	struct twr_file* f=(struct twr_file*)stream;
+	int done=0;
+
+	if (count<=0) return NULL;
+	if (count==1) {	// same as glibc
+		str[0]=0;
+		return str;
+	}
+
+	while (done<count-1) {
+		if (f->ungot!=EOF || !(f->state==BUF_READ && f->off<f->len)) {
+			const int c=__twr_file_getc(stream);
+			if (c==EOF) break;
+			str[done++]=c;
+			if (c=='\n') break;
+			continue;
+		}
+
+		long n=f->len-f->off;
+		if (n>count-1-done) n=count-1-done;
+		const char* nl=memchr(f->buf+f->off, '\n', n);
+		if (nl) n=nl-(f->buf+f->off)+1;
+		memcpy(str+done, f->buf+f->off, n);
+		f->off+=n;
+		done+=n;
+		if (nl) break;
+	}
+
+	if (done==0) return NULL;
+	str[done]=0;
+	return str;
+}
+
+int __twr_file_flush(FILE* stream) {
+	struct twr_file* f=(struct twr_file*)stream;
+	return f->state==BUF_WRITE ? flush_write(f) : 0;
+}
+
+void __twr_file_flush_all(void) {
+	for (struct twr_file* f=open_files; f; f=f->next)
+		__twr_file_flush(&f->con);
+}
+
+int __twr_file_setvbuf(FILE* stream, char* buf, int mode, size_t size) {
+	struct twr_file* f=(struct twr_file*)stream;
+
+	if (mode!=_IOFBF && mode!=_IOLBF && mode!=_IONBF) return -1;
+	f->vbufmode=mode;
+
+	if (f->mapped || buf==NULL || size==0) return 0;
+	if (f->state!=BUF_EMPTY && reset_buffer(f)) return -1;
+	if (f->buf_allocated) free(f->buf);
+	f->buf=buf;
+	f->bufsize=size;
+	f->buf_allocated=false;
+	f->pos+=f->off;
+	f->len=f->off=0;
+	f->state=BUF_EMPTY;
+	return 0;
+}
+
+//*************************************************
+
+int fseek(FILE* stream, long offset, int origin) {
+	if (!is_file(stream)) {
+		errno=ESPIPE;
+		return -1;
+	}
+
+	struct twr_file* f=(struct twr_file*)stream;
+	long target;
+
+	if (f->state==BUF_WRITE && flush_write(f)) return -1;
+
+	switch (origin) {
+		case SEEK_SET:
+			target=offset;
+			break;
+		case SEEK_CUR:
+			target=ftell(stream);
+			if (target<0) return -1;
+			target+=offset;
+			break;
+		case SEEK_END:
+		{
+			const long size=f->fs->size(f->handle);
+			if (size<0) {
+				errno=ESPIPE;
+				return -1;
+			}
+			target=size+offset;
+		}
+			break;
+		default:
+			errno=EINVAL;
+			return -1;
+	}
+
+	if (target<0) {
+		errno=EINVAL;
+		return -1;
+	}
+
+	f->ungot=EOF;
+	f->eof=false;
+
+	if (f->mapped || (f->state==BUF_READ && target>=f->pos && target<=f->pos+f->len)) {	// in the buffer, or past the end of a mapped file
+		f->off=target-f->pos;
+	}
+	else {
+		if (f->state!=BUF_WRITE && f->fs->size(f->handle)<0) {	// streams can only seek forwards, by reading
+			if (target<f->pos+f->off) {
+				errno=ESPIPE;
+				return -1;
+			}
+			while (f->pos+f->len<target)
+				if (!fill(f)) return -1;
+			f->off=target-f->pos;
+			return 0;
+		}
+		f->pos=target;
+		f->len=f->off=0;
+		f->state=BUF_EMPTY;
+	}
+
+	return 0;
+}
+
+long ftell(FILE* stream) {
+	if (!is_file(stream)) {
+		errno=ESPIPE;
+		return -1;
+	}
+
+	struct twr_file* f=(struct twr_file*)stream;
+	return f->pos+f->off-(f->ungot!=EOF);
+}
+
+void rewind(FILE* stream) {
+	fseek(stream, 0, SEEK_SET);
+	clearerr(stream);
+}
+
+void clearerr(FILE* stream) {
+	if (is_file(stream)) {
+		struct twr_file* f=(struct twr_file*)stream;
+		f->eof=false;
+		f->error=false;
+	}
+}
+
+int __twr_file_eof(FILE* stream) {
+	return ((struct twr_file*)stream)->eof;
+}
+
+int __twr_file_error(FILE* stream) {
+	return ((struct twr_file*)stream)->error;
+}
+
+/****************************************************************/
+
+// a read only, unmapped, backend for the unit test.  byte i of a file is (i*7)&255, and the path is the file size
+static void* gen_open(const char* path, int flags) {
+	return (void*)(size_t)atoi(path);
+}
+
+static int gen_close(void* handle) {
+	return 0;
+}
+
+static long gen_read(void* handle, long offset, char* buf, long len) {
+	const long size=(long)(size_t)handle;
+	if (offset>=size) return 0;
+	if (len>size-offset) len=size-offset;
+	if (len>1000) len=1000;		// short reads
+	for (long i=0; i<len; i++)
+		buf[i]=((offset+i)*7)&255;
+	return len;
+}
+
+static long gen_size(void* handle) {
+	return (long)(size_t)handle;
+}
+
+static const struct twr_fs_backend genfs={gen_open, gen_close, gen_read, NULL, gen_size, NULL, NULL};
+
+int file_unit_test() {
+	FILE* f;
+	char line[64];
+	static char block[6000];
+
+	for (int i=0; i<(int)sizeof(block); i++) block[i]=i*13;
+
+	errno=0;
+	if (fopen("/unittest/none.txt", "r")!=NULL || errno!=ENOENT) return 0;
+	if (fopen("/unittest/a.txt", "q")!=NULL || errno!=EINVAL) return 0;
+
+	// write, then read back (mapped)
+	f=fopen("/unittest/a.txt", "w");
+	if (f==NULL) return 0;
+	if (fprintf(f, "line %d\n", 1)!=7) return 0;
+	if (fputs("line 2\n", f)==EOF) return 0;
+	putc('x', f);
+	if (fwrite(block, 1, sizeof(block), f)!=sizeof(block)) return 0;
+	if (ftell(f)!=15+(long)sizeof(block)) return 0;
+	if (fclose(f)!=0) return 0;
+
+	f=fopen("./unittest/a.txt", "rb");
+	if (f==NULL) return 0;
+	if (fgets(line, sizeof(line), f)==NULL || strcmp(line, "line 1\n")!=0) return 0;
+	if (fgets(line, sizeof(line), f)==NULL || strcmp(line, "line 2\n")!=0) return 0;
+	if (getc(f)!='x' || ungetc('y', f)!='y' || getc(f)!='y') return 0;
+	if (fread(line, 1, 10, f)!=10 || memcmp(line, block, 10)!=0) return 0;
+	if (fseek(f, -5, SEEK_END)!=0 || fread(line, 1, 10, f)!=5 || memcmp(line, block+sizeof(block)-5, 5)!=0) return 0;
+	if (!feof(f) || getc(f)!=EOF) return 0;
+	if (fseek(f, 15, SEEK_SET)!=0 || feof(f) || ftell(f)!=15) return 0;
+	if (fread(line, 1, 1, f)!=1 || line[0]!=block[0] || ftell(f)!=16) return 0;
+	if (fseek(f, 2, SEEK_CUR)!=0 || getc(f)!=(unsigned char)block[3]) return 0;
+	if (fopen("/unittest/a.txt", "w")!=NULL || errno!=EBUSY) return 0;
+	if (fwrite("a", 1, 1, f)!=0 || !ferror(f)) return 0;
+	clearerr(f);
+	if (ferror(f)) return 0;
+	if (fclose(f)!=0) return 0;
+
+	// update in place ("r+" is buffered, not mapped), and append
+	f=fopen("unittest/a.txt", "r+");
+	if (f==NULL) return 0;
+	if (fseek(f, 5, SEEK_SET)!=0 || fputs("9", f)==EOF) return 0;
+	if (fgets(line, sizeof(line), f)==NULL || strcmp(line, "\n")!=0) return 0;
+	rewind(f);
+	if (fgets(line, sizeof(line), f)==NULL || strcmp(line, "line 9\n")!=0) return 0;
+	if (fseek(f, 0, SEEK_END)!=0 || ftell(f)!=15+(long)sizeof(block)) return 0;
+	if (fclose(f)!=0) return 0;
+
+	f=fopen("/unittest/a.txt", "a");
+	if (f==NULL || fputs("end", f)==EOF || fclose(f)!=0) return 0;
+	f=fopen("/unittest/a.txt", "r");
+	if (f==NULL || fseek(f, -4, SEEK_END)!=0 || fread(line, 1, 4, f)!=4 || memcmp(line, block+sizeof(block)-1, 1)!=0 || memcmp(line+1, "end", 3)!=0) return 0;
+
+	// removed while open: still readable until closed
+	if (remove("/unittest/a.txt")!=0) return 0;
+	if (fopen("/unittest/a.txt", "r")!=NULL || errno!=ENOENT) return 0;
+	rewind(f);
+	if (fgets(line, sizeof(line), f)==NULL || strcmp(line, "line 9\n")!=0) return 0;
+	if (fclose(f)!=0) return 0;
+	if (remove("/unittest/a.txt")!=-1 || errno!=ENOENT) return 0;
+
+	// files added with twr_memfs_add (how JavaScript adds files)
+	char* data=malloc(3);
+	memcpy(data, "abc", 3);
+	if (twr_memfs_add("/unittest/b.bin", data, 3)!=0) return 0;
+	f=fopen("/unittest/b.bin", "r");
+	if (f==NULL || fread(line, 1, sizeof(line), f)!=3 || memcmp(line, "abc", 3)!=0 || !feof(f)) return 0;
+	if (twr_memfs_add("/unittest/b.bin", NULL, 0)!=-1 || errno!=EBUSY) return 0;
+	fclose(f);
+	if (fopen("/unittest/b.bin", "wx")!=NULL || errno!=EEXIST) return 0;
+	if (remove("/unittest/b.bin")!=0) return 0;
+
+	// twr_map_asset: shared, refcounted views
+	data=aligned_alloc(16, 100);
+	memset(data, 'z', 100);
+	if (twr_memfs_add("/unittest/asset.bin", data, 100)!=0) return 0;
+	size_t len;
+	const char* view1=twr_map_asset("unittest/asset.bin", &len);
+	const char* view2=twr_map_asset("/unittest/asset.bin", NULL);
+	if (view1!=data || view2!=data || len!=100 || ((uintptr_t)view1&15)) return 0;
+	if (fopen("/unittest/asset.bin", "w")!=NULL || errno!=EBUSY) return 0;
+	if (twr_memfs_add("/unittest/asset.bin", NULL, 0)!=-1 || errno!=EBUSY) return 0;
+	if (remove("/unittest/asset.bin")!=0 || twr_map_asset("/unittest/asset.bin", &len)!=NULL || errno!=ENOENT) return 0;
+	twr_unmap_asset(view1);
+	if (view2[99]!='z') return 0;
+	twr_unmap_asset(view2);
+	if (twr_memfs_add("/unittest/empty", NULL, 0)!=0) return 0;
+	view1=twr_map_asset("/unittest/empty", &len);
+	if (view1==NULL || len!=0) return 0;
+	twr_unmap_asset(view1);
+	if (remove("/unittest/empty")!=0) return 0;
+	f=fopen("/unittest/w.txt", "w");
+	if (f==NULL || twr_map_asset("/unittest/w.txt", &len)!=NULL || errno!=EBUSY) return 0;
+	if (fclose(f)!=0 || (view1=twr_map_asset("/unittest/w.txt", &len))==NULL || len!=0) return 0;
+	twr_unmap_asset(view1);
+	if (remove("/unittest/w.txt")!=0) return 0;
+
+	// a mounted backend, read through the FILE buffer.  The prefix is copied
+	char prefix[8]="/gen/";
+	if (twr_fs_mount(prefix, &genfs)!=0) return 0;
+	strcpy(prefix, "/xxx/");
+	if (fopen("/gen/10", "w")!=NULL || errno!=EROFS) return 0;
+	f=fopen("/gen/10000", "r");
+	if (f==NULL) return 0;
+	long total=0;
+	int n;
+	while ((n=fread(block, 1, 333, f))>0) {
+		for (int i=0; i<n; i++)
+			if ((unsigned char)block[i]!=((total+i)*7&255)) return 0;
+		total+=n;
+	}
+	if (total!=10000 || !feof(f)) return 0;
+	if (fseek(f, 4999, SEEK_SET)!=0 || getc(f)!=(4999*7&255)) return 0;
+	if (fread(block, 1, sizeof(block), f)!=5000 || (unsigned char)block[0]!=(5000*7&255) || ftell(f)!=10000) return 0;
+	if (fclose(f)!=0) return 0;
+
+	// unmounted, the path is a memfs path
+	if (twr_fs_mount("/gen/", NULL)!=0 || twr_fs_mount("/gen/", NULL)!=-1) return 0;
+	if (fopen("/gen/10000", "r")!=NULL || errno!=ENOENT) return 0;
+
+	return 1;
+}
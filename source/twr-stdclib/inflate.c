@@ -0,0 +1,599 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "twr-zlib.h"
+
+// DEFLATE decompression (RFC 1951), with zlib (RFC 1950) or gzip (RFC 1952) framing
+//
+// Huffman codes are decoded with a table indexed by the next FASTBITS bits of input, which gives the symbol and
+// length of every code that short.  The few longer codes are decoded a bit at a time from the count of codes of each
+// length (as in zlib's puff.c).
+//
+// While there is enough input and output for any symbol, the main loop reads 64 bits at a time and doesn't check for
+// the end of either.  Near the end of them, symbols are decoded one at a time, and if the input runs out part way
+// through a symbol or block header, decoding goes back to its start and returns.  So the only state kept between
+// calls is what is saved in struct twr_inflate at those points, and the input that wasn't used is passed again.
+//
+// Output is written straight to the caller's buffer.  The window keeps the last 32K, for matches that reach back into
+// the output of a previous call.
+
+#define MAXBITS 15
+#define FASTBITS 10
+#define FASTMASK ((1<<FASTBITS)-1)
+#define WSIZE 32768
+
+struct huffman {
+	uint16_t fast[1<<FASTBITS];	// (symbol<<4)|length, or 0 for a code longer than FASTBITS
+	uint16_t count[MAXBITS+1];	// the number of codes of each length
+	uint16_t symbol[288];		// symbols in code order
+};
+
+enum {ST_HEADER, ST_BLOCK, ST_STORED, ST_CODES, ST_COPY, ST_TRAILER, ST_DONE, ST_ERROR};
+
+struct twr_inflate {
+	int format;
+	int state;
+	uint64_t bitbuf;
+	int bitcnt;
+	bool last;			// the current block is the last one
+	uint32_t stored_left;		// bytes left in a stored block
+	int copy_len, copy_dist;	// the rest of a match that didn't fit in the output
+	uint32_t check;			// adler32 or crc32 of the output
+	uint32_t total;			// output length, mod 2^32
+	uint8_t* window;		// a ring of the last WSIZE bytes of output.  NULL for twr_inflate_buf
+	uint32_t wpos, whave;
+	struct huffman lit, dist;
+};
+
+static const uint16_t len_base[29]={3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t len_extra[29]={0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t dist_base[30]={1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t dist_extra[30]={0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+static const uint8_t clen_order[19]={16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15};
+
+// returns 0 for a complete code, >0 for an incomplete one, or <0 if there are too many codes of some length
+static int build(struct huffman* h, const uint8_t* lengths, int n) {
+	uint16_t offs[MAXBITS+1];
+
+	memset(h->count, 0, sizeof(h->count));
+	memset(h->fast, 0, sizeof(h->fast));
+	for (int i=0; i<n; i++)
+		h->count[lengths[i]]++;
+	if (h->count[0]==n) return 0;		// no codes.  decoding will fail
+
+	int left=1;
+	for (int len=1; len<=MAXBITS; len++) {
+		left<<=1;
+		left-=h->count[len];
+		if (left<0) return left;
+	}
+
+	offs[1]=0;
+	for (int len=1; len<MAXBITS; len++)
+		offs[len+1]=offs[len]+h->count[len];
+	for (int sym=0; sym<n; sym++)
+		if (lengths[sym]) h->symbol[offs[lengths[sym]]++]=sym;
+
+	// codes are sent starting from their first bit, so the table is indexed by the bit reversed code
+	int code=0, k=0;
+	for (int len=1; len<=FASTBITS; len++) {
+		for (int i=0; i<h->count[len]; i++, k++, code++) {
+			int rev=0;
+			for (int b=0; b<len; b++)
+				rev|=((code>>b)&1)<<(len-1-b);
+			const uint16_t entry=(h->symbol[k]<<4)|len;
+			for (int j=rev; j<(1<<FASTBITS); j+=1<<len)
+				h->fast[j]=entry;
+		}
+		code<<=1;
+	}
+
+	return left;
+}
+
+// the symbol at the start of bits, with its code length in *length.  -1 if it isn't a code
+static int decode(const struct huffman* h, uint64_t bits, int* length) {
+	const uint16_t entry=h->fast[bits&FASTMASK];
+	if (entry) {
+		*length=entry&15;
+		return entry>>4;
+	}
+
+	int code=0, first=0, index=0;
+	for (int len=1; len<=MAXBITS; len++) {
+		code|=bits&1;
+		bits>>=1;
+		const int count=h->count[len];
+		if (code-count<first) {
+			*length=len;
+			return h->symbol[index+(code-first)];
+		}
+		index+=count;
+		first=(first+count)<<1;
+		code<<=1;
+	}
+
+	return -1;
+}
+
+static void fixed_tables(struct twr_inflate* z) {
+	uint8_t lengths[288];
+	int i=0;
+	while (i<144) lengths[i++]=8;
+	while (i<256) lengths[i++]=9;
+	while (i<280) lengths[i++]=7;
+	while (i<288) lengths[i++]=8;
+	build(&z->lit, lengths, 288);
+	memset(lengths, 5, 30);
+	build(&z->dist, lengths, 30);
+}
+
+static void update_check(struct twr_inflate* z, const uint8_t* data, size_t len) {
+	if (z->format==TWR_Z_ZLIB) z->check=twr_adler32(z->check, data, len);
+	else if (z->format==TWR_Z_GZIP) z->check=twr_crc32(z->check, data, len);
+	z->total+=len;
+}
+
+// copy as much of the current match as fits in the output
+static uint8_t* copy_match(struct twr_inflate* z, uint8_t* out, const uint8_t* out_begin, const uint8_t* out_end) {
+	const uint32_t dist=z->copy_dist;
+	int len=z->copy_len;
+	if (len>out_end-out) len=out_end-out;
+	z->copy_len-=len;
+
+	if (dist>(uint32_t)(out-out_begin)) {	// starts in the window
+		const uint32_t back=dist-(out-out_begin);
+		uint32_t pos=(z->wpos-back)&(WSIZE-1);
+		int n=(uint32_t)len<back ? len : (int)back;
+		len-=n;
+		while (n--) {
+			*out++=z->window[pos];
+			pos=(pos+1)&(WSIZE-1);
+		}
+	}
+
+	const uint8_t* from=out-dist;
+	if (dist>=(uint32_t)len) {
+		memcpy(out, from, len);
+	}
+	else if (dist==1) {
+		memset(out, *from, len);
+	}
+	else {
+		uint8_t* const end=out+len;
+		if (dist>=8) {
+			for (; end-out>=8; out+=8, from+=8)
+				memcpy(out, from, 8);
+		}
+		while (out<end) *out++=*from++;
+		return end;
+	}
+	return out+len;
+}
+
+#define NEEDBITS(n) do { while (bitcnt<(n)) { if (in==in_end) goto rollback; bitbuf|=(uint64_t)*in++<<bitcnt; bitcnt+=8; } } while (0)
+#define BITS(n) ((uint32_t)bitbuf&((1u<<(n))-1))
+#define DROP(n) do { bitbuf>>=(n); bitcnt-=(n); } while (0)
+
+// a symbol, from as many bits as there are (up to MAXBITS).  A code that isn't valid is only an error if there were
+// enough bits to decode any code
+#define DECODE(h, sym) do { \
+		while (bitcnt<MAXBITS && in<in_end) { bitbuf|=(uint64_t)*in++<<bitcnt; bitcnt+=8; } \
+		int len_; \
+		sym=decode(h, bitbuf, &len_); \
+		if (sym<0 || len_>bitcnt) { \
+			if (bitcnt<MAXBITS) goto rollback; \
+			goto error; \
+		} \
+		DROP(len_); \
+	} while (0)
+
+// decode until the input or output runs out, or the end of the data.  *inp and *outp are advanced
+static int run(struct twr_inflate* z, const uint8_t** inp, const uint8_t* const in_end, uint8_t** outp, uint8_t* const out_begin, uint8_t* const out_end) {
+	const uint8_t* const in_start=*inp;
+	const uint8_t* in=in_start;
+	uint8_t* out=*outp;
+	uint8_t* checked=out;	// output from here hasn't been added to z->check
+	uint64_t bitbuf=z->bitbuf;
+	int bitcnt=z->bitcnt;
+	int rv=TWR_Z_OK;
+
+	// the start of the symbol or header being decoded
+	const uint8_t* save_in;
+	uint64_t save_bitbuf;
+	int save_bitcnt;
+
+	for (;;) {
+		save_in=in;
+		save_bitbuf=bitbuf;
+		save_bitcnt=bitcnt;
+
+		switch (z->state) {
+			case ST_HEADER:
+				if (z->format==TWR_Z_AUTO) {
+					NEEDBITS(8);
+					z->format=BITS(8)==0x1f ? TWR_Z_GZIP : TWR_Z_ZLIB;
+				}
+
+				if (z->format==TWR_Z_ZLIB) {
+					NEEDBITS(16);
+					const uint32_t cmf=BITS(8), flg=(bitbuf>>8)&255;
+					if ((cmf&15)!=8 || (cmf>>4)>7 || (cmf*256+flg)%31!=0 || (flg&0x20)) goto error;	// preset dictionaries aren't supported
+					DROP(16);
+					z->check=1;
+				}
+				else if (z->format==TWR_Z_GZIP) {
+					NEEDBITS(32);
+					if (BITS(16)!=0x8b1f || ((bitbuf>>16)&255)!=8) goto error;
+					const uint32_t flags=(bitbuf>>24)&255;
+					if (flags&0xe0) goto error;
+					DROP(32);
+					NEEDBITS(48);	// mtime, xfl, os
+					DROP(48);
+					if (flags&4) {	// extra field
+						NEEDBITS(16);
+						int xlen=BITS(16);
+						DROP(16);
+						while (xlen--) {
+							NEEDBITS(8);
+							DROP(8);
+						}
+					}
+					for (uint32_t f=8; f<=16; f<<=1) {	// file name, comment
+						if (flags&f) {
+							uint32_t c;
+							do {
+								NEEDBITS(8);
+								c=BITS(8);
+								DROP(8);
+							} while (c);
+						}
+					}
+					if (flags&2) {	// header crc
+						NEEDBITS(16);
+						DROP(16);
+					}
+					z->check=0;
+				}
+
+				z->state=ST_BLOCK;
+				break;
+
+			case ST_BLOCK:
+			{
+				NEEDBITS(3);
+				z->last=BITS(1);
+				const int type=(bitbuf>>1)&3;
+				DROP(3);
+
+				if (type==0) {
+					DROP(bitcnt&7);
+					NEEDBITS(32);
+					const uint32_t len=BITS(16), nlen=(bitbuf>>16)&0xffff;
+					if (len!=(~nlen&0xffff)) goto error;
+					DROP(32);
+					z->stored_left=len;
+					z->state=ST_STORED;
+				}
+				else if (type==1) {
+					fixed_tables(z);
+					z->state=ST_CODES;
+				}
+				else if (type==2) {
+					uint8_t lengths[286+30];
+					NEEDBITS(14);
+					const int nlen=BITS(5)+257;
+					DROP(5);
+					const int ndist=BITS(5)+1;
+					DROP(5);
+					const int ncode=BITS(4)+4;
+					DROP(4);
+					if (nlen>286 || ndist>30) goto error;
+
+					int i;
+					for (i=0; i<ncode; i++) {
+						NEEDBITS(3);
+						lengths[clen_order[i]]=BITS(3);
+						DROP(3);
+					}
+					for (; i<19; i++)
+						lengths[clen_order[i]]=0;
+					if (build(&z->lit, lengths, 19)!=0) goto error;
+
+					for (i=0; i<nlen+ndist; ) {
+						int sym;
+						DECODE(&z->lit, sym);
+						if (sym<16) {
+							lengths[i++]=sym;
+						}
+						else {
+							int len=0, rep;
+							if (sym==16) {
+								if (i==0) goto error;
+								len=lengths[i-1];
+								NEEDBITS(2);
+								rep=3+BITS(2);
+								DROP(2);
+							}
+							else if (sym==17) {
+								NEEDBITS(3);
+								rep=3+BITS(3);
+								DROP(3);
+							}
+							else {
+								NEEDBITS(7);
+								rep=11+BITS(7);
+								DROP(7);
+							}
+							if (i+rep>nlen+ndist) goto error;
+							while (rep--) lengths[i++]=len;
+						}
+					}
+
+					if (lengths[256]==0) goto error;
+					// an incomplete code is only allowed if it is a single code
+					int err=build(&z->lit, lengths, nlen);
+					if (err<0 || (err>0 && nlen!=z->lit.count[0]+z->lit.count[1])) goto error;
+					err=build(&z->dist, lengths+nlen, ndist);
+					if (err<0 || (err>0 && ndist!=z->dist.count[0]+z->dist.count[1])) goto error;
+					z->state=ST_CODES;
+				}
+				else {
+					goto error;
+				}
+				break;
+			}
+
+			case ST_STORED:
+				while (z->stored_left && bitcnt>=8) {		// whole bytes already in the bit buffer
+					if (out==out_end) goto suspend;
+					*out++=BITS(8);
+					DROP(8);
+					z->stored_left--;
+				}
+				if (z->stored_left) {
+					size_t n=z->stored_left;
+					if (n>(size_t)(in_end-in)) n=in_end-in;
+					if (n>(size_t)(out_end-out)) n=out_end-out;
+					memcpy(out, in, n);
+					out+=n;
+					in+=n;
+					z->stored_left-=n;
+					if (z->stored_left) goto suspend;
+				}
+				z->state=z->last ? ST_TRAILER : ST_BLOCK;
+				break;
+
+			case ST_CODES:
+			{
+				// while any symbol fits, without checks.  48 bits is the longest length and distance
+				while (in_end-in>=8 && out_end-out>=258) {
+					uint64_t next;
+					memcpy(&next, in, 8);
+					bitbuf|=next<<bitcnt;
+					in+=(63-bitcnt)>>3;
+					bitcnt|=56;
+
+					int len;
+					int sym=decode(&z->lit, bitbuf, &len);
+					if (sym<0) goto error;
+					DROP(len);
+
+					if (sym<256) {
+						*out++=sym;
+						continue;
+					}
+					if (sym==256) {
+						z->state=z->last ? ST_TRAILER : ST_BLOCK;
+						break;
+					}
+
+					sym-=257;
+					if (sym>=29) goto error;
+					const int length=len_base[sym]+BITS(len_extra[sym]);
+					DROP(len_extra[sym]);
+
+					const int dsym=decode(&z->dist, bitbuf, &len);
+					if (dsym<0 || dsym>=30) goto error;
+					DROP(len);
+					const uint32_t dist=dist_base[dsym]+BITS(dist_extra[dsym]);
+					DROP(dist_extra[dsym]);
+					if (dist>(uint32_t)(out-out_begin)+z->whave) goto error;
+
+					z->copy_len=length;
+					z->copy_dist=dist;
+					out=copy_match(z, out, out_begin, out_end);
+				}
+
+				// return the whole bytes that weren't used (ones read in this call), so the bits above bitcnt are 0 again
+				int unused=bitcnt>>3;
+				if (unused>in-in_start) unused=in-in_start;
+				in-=unused;
+				bitcnt-=unused*8;
+				bitbuf&=((uint64_t)1<<bitcnt)-1;
+
+				if (z->state!=ST_CODES) break;
+				save_in=in;
+				save_bitbuf=bitbuf;
+				save_bitcnt=bitcnt;
+
+				int sym;
+				DECODE(&z->lit, sym);
+				if (sym<256) {
+					if (out==out_end) goto rollback;
+					*out++=sym;
+					break;
+				}
+				if (sym==256) {
+					z->state=z->last ? ST_TRAILER : ST_BLOCK;
+					break;
+				}
+
+				sym-=257;
+				if (sym>=29) goto error;
+				NEEDBITS(len_extra[sym]);
+				const int length=len_base[sym]+BITS(len_extra[sym]);
+				DROP(len_extra[sym]);
+
+				int dsym;
+				DECODE(&z->dist, dsym);
+				if (dsym>=30) goto error;
+				NEEDBITS(dist_extra[dsym]);
+				const uint32_t dist=dist_base[dsym]+BITS(dist_extra[dsym]);
+				DROP(dist_extra[dsym]);
+				if (dist>(uint32_t)(out-out_begin)+z->whave) goto error;
+
+				z->copy_len=length;
+				z->copy_dist=dist;
+				z->state=ST_COPY;
+				break;
+			}
+
+			case ST_COPY:
+				out=copy_match(z, out, out_begin, out_end);
+				if (z->copy_len) goto suspend;
+				z->state=ST_CODES;
+				break;
+
+			case ST_TRAILER:
+				update_check(z, checked, out-checked);
+				checked=out;
+				DROP(bitcnt&7);
+
+				if (z->format==TWR_Z_ZLIB) {
+					NEEDBITS(32);
+					const uint32_t adler=__builtin_bswap32((uint32_t)bitbuf);
+					DROP(32);
+					if (adler!=z->check) goto error;
+				}
+				else if (z->format==TWR_Z_GZIP) {
+					NEEDBITS(32);
+					const uint32_t crc=(uint32_t)bitbuf;
+					DROP(32);
+					NEEDBITS(32);
+					const uint32_t isize=(uint32_t)bitbuf;
+					DROP(32);
+					if (crc!=z->check || isize!=z->total) goto error;
+				}
+				else {	// raw data may be followed by something else, so return any whole bytes read past its end
+					int unused=bitcnt>>3;
+					if (unused>in-in_start) unused=in-in_start;
+					in-=unused;
+					bitcnt-=unused*8;
+				}
+				z->state=ST_DONE;
+				break;
+
+			case ST_DONE:
+				rv=TWR_Z_END;
+				goto suspend;
+
+			default:
+				rv=TWR_Z_DATA_ERROR;
+				goto suspend;
+		}
+	}
+
+rollback:
+	in=save_in;
+	bitbuf=save_bitbuf;
+	bitcnt=save_bitcnt;
+	goto suspend;
+
+error:
+	z->state=ST_ERROR;
+	rv=TWR_Z_DATA_ERROR;
+
+suspend:
+	if (z->state!=ST_DONE) update_check(z, checked, out-checked);
+	z->bitbuf=bitbuf;
+	z->bitcnt=bitcnt;
+	*inp=in;
+	*outp=out;
+	return rv;
+}
+
+static void init(struct twr_inflate* z, int format) {
+	memset(z, 0, offsetof(struct twr_inflate, lit));
+	z->format=format;
+	z->state=ST_HEADER;
+}
+
+//*************************************************
+
+struct twr_inflate* twr_inflate_new(int format) {
+	if (format<TWR_Z_RAW || format>TWR_Z_AUTO) {
+		errno=EINVAL;
+		return NULL;
+	}
+
+	struct twr_inflate* z=malloc(sizeof(struct twr_inflate));
+	if (z==NULL) return NULL;
+	init(z, format);
+
+	z->window=malloc(WSIZE);
+	if (z->window==NULL) {
+		free(z);
+		return NULL;
+	}
+
+	return z;
+}
+
+int twr_inflate(struct twr_inflate* z, const void* in, size_t in_len, size_t* in_used, void* out, size_t out_len, size_t* out_made) {
+	const uint8_t* i=in;
+	uint8_t* o=out;
+	const int rv=run(z, &i, i+in_len, &o, o, o+out_len);
+
+	// keep the last WSIZE bytes of output for the next call
+	size_t n=o-(uint8_t*)out;
+	const uint8_t* from=o-n;
+	if (n>=WSIZE) {
+		from=o-WSIZE;
+		n=WSIZE;
+	}
+	while (n) {
+		size_t part=WSIZE-z->wpos;
+		if (part>n) part=n;
+		memcpy(z->window+z->wpos, from, part);
+		z->wpos=(z->wpos+part)&(WSIZE-1);
+		z->whave=z->whave+part>WSIZE ? WSIZE : z->whave+part;
+		from+=part;
+		n-=part;
+	}
+
+	*in_used=i-(const uint8_t*)in;
+	*out_made=o-(uint8_t*)out;
+	return rv;
+}
+
+void twr_inflate_free(struct twr_inflate* z) {
+	if (z) {
+		free(z->window);
+		free(z);
+	}
+}
+
+long twr_inflate_buf(const void* in, size_t in_len, void* out, size_t out_len, int format) {
+	if (format<TWR_Z_RAW || format>TWR_Z_AUTO) {
+		errno=EINVAL;
+		return -1;
+	}
+
+	struct twr_inflate* z=malloc(sizeof(struct twr_inflate));
+	if (z==NULL) return -1;
+	init(z, format);
+
+	const uint8_t* i=in;
+	uint8_t* o=out;
+	const int rv=run(z, &i, i+in_len, &o, o, o+out_len);
+	free(z);
+
+	if (rv==TWR_Z_END) return o-(uint8_t*)out;
+
+	errno=(rv==TWR_Z_OK && o==(uint8_t*)out+out_len) ? ENOSPC : EINVAL;
+	return -1;
+}
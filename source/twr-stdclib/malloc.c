@@ -207,12 +207,31 @@ void* calloc( size_t num, size_t size ) {
 
 // Regular malloc aligns memory suitable for any object type with a fundamental alignment. 
 // The aligned_alloc is useful for over-aligned allocations, such as to SSE, cache line, or VM page boundary.
-// Which this simple version doesn't support
+// alignment must be a power of 2.  The free units skipped to align the allocation stay free.
 
 void *aligned_alloc( size_t alignment, size_t size ) {
-	if (alignment<1 || alignment > ALLOC_SIZE) return NULL;
+	if (alignment<1 || (alignment&(alignment-1))) return NULL;
+	if (alignment<=ALLOC_SIZE) return malloc(size);
+	if (size==0) return NULL;
 
-	return malloc(size);
+	const size_t size_in_alloc_units = (size+ALLOC_SIZE-1)/ALLOC_SIZE;
+	unsigned long start=0;
+	unsigned long len;
+
+	while (find_next_free_chunk(&start, &len)) {
+		unsigned long s=start;
+		while (((uintptr_t)&heap[s+2])&(alignment-1))  /* the allocation follows the two header units */
+			s++;
+		if (s+size_in_alloc_units+2 <= start+len) {
+			take_some_memory(s, size_in_alloc_units);
+			return &heap[s+2];
+		}
+		start=start+len;
+	}
+
+	twr_conlog("aligned_alloc failed to alloc mem of size %d, alignment %d, note avail mem is %d", size, alignment, avail());
+
+	return NULL;
 }
 
 /************************************************/
@@ -543,6 +562,23 @@ int malloc_unit_test() {
 		return 0;
 	}	
 
+{
+// aligned_alloc
+	const size_t sz=avail();
+	void* m8=malloc(8);   /* so that the first free unit is not always aligned */
+	for (size_t align=16; align<=256; align*=2) {
+		char* mem1=aligned_alloc(align, 40);
+		if (mem1==NULL || ((uintptr_t)mem1&(align-1))) return 0;
+		set_mem(mem1, 40, 0xAA);
+		if (validate_malloc("aligned_alloc", mem1, 40)==0)
+			return 0;
+		free(mem1);
+	}
+	if (aligned_alloc(24, 8)!=NULL) return 0;
+	free(m8);
+	if (avail()!=sz) return 0;
+}
+
 {
     void* mem1=twr_cache_malloc(20);
     if (!mem1) return 0;
@@ -0,0 +1,275 @@
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "twr-crt.h"
+
+// twr_memfs is the in-memory file system that fopen() uses by default.
+//
+// JavaScript adds files with twrWasmModuleBase.addFile(), which copies the data into module memory once, and then
+// calls twr_wasm_memfs_add() (initwasm.c).  The file takes ownership of that memory, and a FILE opened read only
+// maps it (so fread reads it directly).  C can also create files with fopen(path, "w").
+//
+// A file may be open by any number of readers, or by one writer.  Paths are case sensitive, and a leading "/" or "./"
+// is ignored, so "/data/a.txt", "./data/a.txt" and "data/a.txt" are the same file.
+
+struct memfs_node {
+	struct memfs_node* next;
+	char* data;
+	size_t len;
+	size_t cap;
+	int readers;
+	bool writer;
+	bool removed;	// removed while open or mapped.  freed on the last release
+	char path[];
+};
+
+struct memfs_handle {
+	struct memfs_node* node;
+	bool write;
+};
+
+static struct memfs_node* nodes;
+
+static const char* normalize(const char* path) {
+	for (;;) {
+		if (path[0]=='/') path++;
+		else if (path[0]=='.' && path[1]=='/') path+=2;
+		else return path;
+	}
+}
+
+static struct memfs_node** find(const char* path) {
+	path=normalize(path);
+	struct memfs_node** p=&nodes;
+	while (*p && ((*p)->removed || strcmp((*p)->path, path)!=0))
+		p=&(*p)->next;
+	return p;
+}
+
+static struct memfs_node* new_node(const char* path, char* data, size_t len) {
+	path=normalize(path);
+	const size_t pathlen=strlen(path);
+	struct memfs_node* node=malloc(sizeof(struct memfs_node)+pathlen+1);
+	if (node==NULL) return NULL;
+
+	memset(node, 0, sizeof(struct memfs_node));
+	memcpy(node->path, path, pathlen+1);
+	node->data=data;
+	node->len=len;
+	node->cap=len;
+	node->next=nodes;
+	nodes=node;
+
+	return node;
+}
+
+// a node that is open (or mapped) when it is removed stays in the list, marked removed, until it is released
+static void unlink_node(struct memfs_node** p) {
+	struct memfs_node* node=*p;
+	if (node->readers || node->writer) {
+		node->removed=true;
+	}
+	else {
+		*p=node->next;
+		free(node->data);
+		free(node);
+	}
+}
+
+static void release_node(struct memfs_node* node) {
+	if (node->removed && !node->writer && node->readers==0) {
+		struct memfs_node** p=&nodes;
+		while (*p!=node) p=&(*p)->next;
+		node->removed=false;
+		unlink_node(p);
+	}
+}
+
+//*************************************************
+
+static void* memfs_open(const char* path, int flags) {
+	struct memfs_node** p=find(path);
+	struct memfs_node* node=*p;
+
+	if (node) {
+		if ((flags&TWR_FS_EXCL)) {
+			errno=EEXIST;
+			return NULL;
+		}
+		if (node->writer || ((flags&TWR_FS_WRITE) && node->readers)) {
+			errno=EBUSY;
+			return NULL;
+		}
+	}
+	else {
+		if (!(flags&TWR_FS_CREATE)) {
+			errno=ENOENT;
+			return NULL;
+		}
+	}
+
+	struct memfs_handle* h=malloc(sizeof(struct memfs_handle));
+	if (h==NULL) {
+		errno=ENOMEM;
+		return NULL;
+	}
+
+	if (node==NULL) {
+		node=new_node(path, NULL, 0);
+		if (node==NULL) {
+			free(h);
+			errno=ENOMEM;
+			return NULL;
+		}
+	}
+	h->node=node;
+	h->write=(flags&TWR_FS_WRITE)!=0;
+
+	if (h->write) {
+		node->writer=true;
+		if (flags&TWR_FS_TRUNC) node->len=0;
+	}
+	else {
+		node->readers++;
+	}
+
+	return h;
+}
+
+static int memfs_close(void* handle) {
+	struct memfs_handle* h=handle;
+	struct memfs_node* node=h->node;
+
+	if (h->write) node->writer=false;
+	else node->readers--;
+	free(h);
+
+	release_node(node);
+
+	return 0;
+}
+
+static long memfs_read(void* handle, long offset, char* buf, long len) {
+	struct memfs_node* node=((struct memfs_handle*)handle)->node;
+
+	if ((size_t)offset>=node->len) return 0;
+	if ((size_t)len>node->len-offset) len=node->len-offset;
+	memcpy(buf, node->data+offset, len);
+	return len;
+}
+
+static long memfs_write(void* handle, long offset, const char* buf, long len) {
+	struct memfs_node* node=((struct memfs_handle*)handle)->node;
+	const size_t end=offset+len;
+
+	if (end>node->cap) {
+		size_t cap=node->cap<256 ? 256 : node->cap;
+		while (cap<end) cap*=2;
+		char* data=realloc(node->data, cap);
+		if (data==NULL) {
+			errno=ENOSPC;
+			return -1;
+		}
+		node->data=data;
+		node->cap=cap;
+	}
+
+	if ((size_t)offset>node->len)		// writing past the end leaves a hole of zeros
+		memset(node->data+node->len, 0, offset-node->len);
+
+	memcpy(node->data+offset, buf, len);
+	if (end>node->len) node->len=end;
+	return len;
+}
+
+static long memfs_size(void* handle) {
+	return ((struct memfs_handle*)handle)->node->len;
+}
+
+static const char* memfs_map(void* handle, long* len) {
+	struct memfs_node* node=((struct memfs_handle*)handle)->node;
+	*len=node->len;
+	return node->data ? node->data : "";
+}
+
+static int memfs_remove(const char* path) {
+	struct memfs_node** p=find(path);
+	if (*p==NULL) {
+		errno=ENOENT;
+		return -1;
+	}
+
+	unlink_node(p);
+	return 0;
+}
+
+static const struct twr_fs_backend memfs={
+	memfs_open,
+	memfs_close,
+	memfs_read,
+	memfs_write,
+	memfs_size,
+	memfs_map,
+	memfs_remove
+};
+
+const struct twr_fs_backend* twr_memfs(void) {
+	return &memfs;
+}
+
+//*************************************************
+
+// adds (or replaces) a file.  data must be from malloc, and is owned (and eventually freed) by the file system.
+// returns 0, or -1 with errno set (EBUSY if the file is open)
+int twr_memfs_add(const char* path, char* data, size_t len) {
+	struct memfs_node** p=find(path);
+
+	if (*p) {
+		if ((*p)->readers || (*p)->writer) {
+			errno=EBUSY;
+			return -1;
+		}
+		unlink_node(p);
+	}
+
+	if (new_node(path, data, len)==NULL) {
+		errno=ENOMEM;
+		return -1;
+	}
+
+	return 0;
+}
+
+//*************************************************
+
+// the contents of a file, without a copy.  A mapped file counts as open for reading, so it can't be written, replaced,
+// or freed (by remove) until it is unmapped.  Files added by JavaScript are 16 byte aligned.  Returns NULL (errno ENOENT)
+// if there is no such file.
+const void* twr_map_asset(const char* name, size_t* len) {
+	struct memfs_node* node=*find(name);
+	if (node==NULL) {
+		errno=ENOENT;
+		return NULL;
+	}
+	if (node->writer) {		// a write can move the data
+		errno=EBUSY;
+		return NULL;
+	}
+
+	node->readers++;
+	if (len) *len=node->len;
+	return node->data ? node->data : node->path+strlen(node->path);	// an empty file is a pointer to zero bytes
+}
+
+// releases a view returned by twr_map_asset
+void twr_unmap_asset(const void* data) {
+	for (struct memfs_node* node=nodes; node; node=node->next) {
+		if ((node->data ? node->data : node->path+strlen(node->path))==data && node->readers>0) {
+			node->readers--;
+			release_node(node);
+			return;
+		}
+	}
+}
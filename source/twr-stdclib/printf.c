@@ -1,5 +1,6 @@
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
@@ -9,40 +10,27 @@
 #include "twr-crt.h"
 
 
-// de-featured printf
-
-static void outstr(twr_vcbprintf_callback out, void* cbdata, char *buffer, int size) {
-	while (*buffer && size >0) {
-		out(cbdata, *buffer);
-		buffer++;
-		size--;
-	}
-}
+// printf family.  Everything formats through twr_vcbprintf_span()
 
 #define valid_flag(flag) (flag=='-' || flag==' ' || flag=='+' || flag=='#' || flag=='0')
-#define valid_specifier(sp) (sp=='d' || sp=='x' || sp=='s' || sp=='f' || sp=='g' || sp=='e' || sp=='c')
+#define valid_specifier(sp) (sp=='d' || sp=='i' || sp=='u' || sp=='o' || sp=='x' || sp=='X' || sp=='p' || sp=='s' || sp=='f' || sp=='g' || sp=='e' || sp=='c')
 
 //%[flags][width][.precision][length]specifier
-//valid lengths: h hh l ll j z t L
-
-struct pformat {
-	char flag;
-	char specifier;
-	long width;
-	long precision;
-	bool flag_minus;
-	bool flag_zero;
-	bool flag_space;
-};
+//valid lengths: h hh l ll j z t  (L is not supported)
+
+enum plength {PLEN_NONE, PLEN_HH, PLEN_H, PLEN_L, PLEN_LL, PLEN_J, PLEN_Z, PLEN_T};
 
-static char* read_format(const char* format, struct pformat* pf, va_list * vlist) {
-	pf->flag=0;
+static char* read_format(const char* format, struct twr_printf_spec* pf, enum plength* length, va_list * vlist) {
 	pf->specifier=0;
 	pf->width=0;
 	pf->precision=6;
+	pf->precision_set=false;
+	*length=PLEN_NONE;
 	pf->flag_minus=false;
 	pf->flag_zero=false;
 	pf->flag_space=false;
+	pf->flag_plus=false;
+	pf->flag_hash=false;
 
 	while (1) {
 		char c=*format;
@@ -50,10 +38,16 @@ static char* read_format(const char* format, struct pformat* pf, va_list * vlist
 		if (c=='-') pf->flag_minus=true;
 		else if (c=='0') pf->flag_zero=true;
 		else if (c==' ') pf->flag_space=true;
+		else if (c=='+') pf->flag_plus=true;
+		else if (c=='#') pf->flag_hash=true;
 		format++;
 	}
 	if (*format=='*') {
 		pf->width=va_arg(*vlist, int);
+		if (pf->width<0) {  // a negative * width is a '-' flag
+			pf->flag_minus=true;
+			pf->width=-pf->width;
+		}
 		format++;
 	}
 	else {
@@ -61,8 +55,13 @@ static char* read_format(const char* format, struct pformat* pf, va_list * vlist
 	}
 	if (*format=='.') {
 		format++;
+		pf->precision_set=true;
 		if (*format=='*') {
 			pf->precision=va_arg(*vlist, int);
+			if (pf->precision<0) {  // a negative * precision is taken as if it were omitted
+				pf->precision=6;
+				pf->precision_set=false;
+			}
 			format++;
 		}
 		else {
@@ -70,10 +69,28 @@ static char* read_format(const char* format, struct pformat* pf, va_list * vlist
 		}
 	}
 
-	//the only length modifier currently supported is 'l', and its ignored since its generally the default
-	if (*format=='l') {
-		format++;
+	switch (*format) {
+		case 'h':
+			format++;
+			if (*format=='h') {
+				*length=PLEN_HH;
+				format++;
+			}
+			else *length=PLEN_H;
+			break;
+		case 'l':
+			format++;
+			if (*format=='l') {
+				*length=PLEN_LL;
+				format++;
+			}
+			else *length=PLEN_L;
+			break;
+		case 'j': *length=PLEN_J; format++; break;
+		case 'z': *length=PLEN_Z; format++; break;
+		case 't': *length=PLEN_T; format++; break;
 	}
+
 	pf->specifier=*format;
 	if (valid_specifier(pf->specifier)) {
 		format++;
@@ -85,143 +102,239 @@ static char* read_format(const char* format, struct pformat* pf, va_list * vlist
 	}
 }
 
+static int64_t va_arg_signed(va_list* vlist, enum plength length) {
+	switch (length) {
+		case PLEN_HH: return (signed char)va_arg(*vlist, int);
+		case PLEN_H:  return (short)va_arg(*vlist, int);
+		case PLEN_L:  return va_arg(*vlist, long);
+		case PLEN_LL: return va_arg(*vlist, long long);
+		case PLEN_J:  return va_arg(*vlist, intmax_t);
+		case PLEN_Z:  return (ptrdiff_t)va_arg(*vlist, size_t);   // the signed type that matches size_t
+		case PLEN_T:  return va_arg(*vlist, ptrdiff_t);
+		default:      return va_arg(*vlist, int);
+	}
+}
+
+static uint64_t va_arg_unsigned(va_list* vlist, enum plength length) {
+	switch (length) {
+		case PLEN_HH: return (unsigned char)va_arg(*vlist, unsigned int);
+		case PLEN_H:  return (unsigned short)va_arg(*vlist, unsigned int);
+		case PLEN_L:  return va_arg(*vlist, unsigned long);
+		case PLEN_LL: return va_arg(*vlist, unsigned long long);
+		case PLEN_J:  return va_arg(*vlist, uintmax_t);
+		case PLEN_Z:  return va_arg(*vlist, size_t);
+		case PLEN_T:  return (size_t)va_arg(*vlist, ptrdiff_t);
+		default:      return va_arg(*vlist, unsigned int);
+	}
+}
+
 static const char zstr[]=  "00000000000000000000";  // 20 zeros
 static const char spcstr[]="                    ";  // 20 spaces
 
-void static do_width(const char* in, char* assembly, int size_assembly, bool pad_zeros, int width) {
-	const int len=strlen(in);
-	int padlen=width-len;
-	if (padlen<0) padlen=0;
-	nstrcopy(assembly, size_assembly, pad_zeros?zstr:spcstr, sizeof(zstr), padlen);
-	strcat_s(assembly, size_assembly, in);
+// output n copies of c (which must be ' ' or '0')
+static void outpad(twr_vcbprintf_span_callback out, void* cbdata, char c, int n) {
+	const char* pad=c=='0'?zstr:spcstr;
+	while (n>0) {
+		const int k=n<(int)sizeof(zstr)-1?n:(int)sizeof(zstr)-1;
+		out(cbdata, pad, k);
+		n-=k;
+	}
 }
 
-void twr_vcbprintf(twr_vcbprintf_callback out, void* cbdata, const char *format, va_list vlist) {
-	struct pformat pf;
+// output str (len bytes) padded to the width, with - (left justify) handled.  used for s and c
+void twr_printf_str(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* pf, const char* str, int len) {
+	const int padlen=pf->width-len;
+	if (padlen>0 && !pf->flag_minus) outpad(out, cbdata, ' ', padlen);
+	if (len>0) out(cbdata, str, len);
+	if (padlen>0 && pf->flag_minus) outpad(out, cbdata, ' ', padlen);
+}
+
+// d i u o x X p
+// the field is [spaces][sign or 0x prefix][zeros][digits][spaces] and is assembled in one buffer and written as one span
+void twr_printf_int(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* pf, uint64_t magnitude, bool negative) {
+	const char sp=pf->specifier;
+	const int radix=(sp=='x' || sp=='X' || sp=='p')?16:(sp=='o'?8:10);
+	const bool is_signed=(sp=='d' || sp=='i');
+	char digits[24];   // octal UINT64_MAX is 22 digits
+	char* const dend=digits+sizeof(digits);
+
+	int ndigits=twr_u64toa_end(magnitude, dend, radix, sp=='X');
+	if (magnitude==0 && pf->precision_set && pf->precision==0) ndigits=0;   // %.0d of 0 is no digits
+
+	char prefix[2];
+	int nprefix=0;
+	if (is_signed) {
+		if (negative) prefix[nprefix++]='-';
+		else if (pf->flag_plus) prefix[nprefix++]='+';
+		else if (pf->flag_space) prefix[nprefix++]=' ';
+	}
+	else if (sp=='p' || (pf->flag_hash && magnitude!=0 && radix==16)) {
+		prefix[nprefix++]='0';
+		prefix[nprefix++]=sp=='X'?'X':'x';
+	}
+
+	int nzeros=0;
+	if (pf->precision_set && sp!='p') {
+		if (pf->precision>ndigits) nzeros=pf->precision-ndigits;
+	}
+	else if (pf->flag_zero && !pf->flag_minus) {
+		const int fill=pf->width-nprefix-ndigits;
+		if (fill>0) nzeros=fill;
+	}
+	if (sp=='o' && pf->flag_hash && nzeros==0 && (ndigits==0 || dend[-ndigits]!='0')) nzeros=1;   // # makes octal start with a 0
+
+	const int len=nprefix+nzeros+ndigits;
+	if (len>(int)sizeof(digits)+16) {   // only with a large precision
+		const int padlen=pf->width-len;
+		if (padlen>0 && !pf->flag_minus) outpad(out, cbdata, ' ', padlen);
+		if (nprefix) out(cbdata, prefix, nprefix);
+		outpad(out, cbdata, '0', nzeros);
+		if (ndigits) out(cbdata, dend-ndigits, ndigits);
+		if (padlen>0 && pf->flag_minus) outpad(out, cbdata, ' ', padlen);
+	}
+	else {
+		char field[sizeof(digits)+16];
+		char* f=field;
+		for (int i=0; i<nprefix; i++) *f++=prefix[i];
+		for (int i=0; i<nzeros; i++) *f++='0';
+		memcpy(f, dend-ndigits, ndigits);
+		twr_printf_str(out, cbdata, pf, field, len);
+	}
+}
+
+// f e g
+// the field is [spaces][sign][zeros][digits][spaces].  zero fill is only used for finite values
+void twr_printf_double(twr_vcbprintf_span_callback out, void* cbdata, const struct twr_printf_spec* pf, double value) {
+	// max double is 309 digits before the decimal point.  A large precision uses malloc, not the (small) stack
+	char small[312+64];
+	char* buffer=small;
+	int size=sizeof(small);
+	int precision=pf->precision;
+	if (312+precision > size) {
+		buffer=malloc(312+precision);
+		if (buffer) {
+			size=312+precision;
+		}
+		else {
+			buffer=small;
+			precision=size-312;
+		}
+	}
+
+	if (pf->specifier=='f')
+		twr_tofixed(buffer, size, value, precision);
+	else if (pf->specifier=='e')
+		twr_toexponential(buffer, size, value, precision);
+	else {
+		twr_dtoa(buffer, size, value, precision);
+		twr_localize_numeric_string(buffer, twr_get_current_locale());
+	}
+
+	const char* digits=buffer;
+	char sign=0;
+	if (*digits=='-') sign=*digits++;
+	else if (pf->flag_plus) sign='+';
+	else if (pf->flag_space) sign=' ';
+
+	const int ndigits=strlen(digits);
+	const int len=(sign?1:0)+ndigits;
+	const int padlen=pf->width-len;
+	const bool zero_fill=pf->flag_zero && !pf->flag_minus && *digits>='0' && *digits<='9';
+
+	if (padlen>0 && !pf->flag_minus && !zero_fill) outpad(out, cbdata, ' ', padlen);
+	if (sign) out(cbdata, &sign, 1);
+	if (padlen>0 && zero_fill) outpad(out, cbdata, '0', padlen);
+	out(cbdata, digits, ndigits);
+	if (padlen>0 && pf->flag_minus) outpad(out, cbdata, ' ', padlen);
+
+	if (buffer!=small) free(buffer);
+}
+
+// output is sent to the callback a span at a time: each run of literal text in the format, and each converted value
+void twr_vcbprintf_span(twr_vcbprintf_span_callback out, void* cbdata, const char *format, va_list vlist) {
+	struct twr_printf_spec pf;
+	enum plength length;
 
 	while (*format) {
 		if (*format == '%') {
 			format++;
-			format=read_format(format, &pf, &vlist);
+			format=read_format(format, &pf, &length, &vlist);
 			switch (pf.specifier) {
 				case 'd':
+				case 'i':
 				{
-					char buffer[20];
-					char assembly[20];
-					int assemoff;
-					int val=va_arg(vlist, int);
-					_itoa_s(val, buffer, sizeof(buffer), 10);
-
-					if (val>=0 && pf.flag_space) {
-						assembly[0]=' ';
-						assemoff=1;
-					}
-					else {
-						assemoff=0;
-					}
-
-					do_width(buffer, assembly+assemoff, sizeof(assembly)-assemoff, pf.flag_zero, pf.width);
-					outstr(out, cbdata, assembly, sizeof(assembly));
+					const int64_t val=va_arg_signed(&vlist, length);
+					twr_printf_int(out, cbdata, &pf, val<0 ? 0-(uint64_t)val : (uint64_t)val, val<0);
 				}
 					break;
 
+				case 'u':
+				case 'o':
 				case 'x':
-				{
-					char buffer[16];
-					char assembly[16];
-					_itoa_s(va_arg(vlist, int), buffer, sizeof(buffer), 16);
-					do_width(buffer, assembly, sizeof(assembly), pf.flag_zero, pf.width);
-					outstr(out, cbdata, assembly, sizeof(assembly));
-
-				}
+				case 'X':
+					twr_printf_int(out, cbdata, &pf, va_arg_unsigned(&vlist, length), false);
 					break;
 
-				case 'f':
-				{
-					char buffer[30];
-					char assembly[30];
-					int assemoff;
-					double val=va_arg(vlist, double);
-					twr_tofixed(buffer, sizeof(buffer), val, pf.precision);
-					
-					if (val>=0 && pf.flag_space) {
-						assembly[0]=' ';
-						assemoff=1;
-					}
-					else {
-						assemoff=0;
-					}
-
-					do_width(buffer, assembly+assemoff, sizeof(assembly)-assemoff, pf.flag_zero, pf.width);
-					outstr(out, cbdata, assembly, sizeof(assembly));
-				}
+				case 'p':
+					twr_printf_int(out, cbdata, &pf, (uintptr_t)va_arg(vlist, void*), false);
 					break;
 
+				case 'f':
 				case 'e':
-				{
-					char buffer[30];
-					char assembly[30];
-					int assemoff;
-					double val=va_arg(vlist, double);
-					twr_toexponential(buffer, sizeof(buffer), val, pf.precision);
-					
-					if (val>=0 && pf.flag_space) {
-						assembly[0]=' ';
-						assemoff=1;
-					}
-					else {
-						assemoff=0;
-					}
-
-					do_width(buffer, assembly+assemoff, sizeof(assembly)-assemoff, pf.flag_zero, pf.width);
-					outstr(out, cbdata, assembly, sizeof(assembly));
-				}
-					break;
-
 				case 'g':
-				{
-					char buffer[30];
-					char assembly[30];
-					double val=va_arg(vlist, double);
-					int assemoff;
-					twr_dtoa(buffer, sizeof(buffer), val, pf.precision);
-					twr_localize_numeric_string(buffer, twr_get_current_locale());
-					
-					if (val>=0 && pf.flag_space) {
-						assembly[0]=' ';
-						assemoff=1;
-					}
-					else {
-						assemoff=0;
-					}
-					do_width(buffer, assembly+assemoff, sizeof(assembly)-assemoff, pf.flag_zero, pf.width);
-					outstr(out, cbdata, assembly, sizeof(assembly));
-				}
+					twr_printf_double(out, cbdata, &pf, va_arg(vlist, double));
 					break;
 
 				case 's': 
-					outstr(out, cbdata, va_arg(vlist, char *), 100000);  // arbitrary max of 100K string length
+				{
+					const char* str=va_arg(vlist, char *);
+					if (str==NULL) str="(null)";
+					const int max=pf.precision_set?pf.precision:100000;  // arbitrary max of 100K string length
+					int len=0;
+					while (len<max && str[len]) len++;
+					twr_printf_str(out, cbdata, &pf, str, len);
+				}
 					break;
 
 				case 'c': 
 				{
-					const int c=va_arg(vlist, int);
-					out(cbdata, c);
+					const char c=(char)va_arg(vlist, int);
+					twr_printf_str(out, cbdata, &pf, &c, 1);
 				}
 					break;
 
 				default:  // invalid format, just punt and print it
-					out(cbdata, *format);
-					format++;
+					if (*format) {
+						out(cbdata, format, 1);
+						format++;
+					}
 			}
 		}
 		else { // not a %
-			out(cbdata, *format);
-			format++;
+			const char* run=format;
+			while (*format && *format!='%') format++;
+			out(cbdata, run, format-run);
 		}
 	}
 }
 
+struct bytes_callback_data {
+	twr_vcbprintf_callback out;
+	void* cbdata;
+};
+
+static void bytes_callback(void* datain, const char* buf, size_t len) {
+	struct bytes_callback_data *const data=datain;
+	for (size_t i=0; i<len; i++)
+		data->out(data->cbdata, (unsigned char)buf[i]);
+}
+
+// same as twr_vcbprintf_span, but the callback is called once per byte
+void twr_vcbprintf(twr_vcbprintf_callback out, void* cbdata, const char *format, va_list vlist) {
+	struct bytes_callback_data data={.out=out, .cbdata=cbdata};
+	twr_vcbprintf_span(bytes_callback, &data, format, vlist);
+}
+
 /*************/
 
 struct snprintf_callback_data {
@@ -230,12 +343,13 @@ struct snprintf_callback_data {
 	size_t pos;
 };
 
-static void snprintf_callback(void* datain, unsigned char ch) {
+static void snprintf_callback(void* datain, const char* buf, size_t len) {
 	struct snprintf_callback_data *const data=datain;
 	if (data->pos+1 < data->bufsz) {  // leave room for terminating zero
-		data->buffer[data->pos]=(char)ch;
+		const size_t room=data->bufsz-1-data->pos;
+		memcpy(data->buffer+data->pos, buf, len<room?len:room);
 	}
-	data->pos++;
+	data->pos+=len;
 }
 
 // if bufsz==0 the number of character that would have been written is counted, but nothing is written to buffer
@@ -243,7 +357,7 @@ static void snprintf_callback(void* datain, unsigned char ch) {
 int vsnprintf(char *buffer, size_t bufsz, const char *format, va_list vlist) {
 	assert(bufsz==0 || buffer);
 	struct snprintf_callback_data data = {.buffer=buffer, .bufsz=bufsz, .pos=0};
-	twr_vcbprintf(snprintf_callback, &data, format, vlist);
+	twr_vcbprintf_span(snprintf_callback, &data, format, vlist);
 	if (buffer && data.bufsz) buffer[__min(data.pos, bufsz-1)]=0; 
 	return data.pos;
 }
@@ -274,37 +388,81 @@ int sprintf( char *buffer, const char *format, ... ) {
 
 /*************/
 
-int vasprintf(char **strp, const char* format, va_list vlist ) {
+struct asprintf_callback_data {
+	char* buffer;
+	size_t size;
+	size_t pos;
+	bool failed;
+};
+
+// the buffer is grown by doubling, so the format is only run once
+static void asprintf_callback(void* datain, const char* buf, size_t len) {
+	struct asprintf_callback_data *const data=datain;
+	if (data->failed) return;
+
+	if (data->pos+len+1 > data->size) {  // +1 for the terminating zero
+		size_t newsize=data->size*2;
+		while (newsize < data->pos+len+1) newsize*=2;
+		char* newbuf=realloc(data->buffer, newsize);
+		if (newbuf==NULL) {
+			data->failed=true;
+			return;
+		}
+		data->buffer=newbuf;
+		data->size=newsize;
+	}
+
+	memcpy(data->buffer+data->pos, buf, len);
+	data->pos+=len;
+}
 
-	va_list args2;
-   va_copy(args2, vlist);
+// *strp is set to a malloc'd string, which must be free'd.  returns the string length, or -1 if out of memory (and *strp is set to NULL)
+int vasprintf(char **strp, const char* format, va_list vlist ) {
+	struct asprintf_callback_data data = {.buffer=malloc(64), .size=64, .pos=0, .failed=false};
 
-	int k=vsnprintf(NULL, 0, format, vlist);
+	if (data.buffer) twr_vcbprintf_span(asprintf_callback, &data, format, vlist);
 
-	void* buffer=malloc(k+1);
-	vsnprintf(buffer, k+1, format, args2);
-   va_end(args2);
+	if (data.buffer==NULL || data.failed) {
+		free(data.buffer);
+		*strp=NULL;
+		return -1;
+	}
 
-	return k;
+	data.buffer[data.pos]=0;
+	*strp=data.buffer;
+	return data.pos;
 }
 
 /*************/
 
-struct putc_cbdata {
+// output is collected here and written a span at a time, so that even an unbuffered stream (like stderr)
+// gets one write per call instead of one per span.  spans too big for buf are written directly.
+struct fprintf_cbdata {
 	int count;
 	FILE* stream;
+	int len;
+	char buf[128];
 };
 
-static void putc_callback(void* datain, unsigned char ch) {
-	struct putc_cbdata *d=datain;
-	d->count++;
-	io_putc(d->stream, ch);
+static void fprintf_callback(void* datain, const char* str, size_t len) {
+	struct fprintf_cbdata *d=datain;
+	d->count+=len;
+	if (d->len+len > sizeof(d->buf)) {
+		if (d->len) {
+			io_write(d->stream, d->buf, d->len);
+			d->len=0;
+		}
+		if (len >= sizeof(d->buf)) {
+			io_write(d->stream, str, len);
+			return;
+		}
+	}
+	memcpy(d->buf+d->len, str, len);
+	d->len+=len;
 }
 
 int vprintf(const char* format, va_list vlist ) {
-	struct putc_cbdata ud = {.stream=stdout, .count=0};
-	twr_vcbprintf(putc_callback, &ud, format, vlist);
-	return ud.count;
+	return vfprintf(stdout, format, vlist);
 }
 
 int printf(const char* format, ...) {
@@ -324,7 +482,7 @@ void twr_conlog(const char* format, ...) {
 	va_list vlist;
 	va_start(vlist, format);
 
-	twr_vcbprintf((twr_vcbprintf_callback)io_putc, stderr, format, vlist);
+	vfprintf(stderr, format, vlist);
 	io_putc(twr_get_stderr_con(), 0x3);  // ASCII EOT is used to flush the buffer and make sure the line prints to the console.
 
 	va_end(vlist);
@@ -334,9 +492,10 @@ void twr_conlog(const char* format, ...) {
 
 // reurns the number of characters written if successful or negative value if an error occurred.
 int vfprintf( FILE *stream, const char *format, va_list vlist ) {
-	struct putc_cbdata ud = {.stream=stream, .count=0};
+	struct fprintf_cbdata ud = {.stream=stream, .count=0, .len=0};
 
-	twr_vcbprintf(putc_callback, &ud, format, vlist);
+	twr_vcbprintf_span(fprintf_callback, &ud, format, vlist);
+	if (ud.len) io_write(stream, ud.buf, ud.len);
 	return ud.count;
 }
 
@@ -351,31 +510,64 @@ int fprintf(FILE *stream, const char* format, ...) {
 	return rv;
 }
 
+static inline bool is_file(FILE *stream) {
+	return stream && (stream->header.type&IO_TYPE_FILE);
+}
+
 size_t fwrite( const void* buffer, size_t size, size_t count, FILE* stream ) {
-	size_t k=size*count;
-	const unsigned char *p=buffer;
+	if (size==0 || count==0) return 0;
+	if (is_file(stream) && __twr_file_error(stream)) return 0;
+	io_write(stream, buffer, size*count);
+	if (is_file(stream) && __twr_file_error(stream)) return 0;
+	return count;
+}
 
-	while (k--) {
-		io_putc(stream, *p++);
-	}
+// stdin is read with getc()
+size_t fread(void* buffer, size_t size, size_t count, FILE* stream) {
+	if (size==0 || count==0) return 0;
 
+	if (is_file(stream))
+		return __twr_file_read(stream, buffer, size*count)/size;
+
+	unsigned char* dest=buffer;
+	for (size_t i=0; i<size*count; i++)
+		dest[i]=getc(stream);
 	return count;
 }
 
 int ferror(FILE *stream) {
-	return 0;
+	return is_file(stream) ? __twr_file_error(stream) : 0;
 }
 
 int feof(FILE *stream) {
-	return 0;
+	return is_file(stream) ? __twr_file_eof(stream) : 0;
 }
 
+// fflush(NULL) flushes stdout, stderr and open files
 int fflush(FILE *stream) {
-	return 0;
+	if (stream==NULL) {
+		io_flush(twr_get_stdio_con());
+		if (twr_get_stderr_con()) io_flush(twr_get_stderr_con());
+		__twr_file_flush_all();
+		return 0;
+	}
+	if (is_file(stream))
+		return __twr_file_flush(stream);
+	return io_flush(stream);
+}
+
+int setvbuf(FILE* stream, char* buf, int mode, size_t size) {
+	if (is_file(stream))
+		return __twr_file_setvbuf(stream, buf, mode, size);
+	return io_setvbuf(stream, buf, mode, size);
+}
+
+void setbuf(FILE* stream, char* buf) {
+	setvbuf(stream, buf, buf?_IOFBF:_IONBF, BUFSIZ);
 }
 
 int is_terminal(FILE *stream) {
-	return 1;
+	return !is_file(stream);
 }
 
 int putc(int ch, FILE* stream) {
@@ -387,7 +579,15 @@ int fputc(int ch, FILE* stream) {
 	return putc(ch, stream);
 }
 
+int fputs(const char* str, FILE* stream) {
+	io_write(stream, str, strlen(str));
+	return ferror(stream) ? EOF : 1;
+}
+
 int getc(FILE *stream) {
+	if (is_file(stream))
+		return __twr_file_getc(stream);
+
 	int c = io_getc32(stream);
 	if (c>255) c=0;
 	else if (c>127) {
@@ -403,32 +603,32 @@ int fgetc(FILE *stream) {
 	return getc(stream);
 }
 
-// these three functions are not yet implemented
-// here to get libcxx to compile
-int vsscanf(const char *buffer, const char *format, va_list arglist) {
-	twr_conlog("vsscanf is not currently implemented.");
-	assert(false);
-	return EOF;
-}
+char* fgets(char* str, int count, FILE* stream) {
+	if (is_file(stream))
+		return __twr_file_gets(str, count, stream);
 
-int sscanf( const char *buffer, const char *format, ... ) {
-	twr_conlog("sscanf is not currently implemented.");
-	assert(false);
-	return EOF;
+	int i=0;
+	while (i<count-1) {
+		const int c=getc(stream);
+		str[i++]=c;
+		if (c=='\n') break;
+	}
+	if (count>0) str[i]=0;
+	return count>0 ? str : NULL;
 }
 
+// only supported on files
 int ungetc( int ch, FILE *stream ) {
-	twr_conlog("ungetc is not currently implemented.");
-	assert(false);
+	if (is_file(stream))
+		return __twr_file_ungetc(ch, stream);
 	return EOF;
 }
 
-
 /*************/
 
 // this function is used by clang printf builtin
 int puts(const char *str) {
-	io_putstr(stdout, str);
+	io_write(stdout, str, strlen(str));
 	io_putc(stdout,'\n');
 	return 1;
 }
@@ -442,8 +642,17 @@ int putchar(int c) {
 /*************/
 
 
+static int vasprintf_test_helper(char **strp, const char* format, ...) {
+	va_list vlist;
+	va_start(vlist, format);
+	const int rv=vasprintf(strp, format, vlist);
+	va_end(vlist);
+	return rv;
+}
+
 int printf_unit_test() {
 	char b[100];
+	char* s;
 	int k;
 
 	// g
@@ -498,6 +707,12 @@ int printf_unit_test() {
 
 	snprintf(b, sizeof(b), "%8.2f", 123.45678);
 	if (strcmp(b, "  123.46")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%.2f", 1e22);
+	if (strcmp(b, "10000000000000000000000.00")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%.30f", 0.1);
+	if (strcmp(b, "0.100000000000000005551115123126")!=0) return 0;
 	 
 // e
 
@@ -519,13 +734,28 @@ int printf_unit_test() {
 	snprintf(b, sizeof(b), "%6.2e", -.5);
 	if (strcmp(b, "-5.00e-1")!=0) return 0;
 
+	snprintf(b, sizeof(b), "%.3e", 5e-324);
+	if (strcmp(b, "4.941e-324")!=0) return 0;
+
 // x
 
 	snprintf(b, sizeof(b), "%x", 1);
 	if (strcmp(b, "1")!=0) return 0;
 
 	snprintf(b, sizeof(b), "hello %x %x", 2096, 1037);
-	if (strcmp(b, "hello 830 40D")!=0) return 0;
+	if (strcmp(b, "hello 830 40d")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%X %x", 1037, -1);
+	if (strcmp(b, "40D ffffffff")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%#x %#X %#x %#o %#o", 255, 255, 0, 8, 0);
+	if (strcmp(b, "0xff 0XFF 0 010 0")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%#010x|%-#6x|%o", 255, 1, 8);
+	if (strcmp(b, "0x000000ff|0x1   |10")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%p %p", (void*)0x1A2b, (void*)0);
+	if (strcmp(b, "0x1a2b 0x0")!=0) return 0;
 
 	snprintf(b, sizeof(b), "%02x", 1);
 	if (strcmp(b, "01")!=0) return 0;
@@ -556,9 +786,36 @@ int printf_unit_test() {
 	snprintf(b, sizeof(b), "%03d", 1);
 	if (strcmp(b, "001")!=0) return 0;
 
-	//snprintf(b, sizeof(b), "%6.2d", -5);   // NOT IMPLEMENTED YET
-	//twr_conlog("'%s'",b);
-	//if (strcmp(b, "   -05")!=0) return 0;
+	snprintf(b, sizeof(b), "%6.2d", -5);
+	if (strcmp(b, "   -05")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%05d|%-5d|%+d|%+d|%.0d|%i", -42, -42, 7, -7, 0, 9);
+	if (strcmp(b, "-0042|-42  |+7|-7||9")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%30d|", 1);
+	if (strcmp(b, "                             1|")!=0) return 0;
+
+// u and lengths h hh l ll j z t
+
+	snprintf(b, sizeof(b), "%u %u", 4000000000U, -1);
+	if (strcmp(b, "4000000000 4294967295")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%lld %llu", INT64_MIN, UINT64_MAX);
+	if (strcmp(b, "-9223372036854775808 18446744073709551615")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%llx %llX %llo", 0x123456789ABCDEFULL, 0xFEDCBA987654321ULL, 01234567012345670123ULL);
+	if (strcmp(b, "123456789abcdef FEDCBA987654321 1234567012345670123")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%hhd %hhu %hd %hu %hx", 300, -1, 70000, -1, -1);
+	if (strcmp(b, "44 255 4464 65535 ffff")!=0) return 0;
+
+	snprintf(b, sizeof(b), "%ld %lu %jd %ju %zu %zd %td", -5L, 5UL, (intmax_t)-6000000000LL, (uintmax_t)6000000000ULL, sizeof(b), (ptrdiff_t)-3, (ptrdiff_t)-4);
+	if (strcmp(b, "-5 5 -6000000000 6000000000 100 -3 -4")!=0) return 0;
+
+// s
+
+	snprintf(b, sizeof(b), "%5s|%-5s|%.2s|%-3c|%s", "ab", "ab", "xyz", 'q', "end");
+	if (strcmp(b, "   ab|ab   |xy|q  |end")!=0) return 0;
 	
 
 // c
@@ -590,6 +847,20 @@ int printf_unit_test() {
 	if (strlen(b)!=0) return 0;
 	if (strcmp(b, "")!=0) return 0;
 
+// vasprintf (grows past its initial buffer)
+	k=vasprintf_test_helper(&s, "%s %d %s %s", "0123456789012345678901234567890123456789", 42, "0123456789012345678901234567890123456789", "end");
+	if (k!=88 || s==NULL || strlen(s)!=88 || strcmp(s+83, "9 end")!=0 || strncmp(s+40, " 42 ", 4)!=0) return 0;
+	free(s);
+
+	k=vasprintf_test_helper(&s, "");
+	if (k!=0 || s==NULL || s[0]!=0) return 0;
+	free(s);
+
+// invalid specifier, and % at the end of the format
+	const char* badfmt="a%qb%";  // not a literal, to avoid compiler format warnings
+	snprintf(b, sizeof(b), badfmt, 0);
+	if (strcmp(b, "aqb")!=0) return 0;
+
 // * width
 	sprintf(b, "%*d", (int)3, 99);
 	if (strcmp(b, " 99")!=0) return 0;
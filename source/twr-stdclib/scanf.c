@@ -0,0 +1,346 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <locale.h>
+#include "twr-crt.h"
+
+// sscanf family.  Integers are parsed here (with the field width as a limit), and floating point uses the same
+// parser as strtod (twr_from_chars_d_l).  Neither allocates memory or calls JavaScript.
+//
+// %[*][width][length]specifier
+// specifiers: d i u o x X p n c s [set] f F e E g G a A    lengths: hh h l ll j z t L
+
+static inline bool is_space(char c) {
+	return c==' ' || (c>='\t' && c<='\r');
+}
+
+static inline const char* skip_space(const char* p) {
+	while (is_space(*p)) p++;
+	return p;
+}
+
+// end of a field of at most width chars starting at p, not past the terminating zero
+static const char* field_end(const char* p, int width) {
+	while (width-- > 0 && *p) p++;
+	return p;
+}
+
+static inline int digit_value(char c) {
+	if ((unsigned)(c-'0')<10) return c-'0';
+	if ((unsigned)((c|0x20)-'a')<26) return (c|0x20)-'a'+10;
+	return 36;
+}
+
+// [sign] [0x or 0 prefix, depending on base] digits.  base 0 detects the base like %i (and strtol).
+// returns the end of the conversion, or NULL if there were no digits
+static const char* scan_int(const char* p, const char* last, int base, uint64_t* value) {
+	bool neg=false;
+	uint64_t v=0;
+
+	if (p!=last && (*p=='-' || *p=='+')) {
+		neg = *p=='-';
+		p++;
+	}
+
+	// a 0x prefix is consumed even if no hex digits follow it, and the value is then 0 (like glibc)
+	if ((base==0 || base==16) && p!=last && *p=='0' && p+1!=last && (p[1]|0x20)=='x') {
+		p+=2;
+		base=16;
+		if (p==last || digit_value(*p)>=16) {
+			*value=0;
+			return p;
+		}
+	}
+	else if (base==0) {
+		base = (p!=last && *p=='0') ? 8 : 10;
+	}
+
+	const char* const start=p;
+	bool overflow=false;
+	int d;
+	if (base==10) {   // 19 decimal digits always fit, so only longer numbers are checked
+		while (p!=last && p-start<19 && (unsigned)(*p-'0')<10) {
+			v=v*10+(*p-'0');
+			p++;
+		}
+	}
+	while (p!=last && (d=digit_value(*p))<base) {
+		if (__builtin_mul_overflow(v, (uint64_t)base, &v) || __builtin_add_overflow(v, (uint64_t)d, &v))
+			overflow=true;
+		p++;
+	}
+
+	if (p==start) return NULL;
+	if (overflow) v=UINT64_MAX;   // like strtoull
+
+	*value=neg ? 0-v : v;
+	return p;
+}
+
+enum slength {SLEN_NONE, SLEN_HH, SLEN_H, SLEN_L, SLEN_LL, SLEN_J, SLEN_Z, SLEN_T, SLEN_LD};
+
+static void store_int(va_list* vlist, enum slength length, uint64_t v) {
+	switch (length) {
+		case SLEN_HH: *va_arg(*vlist, char*)=(char)v; break;
+		case SLEN_H:  *va_arg(*vlist, short*)=(short)v; break;
+		case SLEN_L:  *va_arg(*vlist, long*)=(long)v; break;
+		case SLEN_LL:
+		case SLEN_LD: *va_arg(*vlist, long long*)=(long long)v; break;
+		case SLEN_J:  *va_arg(*vlist, intmax_t*)=(intmax_t)v; break;
+		case SLEN_Z:  *va_arg(*vlist, size_t*)=(size_t)v; break;
+		case SLEN_T:  *va_arg(*vlist, ptrdiff_t*)=(ptrdiff_t)v; break;
+		default:      *va_arg(*vlist, int*)=(int)v; break;
+	}
+}
+
+// the scanset of a %[ conversion, as a 256 bit map.  returns the format after the closing ]
+static const char* read_scanset(const char* format, uint32_t set[8]) {
+	bool invert=false;
+
+	memset(set, 0, 8*sizeof(uint32_t));
+	if (*format=='^') {
+		invert=true;
+		format++;
+	}
+
+	// a ] right after [ or [^ is part of the set
+	const char* const start=format;
+	while (*format && (*format!=']' || format==start)) {
+		unsigned char lo=*format++;
+		unsigned char hi=lo;
+		if (*format=='-' && format[1] && format[1]!=']') {
+			hi=format[1];
+			format+=2;
+		}
+		for (unsigned c=lo; c<=hi; c++)
+			set[c>>5]|=1U<<(c&31);
+	}
+	if (*format==']') format++;
+
+	if (invert)
+		for (int i=0; i<8; i++) set[i]=~set[i];
+	set[0]&=~1U;   // never matches the terminating zero
+
+	return format;
+}
+
+// reads input from buffer according to format.  returns the number of items assigned, or EOF if the input ended before
+// the first conversion.
+int vsscanf(const char *buffer, const char *format, va_list arglist) {
+	const char* p=buffer;
+	va_list vlist;   // a local copy, so that its address can be passed to store_int
+	va_copy(vlist, arglist);
+	int assigned=0;
+	int conversions=0;   // attempted, for the EOF rule
+
+	while (*format) {
+		if (is_space(*format)) {   // white space in the format matches any amount of white space, including none
+			format=skip_space(format);
+			p=skip_space(p);
+			continue;
+		}
+
+		if (*format!='%' || format[1]=='%') {   // ordinary character (or %%) must match
+			if (*format=='%') {
+				format++;
+				p=skip_space(p);
+			}
+			if (*p==0) goto input_failure;
+			if (*p!=*format) break;
+			p++;
+			format++;
+			continue;
+		}
+
+		format++;   // %
+
+		bool suppress=false;
+		if (*format=='*') {
+			suppress=true;
+			format++;
+		}
+
+		int width=0;
+		while ((unsigned)(*format-'0')<10) width=width*10+(*format++-'0');
+
+		enum slength length=SLEN_NONE;
+		switch (*format) {
+			case 'h':
+				format++;
+				if (*format=='h') { length=SLEN_HH; format++; }
+				else length=SLEN_H;
+				break;
+			case 'l':
+				format++;
+				if (*format=='l') { length=SLEN_LL; format++; }
+				else length=SLEN_L;
+				break;
+			case 'j': length=SLEN_J; format++; break;
+			case 'z': length=SLEN_Z; format++; break;
+			case 't': length=SLEN_T; format++; break;
+			case 'L': length=SLEN_LD; format++; break;
+		}
+
+		const char spec=*format++;
+
+		if (spec=='n') {   // not counted as a conversion
+			if (!suppress) store_int(&vlist, length, (uint64_t)(p-buffer));
+			continue;
+		}
+
+		if (spec!='c' && spec!='[') p=skip_space(p);
+		if (*p==0) goto input_failure;
+		conversions++;
+
+		const char* const last=width ? field_end(p, width) : NULL;   // NULL is unlimited (to the terminating zero)
+
+		switch (spec) {
+			case 'd': case 'i': case 'u': case 'o': case 'x': case 'X': case 'p':
+			{
+				const int base = spec=='d' || spec=='u' ? 10 : spec=='i' ? 0 : spec=='o' ? 8 : 16;
+				uint64_t v;
+				const char* end=scan_int(p, last, base, &v);
+				if (end==NULL) goto matching_failure;
+				p=end;
+				if (!suppress) {
+					if (spec=='p') *va_arg(vlist, void**)=(void*)(uintptr_t)v;
+					else store_int(&vlist, length, v);
+					assigned++;
+				}
+			}
+				break;
+
+			case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+			{
+				double v;
+				const struct twr_from_chars_result r=twr_from_chars_d_l(p, last, &v, twr_get_current_locale());
+				if (r.ec==EINVAL) goto matching_failure;
+				p=r.ptr;
+				if (!suppress) {
+					if (length==SLEN_L) *va_arg(vlist, double*)=v;
+					else if (length==SLEN_LD) *va_arg(vlist, long double*)=v;
+					else *va_arg(vlist, float*)=(float)v;
+					assigned++;
+				}
+			}
+				break;
+
+			case 'c':
+			{
+				const int n=width?width:1;
+				const char* const end=field_end(p, n);
+				if (end-p < n) goto input_failure;
+				if (!suppress) {
+					memcpy(va_arg(vlist, char*), p, n);
+					assigned++;
+				}
+				p=end;
+			}
+				break;
+
+			case 's':
+			{
+				const char* const start=p;
+				while (*p && !is_space(*p) && p!=last) p++;
+				if (!suppress) {
+					char* out=va_arg(vlist, char*);
+					memcpy(out, start, p-start);
+					out[p-start]=0;
+					assigned++;
+				}
+			}
+				break;
+
+			case '[':
+			{
+				uint32_t set[8];
+				format=read_scanset(format, set);
+				const char* const start=p;
+				while (p!=last && (set[(unsigned char)*p>>5]&(1U<<((unsigned char)*p&31))))
+					p++;
+				if (p==start) goto matching_failure;
+				if (!suppress) {
+					char* out=va_arg(vlist, char*);
+					memcpy(out, start, p-start);
+					out[p-start]=0;
+					assigned++;
+				}
+			}
+				break;
+
+			default:  // invalid conversion
+				goto matching_failure;
+		}
+	}
+
+matching_failure:
+	va_end(vlist);
+	return assigned;
+
+input_failure:
+	va_end(vlist);
+	return conversions==0 && assigned==0 ? EOF : assigned;
+}
+
+int sscanf(const char *buffer, const char *format, ... ) {
+	va_list vlist;
+	va_start(vlist, format);
+
+	const int rv=vsscanf(buffer, format, vlist);
+
+	va_end(vlist);
+
+	return rv;
+}
+
+/****************************************************************/
+
+int sscanf_unit_test() {
+	int i, j, n;
+	unsigned u;
+	long long ll;
+	unsigned long long ull;
+	short sh;
+	char c, s[32], t[32], cc[4];
+	float f;
+	double d;
+	void* ptr;
+
+	if (sscanf("  42 -17", "%d%d", &i, &j)!=2 || i!=42 || j!=-17) return 0;
+	if (sscanf("123456", "%3d%2d%n", &i, &j, &n)!=2 || i!=123 || j!=45 || n!=5) return 0;
+	if (sscanf("ff 0x1F 077 0x10 -010", "%x %x %o %i %hi", &u, &i, &j, &n, &sh)!=5 || u!=255 || i!=31 || j!=63 || n!=16 || sh!=-8) return 0;
+	if (sscanf("-9223372036854775808 18446744073709551615", "%lld %llu", &ll, &ull)!=2 || ll!=INT64_MIN || ull!=UINT64_MAX) return 0;
+	if (sscanf("70000", "%hd", &sh)!=1 || sh!=4464) return 0;
+	if (sscanf("4000000000", "%u", &u)!=1 || u!=4000000000U) return 0;
+
+	if (sscanf("3.25 -1e-3 .5", "%f %lf %lf", &f, &d, &d)!=3 || f!=3.25f || d!=0.5) return 0;
+	if (sscanf("1.5e10x", "%lf%c", &d, &c)!=2 || d!=1.5e10 || c!='x') return 0;
+	if (sscanf("12345.75", "%4lf%lf", &d, &d)!=2 || d!=5.75) return 0;
+	if (sscanf("inf nan", "%lf %f", &d, &f)!=2 || !__builtin_isinf(d) || !__builtin_isnan(f)) return 0;
+
+	if (sscanf("  hello world", "%s %s", s, t)!=2 || strcmp(s, "hello")!=0 || strcmp(t, "world")!=0) return 0;
+	if (sscanf("abcdef", "%3s%s", s, t)!=2 || strcmp(s, "abc")!=0 || strcmp(t, "def")!=0) return 0;
+	if (sscanf(" xyz", "%c%3c", &c, cc)!=2 || c!=' ' || memcmp(cc, "xyz", 3)!=0) return 0;
+
+	if (sscanf("key=value;rest", "%[^=]=%[a-z]%n", s, t, &n)!=2 || strcmp(s, "key")!=0 || strcmp(t, "value")!=0 || n!=9) return 0;
+	if (sscanf("]]x", "%[]]", s)!=1 || strcmp(s, "]]")!=0) return 0;
+	if (sscanf("abc123", "%*[a-z]%d", &i)!=1 || i!=123) return 0;
+
+	if (sscanf("100% 5", "%d%% %d", &i, &j)!=2 || i!=100 || j!=5) return 0;
+	if (sscanf("0x1a2b", "%p", &ptr)!=1 || ptr!=(void*)0x1a2b) return 0;
+
+	// failures
+	i=99;
+	if (sscanf("abc", "%d", &i)!=0 || i!=99) return 0;
+	if (sscanf("", "%d", &i)!=EOF) return 0;
+	if (sscanf("   ", "%s", s)!=EOF) return 0;
+	if (sscanf("5 x", "%d %d", &i, &j)!=1 || i!=5) return 0;
+	if (sscanf("5", "%d %d", &i, &j)!=1) return 0;
+	if (sscanf("a:5", "b:%d", &i)!=0) return 0;
+
+	return 1;
+}
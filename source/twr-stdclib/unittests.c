@@ -46,11 +46,7 @@ int atof_unit_test() {
 	if (atof("0.0")!= 0.0) return 0;
 	if (atof("0")!= 0) return 0;
 
-#ifdef __wasm__
-	if (!isnan(atof("junk"))) return 0;
-#else
 	if (atof("junk")!= 0) return 0;
-#endif
 
 	if (atof("-0x1afp-2")!= 0) return 0;
 	if (atof("  -0.0000000123junk")!=-0.0000000123) return 0;
@@ -297,11 +293,7 @@ int fcvt_unit_test() {
 	if (!fcvt_expect(buffer, dec, sign, error, "100000000000",  -18, 0)) return 0;
 	
 	error=_fcvt_s(buffer, sizeof(buffer), (double)6.54321e+200, 10, &dec, &sign);  
-#ifdef __wasm__
-	if (error==0) return 0;
-#else
 	if (!fcvt_expect(buffer, dec, sign, error, "6543209999999999561461578727841808536676238014554206487411164761511588201120188491102838911919793884914712609471921587675606823921054952492339799962922243734546177255394661967753070612297755130981253120000000000",  201, 0)) return 0;
-#endif
 
 	error=_fcvt_s(buffer, sizeof(buffer)/3, (double)6.54321e+200, 10, &dec, &sign);
 	if (0==error ) return 0;
@@ -323,24 +315,16 @@ int fcvt_unit_test() {
 
 	error=_fcvt_s(buffer, sizeof(buffer), (double)6.54321e-200, 10, &dec, &sign); 
 #ifdef __wasm__
-	if (error==0) return 0;
+	if (!fcvt_expect(buffer, dec, sign, error, "",  -10, 0)) return 0;
 #else
 	if (!fcvt_expect(buffer, dec, sign, error, "",  -199, 0)) return 0;
 #endif
 
 	error=_fcvt_s(buffer, sizeof(buffer), (double)6.54321e-200, 210, &dec, &sign); 
-#ifdef __wasm__
-	if (error==0) return 0;
-#else
 	if (!fcvt_expect(buffer, dec, sign, error, "65432100000",  -199, 0)) return 0;
-#endif
 
 	error=_fcvt_s(buffer, sizeof(buffer), (double)3.6e-310, 350, &dec, &sign); // un-normalized
-#ifdef __wasm__
-	if (error==0) return 0;
-#else
 	if (!fcvt_expect(buffer, dec, sign, error, "36000000000000087643837346930308760325595",  -309, 0)) return 0;
-#endif
 
 	error=_fcvt_s(buffer, sizeof(buffer), 0, 1, &dec, &sign);   // test zero (which is denormalized)
 	if (!fcvt_expect(buffer, dec, sign, error, "0",  0, 0)) return 0;
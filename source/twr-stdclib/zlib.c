@@ -0,0 +1,315 @@
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "twr-crt.h"
+#include "twr-zlib.h"
+
+// checksums, and twr_zfopen: a FILE that decompresses or compresses another FILE (inflate.c and deflate.c)
+
+// crc32, 4 bytes at a time ("slicing by 4")
+static uint32_t crc_table[4][256];
+
+uint32_t twr_crc32(uint32_t crc, const void* data, size_t len) {
+	const uint8_t* p=data;
+
+	if (crc_table[0][1]==0) {
+		for (int n=0; n<256; n++) {
+			uint32_t c=n;
+			for (int k=0; k<8; k++)
+				c=c&1 ? 0xedb88320u^(c>>1) : c>>1;
+			crc_table[0][n]=c;
+		}
+		for (int n=0; n<256; n++) {
+			uint32_t c=crc_table[0][n];
+			for (int k=1; k<4; k++) {
+				c=crc_table[0][c&0xff]^(c>>8);
+				crc_table[k][n]=c;
+			}
+		}
+	}
+
+	crc=~crc;
+	for (; len>=4; len-=4, p+=4) {
+		crc^=(uint32_t)p[0] | (uint32_t)p[1]<<8 | (uint32_t)p[2]<<16 | (uint32_t)p[3]<<24;
+		crc=crc_table[3][crc&0xff] ^ crc_table[2][(crc>>8)&0xff] ^ crc_table[1][(crc>>16)&0xff] ^ crc_table[0][crc>>24];
+	}
+	while (len--)
+		crc=crc_table[0][(crc^*p++)&0xff]^(crc>>8);
+
+	return ~crc;
+}
+
+#define ADLER_BASE 65521
+#define ADLER_NMAX 5552		// the most bytes before the sums can overflow 32 bits
+
+uint32_t twr_adler32(uint32_t adler, const void* data, size_t len) {
+	const uint8_t* p=data;
+	uint32_t a=adler&0xffff, b=adler>>16;
+
+	while (len>0) {
+		size_t n=len<ADLER_NMAX ? len : ADLER_NMAX;
+		len-=n;
+		for (; n>=4; n-=4, p+=4) {
+			a+=p[0]; b+=a;
+			a+=p[1]; b+=a;
+			a+=p[2]; b+=a;
+			a+=p[3]; b+=a;
+		}
+		while (n--) {
+			a+=*p++;
+			b+=a;
+		}
+		a%=ADLER_BASE;
+		b%=ADLER_BASE;
+	}
+
+	return b<<16 | a;
+}
+
+//*************************************************
+// twr_zfopen
+
+#define ZBUF_SIZE 4096
+
+struct zfile {
+	FILE* stream;
+	struct twr_inflate* inf;	// one of these
+	struct twr_deflate* def;
+	bool end;			// inflate: the end of the compressed data
+	size_t pos, len;		// inflate: the input in buf that hasn't been used
+	uint8_t buf[ZBUF_SIZE];
+};
+
+static void* zfs_open(const char* path, int flags) {
+	(void)path; (void)flags;
+	errno=EINVAL;		// twr_zfopen only
+	return NULL;
+}
+
+static long zfs_read(void* handle, long offset, char* buf, long len) {
+	struct zfile* zf=handle;
+	long done=0;
+	(void)offset;		// reads are sequential
+
+	while (done<len && !zf->end) {
+		size_t used, made;
+		const int rv=twr_inflate(zf->inf, zf->buf+zf->pos, zf->len-zf->pos, &used, buf+done, len-done, &made);
+		zf->pos+=used;
+		done+=made;
+
+		if (rv==TWR_Z_DATA_ERROR) {
+			errno=EIO;
+			return -1;
+		}
+		if (rv==TWR_Z_END) {
+			zf->end=true;
+			break;
+		}
+
+		if (used==0 && made==0) {	// more input is needed
+			memmove(zf->buf, zf->buf+zf->pos, zf->len-zf->pos);
+			zf->len-=zf->pos;
+			zf->pos=0;
+			const size_t n=fread(zf->buf+zf->len, 1, ZBUF_SIZE-zf->len, zf->stream);
+			if (n==0) {		// truncated
+				errno=EIO;
+				return -1;
+			}
+			zf->len+=n;
+		}
+	}
+
+	return done;
+}
+
+// deflate in, and write the output to the stream
+static int zfs_deflate(struct zfile* zf, const char* in, long len, int finish) {
+	for (;;) {
+		size_t used, made;
+		const int rv=twr_deflate(zf->def, in, len, &used, zf->buf, ZBUF_SIZE, &made, finish);
+		in+=used;
+		len-=used;
+		if (made && fwrite(zf->buf, 1, made, zf->stream)!=made) return -1;
+		if (rv==TWR_Z_END || (len==0 && made<ZBUF_SIZE && !finish)) return 0;
+	}
+}
+
+static long zfs_write(void* handle, long offset, const char* buf, long len) {
+	struct zfile* zf=handle;
+	(void)offset;
+
+	if (zf->def==NULL) {
+		errno=EBADF;
+		return -1;
+	}
+	if (zfs_deflate(zf, buf, len, 0)) {
+		errno=EIO;
+		return -1;
+	}
+	return len;
+}
+
+static int zfs_close(void* handle) {
+	struct zfile* zf=handle;
+	int rv=0;
+
+	if (zf->def && zfs_deflate(zf, NULL, 0, 1)) rv=-1;
+	if (fclose(zf->stream)) rv=-1;
+	twr_inflate_free(zf->inf);
+	twr_deflate_free(zf->def);
+	free(zf);
+
+	return rv;
+}
+
+static long zfs_size(void* handle) {
+	(void)handle;
+	return -1;
+}
+
+static const struct twr_fs_backend zfs={zfs_open, zfs_close, zfs_read, zfs_write, zfs_size, NULL, NULL};
+
+FILE* twr_zfopen(FILE* stream, const char* mode, int format) {
+	bool write;
+	int level=-1;
+
+	if (mode[0]=='r') write=false;
+	else if (mode[0]=='w') write=true;
+	else mode=NULL;
+
+	if (mode) {
+		for (const char* m=mode+1; *m; m++) {
+			if (*m=='b') continue;
+			if (write && *m>='0' && *m<='9') level=*m-'0';
+			else mode=NULL;
+			if (mode==NULL) break;
+		}
+	}
+	if (mode==NULL || (write && format==TWR_Z_AUTO)) {
+		errno=EINVAL;
+		return NULL;
+	}
+
+	struct zfile* zf=calloc(1, sizeof(struct zfile));
+	if (zf==NULL) return NULL;
+	zf->stream=stream;
+	if (write) zf->def=twr_deflate_new(format, level);
+	else zf->inf=twr_inflate_new(format);
+
+	if (zf->def==NULL && zf->inf==NULL) {
+		free(zf);
+		return NULL;
+	}
+
+	FILE* f=twr_fopen_handle(&zfs, zf, write ? "w" : "r");
+	if (f==NULL) {
+		twr_inflate_free(zf->inf);
+		twr_deflate_free(zf->def);
+		free(zf);
+	}
+	return f;
+}
+
+//*************************************************
+
+static bool round_trip(const char* data, size_t len, int format, int level, char* comp, size_t comp_len, char* out) {
+	long n=twr_deflate_buf(data, len, comp, comp_len, format, level);
+	if (n<0 || (size_t)n>twr_deflate_bound(len)) return false;
+	if (twr_inflate_buf(comp, n, out, len, format)!=(long)len || memcmp(data, out, len)!=0) return false;
+	if (len>0 && (twr_inflate_buf(comp, n, out, len-1, format)!=-1 || errno!=ENOSPC)) return false;
+
+	// the same, a few bytes at a time
+	struct twr_deflate* d=twr_deflate_new(format, level);
+	size_t in=0, made=0, used, m;
+	int rv;
+	do {
+		const size_t step=len-in<100 ? len-in : 100;
+		rv=twr_deflate(d, data+in, step, &used, comp+made, comp_len-made<7 ? comp_len-made : 7, &m, in+step==len);
+		in+=used;
+		made+=m;
+	} while (rv==TWR_Z_OK);
+	twr_deflate_free(d);
+	if (rv!=TWR_Z_END || made>twr_deflate_bound(len)) return false;
+	n=made;		// level 0 blocks can split differently
+
+	struct twr_inflate* z=twr_inflate_new(format==TWR_Z_RAW ? TWR_Z_RAW : TWR_Z_AUTO);
+	in=0;
+	made=0;
+	do {
+		rv=twr_inflate(z, comp+in, n-in, &used, out+made, len-made<33 ? len-made : 33, &m);
+		in+=used;
+		made+=m;
+	} while (rv==TWR_Z_OK && (used || m));
+	twr_inflate_free(z);
+	return rv==TWR_Z_END && in==(size_t)n && made==len && memcmp(data, out, len)==0;
+}
+
+int zlib_unit_test(void) {
+	static const uint8_t zlib_data[]={
+		0x78,0xda,0x2b,0x29,0x2f,0xd2,0x2d,0x4f,0x2c,0xce,0x55,0x28,0xc1,0x60,0x64,0xe6,0xa5,0xe5,0x24,0x96,
+		0xa4,0x72,0x95,0x50,0x45,0x09,0x00,0x31,0xea,0x27,0x3a};
+	static const uint8_t gzip_data[]={
+		0x1f,0x8b,0x08,0x08,0x00,0x00,0x00,0x00,0x02,0xff,0x74,0x2e,0x74,0x78,0x74,0x00,0x2b,0x29,0x2f,0xd2,
+		0x2d,0x4f,0x2c,0xce,0x55,0x28,0xc1,0x60,0x64,0xe6,0xa5,0xe5,0x24,0x96,0xa4,0x72,0x95,0x50,0x45,0x09,
+		0x00,0x24,0x9e,0x33,0x40,0x69,0x00,0x00,0x00};
+	const char* const text="twr-wasm twr-wasm twr-wasm inflate\n";
+	char out[128];
+	uint8_t bad[sizeof(zlib_data)];
+
+	if (twr_crc32(0, "123456789", 9)!=0xcbf43926 || twr_adler32(1, "Wikipedia", 9)!=0x11e60398) return 0;
+
+	// made by zlib
+	if (twr_inflate_buf(zlib_data, sizeof(zlib_data), out, sizeof(out), TWR_Z_ZLIB)!=105) return 0;
+	for (int i=0; i<105; i+=35)
+		if (memcmp(out+i, text, 35)!=0) return 0;
+	if (twr_inflate_buf(gzip_data, sizeof(gzip_data), out, sizeof(out), TWR_Z_AUTO)!=105 || memcmp(out+70, text, 35)!=0) return 0;
+	if (twr_inflate_buf(zlib_data+2, sizeof(zlib_data)-6, out, sizeof(out), TWR_Z_RAW)!=105) return 0;
+	memcpy(bad, zlib_data, sizeof(zlib_data));
+	bad[sizeof(bad)-1]^=1;		// checksum
+	if (twr_inflate_buf(bad, sizeof(bad), out, sizeof(out), TWR_Z_ZLIB)!=-1 || errno!=EINVAL) return 0;
+	if (twr_inflate_buf(zlib_data, sizeof(zlib_data), out, sizeof(out), TWR_Z_GZIP)!=-1 || errno!=EINVAL) return 0;
+	if (twr_inflate_buf(zlib_data, sizeof(zlib_data)-1, out, sizeof(out), TWR_Z_ZLIB)!=-1) return 0;
+
+	// text, runs, and noise
+	const size_t len=40000;
+	char* data=malloc(len);
+	char* comp=malloc(twr_deflate_bound(len));
+	char* back=malloc(len);
+	if (data==NULL || comp==NULL || back==NULL) return 0;
+	uint32_t r=1;
+	for (size_t i=0; i<len; ) {
+		r=r*1103515245+12345;
+		const size_t n=(r>>16)%300;
+		for (size_t k=0; k<n && i<len; k++, i++) {
+			if (r&0x1000) data[i]=text[(i/7)%35];
+			else if (r&0x2000) data[i]='z';
+			else data[i]=(r=r*1103515245+12345)>>24;
+		}
+	}
+
+	if (!round_trip(data, 0, TWR_Z_ZLIB, 6, comp, twr_deflate_bound(0), back)) return 0;
+	if (!round_trip(text, 35, TWR_Z_GZIP, 6, comp, twr_deflate_bound(35), back)) return 0;
+	for (int format=TWR_Z_RAW; format<=TWR_Z_GZIP; format++)
+		for (int level=0; level<=9; level+=3)
+			if (!round_trip(data, len, format, level, comp, twr_deflate_bound(len), back)) return 0;
+
+	// a compressed file
+	FILE* f=twr_zfopen(fopen("/unittest/z.gz", "w"), "w9", TWR_Z_GZIP);
+	if (f==NULL || fwrite(data, 1, len, f)!=len || fputs("end", f)==EOF || fclose(f)!=0) return 0;
+	f=fopen("/unittest/z.gz", "r");
+	if (f==NULL || fseek(f, 0, SEEK_END)!=0 || ftell(f)>(long)len/2) return 0;
+	rewind(f);
+	f=twr_zfopen(f, "r", TWR_Z_AUTO);
+	if (f==NULL || fread(back, 1, len, f)!=len || memcmp(data, back, len)!=0) return 0;
+	if (fread(out, 1, sizeof(out), f)!=3 || memcmp(out, "end", 3)!=0 || !feof(f)) return 0;
+	if (fclose(f)!=0 || remove("/unittest/z.gz")!=0) return 0;
+
+	free(data);
+	free(comp);
+	free(back);
+
+	return 1;
+}
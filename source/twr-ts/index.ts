@@ -1,8 +1,8 @@
 import {twrWasmModule} from "./twrmod.js";
-import {IModOpts, IModProxyParams, TStdioVals} from "./twrmodbase.js"
+import {IModOpts, IModProxyParams, TStdioVals, IFetchStreamOpts, IAddFileOpts} from "./twrmodbase.js"
 import {twrWasmModuleAsync} from "./twrmodasync.js";
 
-export {IModOpts, TStdioVals, IModProxyParams};
+export {IModOpts, TStdioVals, IModProxyParams, IFetchStreamOpts, IAddFileOpts};
 export {twrWasmModule};
 export {twrWasmModuleAsync};
 
@@ -1,6 +1,8 @@
 import {twrWasmModuleBase, IModParams} from "./twrmodbase.js"
-import {twrSharedCircularBuffer} from "./twrcircular.js";
+import {twrSharedCircularBuffer, keyCodeMask, keyUp} from "./twrcircular.js";
 import {twrSignal} from "./twrsignal.js";
+import {twrGlyphAtlas, fillBlocks} from "./twrglyphatlas.js";
+import {twrLineEditor, twrLineBeginReply} from "./twrlineedit.js";
 
 
 // Canvas have a size that will be set based on the character width x height
@@ -46,40 +48,60 @@ enum D2DType {
     D2D_RELEASEID=31,
     D2D_CREATELINEARGRADIENT=32,
     D2D_SETFILLSTYLE=33,
-    D2D_SETSTROKESTYLE=34
+    D2D_SETSTROKESTYLE=34,
+    D2D_COPYRECT=35,
+    D2D_FILLCODEPOINTS=36,
+    D2D_FILLBLOCKS=37
 }
 
-export type TCanvasProxyParams = [ICanvasProps, SharedArrayBuffer, SharedArrayBuffer];
+// the canvas handle for twr_d2dcanvas, or twr_iocanvas if there is no twr_d2dcanvas.  Keep in sync with twr-draw2d.h
+export const D2D_DEFAULT_CANVAS=-2;
+
+export type TCanvasProxyParams = [ICanvasProps, SharedArrayBuffer, SharedArrayBuffer, string, SharedArrayBuffer];
 
 export interface ICanvas {
     props: ICanvasProps,
     charIn?: ()=>number,
     inkey?: ()=>number,
+    keysIn?: (buf:number, n:number)=>number,
+    lineBegin?: (cursor:number, foreColor:number, backColor:number)=>number,
     getProxyParams?: ()=>TCanvasProxyParams,
     drawSeq: (ds:number)=>void,
  }
  
 export class twrCanvas implements ICanvas {
     ctx:CanvasRenderingContext2D|undefined;
+    id:string;      // the element id
     props:ICanvasProps={charWidth: 0, charHeight: 0, foreColor: 0, backColor: 0, widthInChars: 0, heightInChars: 0, canvasHeight:0, canvasWidth:0};
     owner: twrWasmModuleBase;
     cmdCompleteSignal?:twrSignal;
     canvasKeys?: twrSharedCircularBuffer;
+    spacingFont="";    // the font that spacingAdvance is for
+    spacingAdvance=0;
+    atlas?:twrGlyphAtlas;    // if set, characters are drawn from it instead of with fillText
+    lineEditor?:twrLineEditor;  // twrWasmModuleAsync io_mbgets line mode
+    lineReply?:twrLineBeginReply;
+    line={pos:0, fore:"", back:"", top:0, saved:undefined as ImageData|undefined};   // the line being edited
     precomputedObjects: {  [index: number]: 
         (ImageData | 
 			{mem8:Uint8Array, width:number, height:number})  |
          CanvasGradient
     };
 
-    constructor(element:HTMLCanvasElement|null|undefined, modParams:IModParams, modbase:twrWasmModuleBase) {
-        const {forecolor, backcolor, fontsize, isd2dcanvas } = modParams; 
+    // a console canvas (twr_iocanvas) is sized to modParams.windim.  Otherwise the canvas keeps its size, and
+    // widthInChars and heightInChars are how many characters fit
+    constructor(element:HTMLCanvasElement|null|undefined, modParams:IModParams, modbase:twrWasmModuleBase, isConsole=!modParams.isd2dcanvas, glyphatlas=!!modParams.glyphatlas) {
+        const {forecolor, backcolor, fontsize } = modParams; 
         this.owner=modbase;
+        this.id=element?.id ?? "";
         this.props.widthInChars=modParams.windim[0];
         this.props.heightInChars=modParams.windim[1];
 
         if (!this.owner.isWasmModule) {
             this.cmdCompleteSignal=new twrSignal();
-            this.canvasKeys = new twrSharedCircularBuffer();  // tsconfig, lib must be set to 2017 or higher
+            this.canvasKeys = new twrSharedCircularBuffer(undefined, modParams.keybuffer);  // tsconfig, lib must be set to 2017 or higher
+            this.lineEditor = new twrLineEditor((cp)=>this.lineEcho(cp), (keys)=>this.lineSend(keys), this.canvasKeys.size);
+            this.lineReply = new twrLineBeginReply();
         }
 
         this.precomputedObjects={};
@@ -98,10 +120,14 @@ export class twrCanvas implements ICanvas {
             let fM = c.measureText("X"); 
             this.props.charHeight = Math.ceil(fM.fontBoundingBoxAscent + fM.fontBoundingBoxDescent);
 
-            if (!isd2dcanvas) {
+            if (isConsole) {
                 element.width=this.props.charWidth*this.props.widthInChars;
                 element.height=this.props.charHeight*this.props.heightInChars;
             }
+            else {
+                this.props.widthInChars=Math.floor(element.width/this.props.charWidth);
+                this.props.heightInChars=Math.floor(element.height/this.props.charHeight);
+            }
 
             this.props.canvasHeight=element.height;
             this.props.canvasWidth=element.width;
@@ -120,6 +146,9 @@ export class twrCanvas implements ICanvas {
             c2.fillStyle=forecolor;
             this.props.foreColor=Number("0x"+c2.fillStyle.slice(1));
 
+            if (glyphatlas)
+                this.atlas=new twrGlyphAtlas(this.props.charWidth, this.props.charHeight);
+
         }
 
         //console.log("Create New twrCanvas: ",this.isValid(), element, this);
@@ -131,9 +160,65 @@ export class twrCanvas implements ICanvas {
         return !!this.ctx;
     }
 
+    // twrCanvasProxy.lineBegin.  Unless keys were typed ahead, keys go to lineEditor until the line is finished.  The
+    // echo is only a preview: the C console owns the cells, so the canvas is put back as it was, and the C code
+    // echoes the finished line
+    beginLine(cursor:number, foreColor:number, backColor:number) {
+        if (!this.ctx || !this.lineEditor || !this.lineReply || !this.canvasKeys) throw new Error("internal error in beginLine.");
+        if (!this.canvasKeys.isEmpty()) {
+            this.lineReply.reply(false);
+            return;
+        }
+        const {charHeight, widthInChars, heightInChars}=this.props;
+        const top=Math.floor(cursor/widthInChars)*charHeight;
+        this.line={
+            pos: cursor,
+            fore: "#"+("00000000" + (foreColor>>>0).toString(16)).slice(-8),
+            back: "#"+("00000000" + (backColor>>>0).toString(16)).slice(-8),
+            top: top,
+            saved: this.ctx.getImageData(0, top, this.props.canvasWidth, heightInChars*charHeight-top)
+        };
+        this.lineEditor.begin();
+        this.lineReply.reply(true);
+    }
+
+    private lineEcho(cp:number) {
+        if (cp==8) {
+            this.lineCell(32);
+            this.line.pos--;
+            this.lineCell(9611);   // the cursor
+        }
+        else if (cp!=10) {
+            this.lineCell(cp);
+            this.line.pos++;
+            this.lineCell(9611);
+        }
+    }
+
+    // draw a cell of the line being edited.  Past the end of the screen there is no preview (the C code scrolls)
+    private lineCell(cp:number) {
+        const {charWidth, charHeight, widthInChars, heightInChars}=this.props;
+        if (!this.ctx || this.line.pos>=widthInChars*heightInChars) return;
+        const x=(this.line.pos%widthInChars)*charWidth;
+        const y=Math.floor(this.line.pos/widthInChars)*charHeight;
+        this.ctx.fillStyle=this.line.back;
+        this.ctx.fillRect(x, y, charWidth, charHeight);
+        if (cp!=32) {
+            this.ctx.fillStyle=this.line.fore;
+            if (!this.atlas || !this.atlas.fillCodePoint(this.ctx, cp, x, y))
+                this.ctx.fillText(String.fromCodePoint(cp), x, y);
+        }
+    }
+
+    private lineSend(keys:number[]) {
+        if (this.ctx && this.line.saved) this.ctx.putImageData(this.line.saved, 0, this.line.top);
+        this.line.saved=undefined;
+        for (const k of keys) this.canvasKeys!.write(k);
+    }
+
     getProxyParams() : TCanvasProxyParams {
-        if (!this.cmdCompleteSignal || !this.canvasKeys) throw new Error("internal error in getProxyParams.");
-        return [this.props, this.cmdCompleteSignal.sharedArray, this.canvasKeys.sharedArray];
+        if (!this.cmdCompleteSignal || !this.canvasKeys || !this.lineReply) throw new Error("internal error in getProxyParams.");
+        return [this.props, this.cmdCompleteSignal.sharedArray, this.canvasKeys.sharedArray, this.id, this.lineReply.sharedArray];
     }
 
     getProp(pn:number): number {
@@ -145,69 +230,93 @@ export class twrCanvas implements ICanvas {
 
 /* see draw2d.h for structs that match */
 
-    drawSeq(ds:number) {
+    // signal is false for all but the last of a twrCanvasDrawSeqs batch
+    drawSeq(ds:number, signal=true) {
         //console.log("twr::Canvas enter drawSeq");
         if (!this.isValid()) console.log("internal error - drawSeq called on invalid twrCanvas");
         if (!this.ctx) return;
 
-        let ins=this.owner.getLong(ds);  /* ds->start */
-        const lastins=this.owner.getLong(ds+4);  /* ds->last */
-        //console.log("instruction start, last ",ins.toString(16), lastins.toString(16));
-
-        let next:number;
-        //let insCount=0;
+        // the instructions are records, one after another (see draw2d.c), decoded in one pass
+        const dv=new DataView(this.owner.memory!.buffer);
+        const buf=dv.getUint32(ds, true);  /* ds->buf */
+        const end=buf+dv.getUint32(ds+4, true);  /* ds->len */
 
-        while (1) {
-
-            //insCount++;
-
-            const type:D2DType=this.owner.getLong(ins+4);    /* hdr->type */
-            if (0/*type!=D2DType.D2D_FILLRECT*/) {
-                console.log("ins",ins)
-                console.log("hdr.next",this.owner.mem8[ins],this.owner.mem8[ins+1],this.owner.mem8[ins+2],this.owner.mem8[ins+3]);
-                console.log("hdr.type",this.owner.mem8[ins+4],this.owner.mem8[ins+5]);
-                console.log("next 4 bytes", this.owner.mem8[ins+6],this.owner.mem8[ins+7],this.owner.mem8[ins+8],this.owner.mem8[ins+9]);
-                console.log("and 4 more ", this.owner.mem8[ins+10],this.owner.mem8[ins+11],this.owner.mem8[ins+12],this.owner.mem8[ins+13]);
-                //console.log("ins, type, next is ", ins.toString(16), type.toString(16), next.toString(16));
-             }
+        for (let ins=buf; ins<end; ins+=dv.getUint32(ins, true)) {  /* hdr->size */
+            const type:D2DType=dv.getUint32(ins+4, true);    /* hdr->type */
             switch (type) {
                 case D2DType.D2D_FILLRECT:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
-                    const w=this.owner.getDouble(ins+24);
-                    const h=this.owner.getDouble(ins+32);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const w=dv.getFloat64(ins+24, true);
+                    const h=dv.getFloat64(ins+32, true);
                     this.ctx.fillRect(x, y, w, h);
                 }
                     break;
 
                 case D2DType.D2D_STROKERECT:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
-                    const w=this.owner.getDouble(ins+24);
-                    const h=this.owner.getDouble(ins+32);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const w=dv.getFloat64(ins+24, true);
+                    const h=dv.getFloat64(ins+32, true);
                     this.ctx.strokeRect(x, y, w, h);
                 }
                     break;
 
+                case D2DType.D2D_COPYRECT:
+                {
+                    const sx=dv.getFloat64(ins+8, true);
+                    const sy=dv.getFloat64(ins+16, true);
+                    const w=dv.getFloat64(ins+24, true);
+                    const h=dv.getFloat64(ins+32, true);
+                    const dx=dv.getFloat64(ins+40, true);
+                    const dy=dv.getFloat64(ins+48, true);
+                    this.ctx.drawImage(this.ctx.canvas, sx, sy, w, h, dx, dy, w, h);
+                }
+                    break;
+
+                case D2DType.D2D_FILLBLOCKS:
+                {
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const w=dv.getFloat64(ins+24, true);
+                    const h=dv.getFloat64(ins+32, true);
+                    const bits=dv.getUint32(ins+40, true);
+                    if (this.atlas)
+                        this.atlas.fillBlocks(this.ctx, bits, x, y, w, h);
+                    else
+                        fillBlocks(this.ctx, bits, x, y, w, h);
+                }
+                    break;
+
                 case D2DType.D2D_FILLCODEPOINT:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
-                    const c=this.owner.getLong(ins+24);
-                    let txt=String.fromCodePoint(c);
-                    this.ctx.fillText(txt, x, y);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const c=dv.getUint32(ins+24, true);
+                    if (!this.atlas || !this.atlas.fillCodePoint(this.ctx, c, x, y))
+                        this.ctx.fillText(String.fromCodePoint(c), x, y);
+                }
+                    break;
+
+                case D2DType.D2D_FILLCODEPOINTS:
+                {
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const advance=dv.getFloat64(ins+24, true);
+                    const n=dv.getUint32(ins+32, true);
+                    const c=new Uint32Array(dv.buffer, ins+36, n);
+                    this.fillCodePoints(c, x, y, advance);
                 }
                     break;
 
-                
                 case D2DType.D2D_FILLTEXT:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
-						  const codePage=this.owner.getLong(ins+28);
-                    const str=this.owner.getString(this.owner.getLong(ins+24), undefined, codePage);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+						  const codePage=dv.getUint32(ins+28, true);
+                    const str=this.owner.getString(ins+dv.getUint32(ins+24, true), undefined, codePage);  // (copied into the record)
 
                     //console.log("filltext ",x,y,str)
     
@@ -217,9 +326,9 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_MEASURETEXT:
                 {
-						  const codePage=this.owner.getLong(ins+16);
-                    const str=this.owner.getString(this.owner.getLong(ins+8), undefined, codePage);
-                    const tmidx=this.owner.getLong(ins+12);
+						  const codePage=dv.getUint32(ins+16, true);
+                    const str=this.owner.getString(dv.getUint32(ins+8, true), undefined, codePage);
+                    const tmidx=dv.getUint32(ins+12, true);
     
                     const tm=this.ctx.measureText(str);
                     this.owner.setDouble(tmidx+0, tm.actualBoundingBoxAscent);
@@ -234,14 +343,14 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_SETFONT:
                 {
-                    const str=this.owner.getString(this.owner.getLong(ins+8));
+                    const str=this.owner.getString(ins+dv.getUint32(ins+8, true));
                     this.ctx.font=str;
                 }
                     break;
 
                 case D2DType.D2D_SETFILLSTYLERGBA:
                 {
-                    const color=this.owner.getLong(ins+8); 
+                    const color=dv.getUint32(ins+8, true); 
                     const cssColor= "#"+("00000000" + color.toString(16)).slice(-8);
                     this.ctx.fillStyle = cssColor;
                     //console.log("fillstyle: ", this.ctx.fillStyle, ":", cssColor,":", color)
@@ -250,7 +359,7 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_SETSTROKESTYLERGBA:
                 {
-                    const color=this.owner.getLong(ins+8); 
+                    const color=dv.getUint32(ins+8, true); 
                     const cssColor= "#"+("00000000" + color.toString(16)).slice(-8);
                     this.ctx.strokeStyle = cssColor;
                 }
@@ -258,21 +367,21 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_SETFILLSTYLE:
                 {
-                    const cssColor= this.owner.getString(this.owner.getLong(ins+8));
+                    const cssColor= this.owner.getString(ins+dv.getUint32(ins+8, true));
                     this.ctx.fillStyle = cssColor;
                 }
                     break
 
                 case D2DType.D2D_SETSTROKESTYLE:
                 {
-                    const cssColor= this.owner.getString(this.owner.getLong(ins+8));
+                    const cssColor= this.owner.getString(ins+dv.getUint32(ins+8, true));
                     this.ctx.strokeStyle = cssColor;
                 }
                     break
 
                 case D2DType.D2D_SETLINEWIDTH:
                 {
-                    const width=this.owner.getShort(ins+8);  
+                    const width=dv.getFloat64(ins+8, true);
                     this.ctx.lineWidth=width;
                     //console.log("twrCanvas D2D_SETLINEWIDTH: ", this.ctx.lineWidth);
                 }
@@ -280,28 +389,28 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_MOVETO:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
                     this.ctx.moveTo(x, y);
                 }
                     break;
 
                 case D2DType.D2D_LINETO:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
                     this.ctx.lineTo(x, y);
                 }
                     break;
 
                 case D2DType.D2D_BEZIERTO:
                 {
-                    const cp1x=this.owner.getDouble(ins+8);
-                    const cp1y=this.owner.getDouble(ins+16);
-                    const cp2x=this.owner.getDouble(ins+24);
-                    const cp2y=this.owner.getDouble(ins+32);
-                    const x=this.owner.getDouble(ins+40);
-                    const y=this.owner.getDouble(ins+48);
+                    const cp1x=dv.getFloat64(ins+8, true);
+                    const cp1y=dv.getFloat64(ins+16, true);
+                    const cp2x=dv.getFloat64(ins+24, true);
+                    const cp2y=dv.getFloat64(ins+32, true);
+                    const x=dv.getFloat64(ins+40, true);
+                    const y=dv.getFloat64(ins+48, true);
                     this.ctx.bezierCurveTo(cp1x, cp1y, cp2x, cp2y, x, y);
                 }
                     break;
@@ -338,12 +447,12 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_ARC:
                 {
-                    const x=this.owner.getDouble(ins+8);
-                    const y=this.owner.getDouble(ins+16);
-                    const radius=this.owner.getDouble(ins+24);
-                    const startAngle=this.owner.getDouble(ins+32);
-                    const endAngle=this.owner.getDouble(ins+40);
-                    const counterClockwise= (this.owner.getLong(ins+48)!=0);
+                    const x=dv.getFloat64(ins+8, true);
+                    const y=dv.getFloat64(ins+16, true);
+                    const radius=dv.getFloat64(ins+24, true);
+                    const startAngle=dv.getFloat64(ins+32, true);
+                    const endAngle=dv.getFloat64(ins+40, true);
+                    const counterClockwise= (dv.getUint32(ins+48, true)!=0);
 
                     this.ctx.arc(x, y, radius, startAngle, endAngle, counterClockwise)
                 }
@@ -351,11 +460,11 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_IMAGEDATA:
                 {
-                    const start=this.owner.getLong(ins+8);
-                    const length=this.owner.getLong(ins+12);
-                    const width=this.owner.getLong(ins+16);
-                    const height=this.owner.getLong(ins+20);
-                    const id=this.owner.getLong(ins+24);
+                    const start=dv.getUint32(ins+8, true);
+                    const length=dv.getUint32(ins+12, true);
+                    const width=dv.getUint32(ins+16, true);
+                    const height=dv.getUint32(ins+20, true);
+                    const id=dv.getUint32(ins+24, true);
 
                     if ( id in this.precomputedObjects ) console.log("warning: D2D_IMAGEDATA ID already exists.");
 
@@ -372,13 +481,13 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_CREATERADIALGRADIENT:
                 {
-                    const x0=this.owner.getDouble(ins+8);
-                    const y0=this.owner.getDouble(ins+16);
-                    const radius0=this.owner.getDouble(ins+24);
-                    const x1=this.owner.getDouble(ins+32);
-                    const y1=this.owner.getDouble(ins+40);
-                    const radius1=this.owner.getDouble(ins+48);
-                    const id= this.owner.getLong(ins+56);
+                    const x0=dv.getFloat64(ins+8, true);
+                    const y0=dv.getFloat64(ins+16, true);
+                    const radius0=dv.getFloat64(ins+24, true);
+                    const x1=dv.getFloat64(ins+32, true);
+                    const y1=dv.getFloat64(ins+40, true);
+                    const radius1=dv.getFloat64(ins+48, true);
+                    const id= dv.getUint32(ins+56, true);
 
                     let gradient=this.ctx.createRadialGradient(x0, y0, radius0, x1, y1, radius1);
                     if ( id in this.precomputedObjects ) console.log("warning: D2D_CREATERADIALGRADIENT ID already exists.");
@@ -388,11 +497,11 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_CREATELINEARGRADIENT:
                     {
-                        const x0=this.owner.getDouble(ins+8);
-                        const y0=this.owner.getDouble(ins+16);
-                        const x1=this.owner.getDouble(ins+24);
-                        const y1=this.owner.getDouble(ins+32);
-                        const id= this.owner.getLong(ins+40);
+                        const x0=dv.getFloat64(ins+8, true);
+                        const y0=dv.getFloat64(ins+16, true);
+                        const x1=dv.getFloat64(ins+24, true);
+                        const y1=dv.getFloat64(ins+32, true);
+                        const id= dv.getUint32(ins+40, true);
     
                         let gradient=this.ctx.createLinearGradient(x0, y0, x1, y1);
                         if ( id in this.precomputedObjects ) console.log("warning: D2D_CREATELINEARGRADIENT ID already exists.");
@@ -402,9 +511,9 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_SETCOLORSTOP:
                 {
-                    const id = this.owner.getLong(ins+8);
-                    const pos=this.owner.getLong(ins+12);
-                    const cssColor= this.owner.getString(this.owner.getLong(ins+16));
+                    const id = dv.getUint32(ins+8, true);
+                    const pos=dv.getUint32(ins+12, true);
+                    const cssColor= this.owner.getString(ins+dv.getUint32(ins+16, true));
 
                     if (!(id in this.precomputedObjects)) throw new Error("D2D_SETCOLORSTOP with invalid ID: "+id);
                     const gradient=this.precomputedObjects[id] as CanvasGradient;
@@ -414,7 +523,7 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_SETFILLSTYLEGRADIENT:
                 {
-                    const id=this.owner.getLong(ins+8);
+                    const id=dv.getUint32(ins+8, true);
                     if (!(id in this.precomputedObjects)) throw new Error("D2D_SETFILLSTYLEGRADIENT with invalid ID: "+id);
                     const gradient=this.precomputedObjects[id] as CanvasGradient;
                     this.ctx.fillStyle=gradient;
@@ -423,7 +532,7 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_RELEASEID:
                 {
-                    const id=this.owner.getLong(ins+8);
+                    const id=dv.getUint32(ins+8, true);
                     if (this.precomputedObjects[id])
                         delete this.precomputedObjects[id];
                     else
@@ -435,13 +544,13 @@ export class twrCanvas implements ICanvas {
 
                 case D2DType.D2D_PUTIMAGEDATA:
                 {
-                    const id=this.owner.getLong(ins+8);
-                    const dx=this.owner.getLong(ins+12);
-                    const dy=this.owner.getLong(ins+16);
-                    const dirtyX=this.owner.getLong(ins+20);
-                    const dirtyY=this.owner.getLong(ins+24);
-                    const dirtyWidth=this.owner.getLong(ins+28);
-                    const dirtyHeight=this.owner.getLong(ins+32);
+                    const id=dv.getUint32(ins+8, true);
+                    const dx=dv.getUint32(ins+12, true);
+                    const dy=dv.getUint32(ins+16, true);
+                    const dirtyX=dv.getUint32(ins+20, true);
+                    const dirtyY=dv.getUint32(ins+24, true);
+                    const dirtyWidth=dv.getUint32(ins+28, true);
+                    const dirtyHeight=dv.getUint32(ins+32, true);
 
                     if (!(id in this.precomputedObjects)) throw new Error("D2D_PUTIMAGEDATA with invalid ID: "+id);
 
@@ -471,49 +580,94 @@ export class twrCanvas implements ICanvas {
                 default:
                     throw new Error ("unimplemented or unknown Sequence Type in drawSeq: "+type);
             }
-            next=this.owner.getLong(ins);  /* hdr->next */
-            if (next==0) {
-                if (ins!=lastins) throw new Error("assert type error in twrcanvas, ins!=lastins");
-                break;
-            }
-            ins=next;
         }
 
-        if (this.cmdCompleteSignal) this.cmdCompleteSignal.signal();
+        if (this.cmdCompleteSignal && signal) this.cmdCompleteSignal.signal();
         //console.log("Canvas.drawSeq() completed  with instruction count of ", insCount);
     }
+
+    // one fillText for the whole run.  letterSpacing makes up the difference between the font's advance and the
+    // requested one (the font is monospace, so its advance is the width of any character).  Without letterSpacing
+    // (older browsers), a fillText per character
+    // With the glyph atlas, a drawImage per character, unless one isn't in the atlas
+    private fillCodePoints(c:Uint32Array, x:number, y:number, advance:number) {
+        const ctx=this.ctx!;
+        if (this.atlas && this.atlas.fillCodePoint(ctx, c[0], x, y)) {
+            for (let i=1; i<c.length; i++)
+                if (!this.atlas.fillCodePoint(ctx, c[i], x+i*advance, y))
+                    ctx.fillText(String.fromCodePoint(c[i]), x+i*advance, y);
+        }
+        else if ("letterSpacing" in ctx) {
+            if (ctx.font!=this.spacingFont) {
+                ctx.letterSpacing="0px";
+                this.spacingAdvance=ctx.measureText("0").width;
+                this.spacingFont=ctx.font;
+            }
+            ctx.letterSpacing=(advance-this.spacingAdvance)+"px";
+            ctx.fillText(String.fromCodePoint(...c), x, y);
+            ctx.letterSpacing="0px";
+        }
+        else {
+            for (let i=0; i<c.length; i++)
+                (ctx as CanvasRenderingContext2D).fillText(String.fromCodePoint(c[i]), x+i*advance, y);
+        }
+    }
 }
 
 export class twrCanvasProxy implements ICanvas {
     canvasKeys: twrSharedCircularBuffer;
+    lineReply: twrLineBeginReply;
     drawCompleteSignal:twrSignal;
     props: ICanvasProps;
+    id: string;
+    handle: number;
     owner: twrWasmModuleBase;
 
-    constructor(params:TCanvasProxyParams, owner:twrWasmModuleBase) {
-        const [props, signalBuffer,  canvasKeysBuffer] = params;
+    constructor(params:TCanvasProxyParams, owner:twrWasmModuleBase, handle:number) {
+        const [props, signalBuffer,  canvasKeysBuffer, id, lineReplyBuffer] = params;
         this.drawCompleteSignal = new twrSignal(signalBuffer);
         this.canvasKeys = new twrSharedCircularBuffer(canvasKeysBuffer);
+        this.lineReply = new twrLineBeginReply(lineReplyBuffer);
         this.props=props;
+        this.id=id;
+        this.handle=handle;
         this.owner=owner;
 
         //console.log("Create New twrCanvasProxy: ",this.props)
 
     }
 
-    charIn() {  
-        //ctx.commit(); not avail in chrome
-    
-        //postMessage(["debug", 'x']);
-        
-        return this.canvasKeys.readWait();  // wait for a key, then read it
+    // wait for a key, then read it (as a code point, without the modifier flags)
+    charIn() {
+        for (;;) {
+            const k=this.canvasKeys.readWait();
+            if (!(k&keyUp)) return k&keyCodeMask;
+        }
     }
-    
+
     inkey() {
-        if (this.canvasKeys.isEmpty())
-            return 0;
-        else
-            return this.charIn();    
+        while (!this.canvasKeys.isEmpty()) {
+            const k=this.canvasKeys.read();
+            if (!(k&keyUp)) return k&keyCodeMask;
+        }
+        return 0;
+    }
+
+    // wait for a key event, then copy every key event there is (up to n) to the long array at buf.  Returns the count
+    keysIn(buf:number, n:number) {
+        const keys=this.canvasKeys.readMany(n);
+        for (let i=0; i<keys.length; i++)
+            this.owner.setLong(buf+i*4, keys[i]);
+        return keys.length;
+    }
+
+    // start line editing on the main thread (see twrLineEditor), and wait for it to answer.  Returns 0, and the line
+    // is read key by key, if keys were typed ahead
+    lineBegin(cursor:number, foreColor:number, backColor:number) {
+        if (!this.canvasKeys.isEmpty()) return 0;
+        this.lineReply.reset();
+        postMessage(["canvaslinebegin", [this.handle, cursor, foreColor, backColor]]);
+        return this.lineReply.wait() ? 1 : 0;
     }
 
     getProp(pn:number): number {
@@ -527,4 +681,11 @@ export class twrCanvasProxy implements ICanvas {
         postMessage(["drawseq", [ds]]);
         this.drawCompleteSignal.wait();
     }
+
+    // a twrCanvasDrawSeqs batch whose last draw sequence is for this canvas.  One message, and one wait
+    drawSeqs(list:number, n:number) {
+        this.drawCompleteSignal.reset();
+        postMessage(["drawseqs", [list, n]]);
+        this.drawCompleteSignal.wait();
+    }
 }
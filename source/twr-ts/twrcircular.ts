@@ -1,67 +1,100 @@
 //
-// This class implements a circular buffer that the main javascript thread can write to, 
-// and a blocking WebWorker thread can read from.  This allows keyboard characters to be transferred from the main JS thread to a WebWorker thread.
-// The WebWorker can use the readWait() function to sleep, w/o participating in the normal 
+// This class implements a circular buffer that the main javascript thread can write to,
+// and a blocking WebWorker thread can read from.  This allows keyboard events to be transferred from the main JS thread to a WebWorker thread.
+// The WebWorker can use the readWait() or readMany() functions to sleep, w/o participating in the normal
 // async callback dispatch method.  This allows a C program that is a single blocking loop to receive input from the primary javascript thread.
-// readWait() is used used when io_getc32() or io_mbgetstr() is called from a C function.
+// readWait() is used when io_getc32() is called from a C function, and readMany() by io_getkeys() and io_mbgets().
+//
+// A single thread can write and a separate single thread can read.  The read and write indexes are counts (mod 2^32)
+// that only their own thread changes.  An entry is stored before the write count that includes it is published
+// (Atomics.store), and read before the read count that frees it is, so each thread sees the other's entries in order.
 //
 
-const RDIDX=256;
-const WRIDX=257;
-const LEN=256;
+const RDIDX=0;	// entries read, mod 2^32
+const WRIDX=1;	// entries written, mod 2^32
+const HDRLEN=2;	// the entries follow the two indexes
 
-// A single thread can read and a separate single thread can write.  With these constraints Atomic operations are not needed.
-// the first 256 array entries are the circular buffer
-// the next two are used for the read and write index
+// a key event is a unicode code point, or'd with these flags.  Keep in sync with IO_KEY_* in twr-io.h
+export const keyCodeMask=0x1FFFFF;
+export const keyShift=1<<24;
+export const keyCtrl=1<<25;
+export const keyAlt=1<<26;
+export const keyEchoed=1<<27;	// already shown by the console (see twrLineEditor)
+export const keyUp=1<<28;
 
 //!!!! I am using --enable-features=SharedArrayBuffer; see the SharedArrayBuffer docs for COR issues when going to a live web server
 
 export class twrSharedCircularBuffer {
 	sharedArray:SharedArrayBuffer;
 	buf:Int32Array;
- 
-	constructor (sa?:SharedArrayBuffer) {
+	size:number;		// number of entries, a power of 2
+	dropped=0;			// writes lost because the buffer was full
+
+	constructor (sa?:SharedArrayBuffer, size=1024) {
         if (typeof window !== 'undefined') {  // this check only works if window defined (not a worker thread)
             if (!crossOriginIsolated && !(window.location.protocol === 'file:')) throw new Error("twrSharedCircularBuffer constructor, crossOriginIsolated="+crossOriginIsolated+". See SharedArrayBuffer docs.");
         }
-        if (sa) this.sharedArray=sa;
-        else this.sharedArray=new SharedArrayBuffer(258*4);
+        if (sa) {
+            this.sharedArray=sa;
+            this.size=sa.byteLength/4-HDRLEN;
+        }
+        else {
+            this.size=2;
+            while (this.size<size) this.size*=2;
+            this.sharedArray=new SharedArrayBuffer((HDRLEN+this.size)*4);
+        }
 		this.buf=new Int32Array(this.sharedArray);
-        this.buf[RDIDX]=0;
-        this.buf[WRIDX]=0;
 	}
 
+	// returns false (and the entry is dropped) if the buffer is full.  The main JS thread can't wait for room.
 	write(n:number) {
-        let i=this.buf[WRIDX];
-        this.buf[i]=n;
-        i++;
-        if (i==LEN) i=0;
-        this.buf[WRIDX]=i;  
-        Atomics.notify(this.buf, WRIDX);   
+        const rd=Atomics.load(this.buf, RDIDX);
+        const wr=this.buf[WRIDX];
+        if (((wr-rd)|0) >= this.size) {
+            this.dropped++;
+            return false;
+        }
+        this.buf[HDRLEN+(wr&(this.size-1))]=n;
+        Atomics.store(this.buf, WRIDX, (wr+1)|0);
+        Atomics.notify(this.buf, WRIDX);
+        return true;
 	}
 
 	read():number {
-        if (!this.isEmpty()) {
-            let i=this.buf[RDIDX];
-            let n=this.buf[i];
-            i++;
-            this.buf[RDIDX]=i;
-            return n;
-        }
-		else
-            return -1;
+        const wr=Atomics.load(this.buf, WRIDX);
+        const rd=this.buf[RDIDX];
+        if (wr==rd) return -1;
+        const n=this.buf[HDRLEN+(rd&(this.size-1))];
+        Atomics.store(this.buf, RDIDX, (rd+1)|0);
+        return n;
 	}
 
     readWait():number {
-        if (this.isEmpty()) {
-            const rdptr=this.buf[RDIDX];
-            // verifies that a shared memory location still contains a given value and if so sleeps until notified.
-            Atomics.wait(this.buf, WRIDX, rdptr);
-        }
+        this.wait();
         return this.read();
 	}
 
+    // wait until there is at least one entry, then read every entry there is (up to max)
+    readMany(max=this.size):number[] {
+        this.wait();
+        const wr=Atomics.load(this.buf, WRIDX);
+        const rd=this.buf[RDIDX];
+        const n=Math.min((wr-rd)|0, max);
+        const out:number[]=new Array(n);
+        for (let i=0; i<n; i++)
+            out[i]=this.buf[HDRLEN+((rd+i)&(this.size-1))];
+        Atomics.store(this.buf, RDIDX, (rd+n)|0);
+        return out;
+    }
+
     isEmpty():boolean {
-        return this.buf[RDIDX]==this.buf[WRIDX];
+        return Atomics.load(this.buf, WRIDX)==this.buf[RDIDX];
+    }
+
+    // verifies that the write index still equals the read index (the buffer is empty), and if so sleeps until notified
+    private wait() {
+        let rd;
+        while (Atomics.load(this.buf, WRIDX)==(rd=this.buf[RDIDX]))
+            Atomics.wait(this.buf, WRIDX, rd);
     }
 }
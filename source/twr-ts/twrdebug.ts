@@ -1,5 +1,11 @@
 
+import {twrWasmModuleBase} from "./twrmodbase.js"
+import {twrCodePageDecoder, codePageUTF8} from "./twrlocale.js"
+import {twrSharedOutputRing, TOutputRingProxyParams} from "./twroutring.js"
+
 let logline="";
+const decoder=new twrCodePageDecoder();
+
 export function twrDebugLogImpl(char:number) {
 	if (char==10 || char==3) {  // ASCII 03 is End-of-Text, and is used here to indicate the preceding char should be printed
 		console.log(logline);	// ideally without a linefeed, but there is no way to not have a LF with console.log API.
@@ -14,10 +20,50 @@ export function twrDebugLogImpl(char:number) {
 	}
 }
 
-// ************************************************************************
-// debugLog doesn't currently wait for the message to log, it returns immediately.
-// I could move this to be in the twrWaitingCalls class
-export function twrDebugLogProxy(ch:number) {
-    postMessage(["debug", ch]);
+// same as twrDebugLogImpl, but for a string
+export function twrDebugLogString(str:string) {
+	let start=0;
+	for (let i=0; i<str.length; i++) {
+		const c=str.charCodeAt(i);
+		if (c==10 || c==3) {
+			console.log(logline+str.substring(start, i));
+			logline="";
+			start=i+1;
+		}
+	}
+	logline=logline+str.substring(start);
+	if (logline.length>=300) {
+		console.log(logline);
+		logline="";
+	}
 }
 
+// len bytes of utf-8 from module memory
+export function twrDebugLogStrImpl(this:twrWasmModuleBase, str:number, len:number) {
+	twrDebugLogString(decoder.decode(this.mem8.subarray(str, str+len), codePageUTF8));
+}
+
+// ************************************************************************
+// twrWasmModuleAsync: the worker writes the log to a twrSharedOutputRing, and the main thread reads it (see
+// twrWasmModuleAsync "debug" message)
+export type TDebugLogProxyParams = TOutputRingProxyParams;
+
+export class twrDebugLogProxy {
+    debugOut:twrSharedOutputRing;
+    owner:twrWasmModuleBase;
+
+    constructor(params:TDebugLogProxyParams, owner:twrWasmModuleBase) {
+        this.debugOut=new twrSharedOutputRing(params);
+        this.debugOut.wake=()=>postMessage(["debug"]);
+        this.owner=owner;
+    }
+
+    charOut(ch:number) {
+        this.debugOut.writeCodePoint(ch);
+    }
+
+    // already UTF-8
+    strOut(str:number, len:number) {
+        this.debugOut.write(this.owner.mem8.subarray(str, str+len));
+    }
+}
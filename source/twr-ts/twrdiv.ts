@@ -1,32 +1,59 @@
-import {twrSharedCircularBuffer} from "./twrcircular.js";
+import {twrSharedCircularBuffer, keyCodeMask, keyUp, keyEchoed} from "./twrcircular.js";
+import {twrLineEditor, twrLineBeginReply} from "./twrlineedit.js";
+import {twrSharedOutputRing, TOutputRingProxyParams} from "./twroutring.js";
 import {IModParams} from "./twrmodbase.js";
 import {twrWasmModuleBase} from "./twrmodbase.js";
-import {twrCodePageToUnicodeCodePointImpl, codePageUTF32} from "./twrlocale.js"
+import {twrCodePageToUnicodeCodePointImpl, codePageUTF32, codePageUTF8, twrCodePageDecoder} from "./twrlocale.js"
 
-export type TDivProxyParams = [SharedArrayBuffer];
+export type TDivProxyParams = [SharedArrayBuffer, TOutputRingProxyParams, string, SharedArrayBuffer];
 
 export interface IDiv {
     charOut: (ds:number, codePage:number)=>void,
+    strOut: (str:number, len:number, codePage:number)=>void,
     charIn?: ()=>number,
     inkey?: ()=>number,
+    keysIn?: (buf:number, n:number)=>number,
+    lineBegin?: ()=>number,
     getProxyParams?: ()=>TDivProxyParams,
  }
 
 
 export class twrDiv implements IDiv {
 	div:HTMLDivElement|null|undefined;
+	id:string;      // the element id
 	divKeys?:twrSharedCircularBuffer;
+	divOut?:twrSharedOutputRing;    // twrWasmModuleAsync output
+	lineEditor?:twrLineEditor;      // twrWasmModuleAsync io_mbgets line mode
+	lineReply?:twrLineBeginReply;
 	CURSOR=String.fromCharCode(9611);  // ▋ see https://daniel-hug.github.io/characters/#k_70
 	cursorOn:boolean=false;
 	lastChar:number=0;
-	extraBR:boolean=false;
 	owner:twrWasmModuleBase;
+	decoder=new twrCodePageDecoder();
+	scrollback:number;      // the most lines kept in the div
+
+	// output is kept here, and the div is updated (at most) once an animation frame
+	line="";                // the last line.  Spaces are &nbsp;, as the div is HTML
+	lines:string[]=[];      // lines ended since the last update.  The first one is the end of lineNode's line
+	lineNode?:Text;         // the last line in the div, followed by the cursor if it is on
+	lineCount=0;            // <br>s in the div
+	reset=false;            // so many lines were output that the div's lines are all gone (past scrollback)
+	scroll=false;
+	updatePending=false;
 
     constructor(element:HTMLDivElement|null|undefined,  modParams:IModParams, modbase:twrWasmModuleBase) {
 		this.div=element;
+		this.id=element?.id ?? "";
 		this.owner=modbase;
+		this.scrollback=modParams.scrollback;
         if (!this.owner.isWasmModule) {   // twrWasmModule doesn't use shared memory
-			this.divKeys = new twrSharedCircularBuffer();  // tsconfig, lib must be set to 2017 or higher
+			this.divKeys = new twrSharedCircularBuffer(undefined, modParams.keybuffer);  // tsconfig, lib must be set to 2017 or higher
+			this.divOut = new twrSharedOutputRing();
+			this.lineEditor = new twrLineEditor(
+				(cp)=>this.charOut(cp, codePageUTF32),
+				(keys)=>{ for (const k of keys) this.divKeys!.write(k|keyEchoed); },
+				this.divKeys.size);
+			this.lineReply = new twrLineBeginReply();
 		}
 
 		if (this.div && !modParams.styleIsDefault) {  // don't let default colors override divStyle
@@ -41,15 +68,47 @@ export class twrDiv implements IDiv {
 	}
 
     getProxyParams() : TDivProxyParams {
-        if (!this.divKeys) throw new Error("internal error in getProxyParams.");
-        return [ this.divKeys.sharedArray];
+        if (!this.divKeys || !this.divOut || !this.lineReply) throw new Error("internal error in getProxyParams.");
+        return [ this.divKeys.sharedArray, this.divOut.sharedArray, this.id, this.lineReply.sharedArray];
     }
 
+	// twrDivProxy has written to divOut
+	readOutput() {
+		if (!this.divOut) throw new Error("internal error in readOutput.");
+		this.divOut.scheduleRead((text)=>{
+			this.stringOut(text);
+			this.update();   // now, rather than in the next frame
+		});
+	}
+
+	// add what twrDivProxy has written to divOut now, so that it comes before output from this thread
+	flushOutput() {
+		const text=this.divOut?.readText();
+		if (text) {
+			this.stringOut(text);
+			this.update();
+		}
+	}
+
+	// twrDivProxy.lineBegin.  Unless keys were typed ahead, keys go to lineEditor until the line is finished.  The
+	// output so far (the prompt) is added first, so that the echo follows it
+	beginLine() {
+		if (!this.divKeys || !this.divOut || !this.lineEditor || !this.lineReply) throw new Error("internal error in beginLine.");
+		if (!this.divKeys.isEmpty()) {
+			this.lineReply.reply(false);
+			return;
+		}
+		const text=this.divOut.readText();
+		if (text) this.stringOut(text);
+		this.lineEditor.begin();
+		this.lineReply.reply(true);
+	}
 
 /* 
  * add utf-8 or windows-1252 character to div.  Supports the following control codes:
  * any of CRLF, CR (/r), or LF(/n)  will cause a new line
  * 0x8 backspace
+ * 0xC form feed (clear the div, eg from an ESC [2J escape sequence)
  * 0xE cursor on 
  * 0xF cursor off 
 */
@@ -59,90 +118,187 @@ export class twrDiv implements IDiv {
 
 		//console.log("div::charout: ", ch, codePage);
 
-		if (this.extraBR) {
-			this.extraBR=false;
-			if (this.cursorOn) this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-			this.div.innerHTML=this.div.innerHTML.slice(0, -4);
-			if (this.cursorOn) this.div.innerHTML +=  this.CURSOR;
-		}
-
 		const chnum=twrCodePageToUnicodeCodePointImpl(ch, codePage);
 		if (chnum!=0) {
 			switch (chnum) {
 				case 10:  // newline
 				case 13:  // return
 					if (ch==10 && this.lastChar==13) break;  // detect CR LF and treat as single new line
-					if (this.cursorOn) this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-					this.div.innerHTML +=  "<br><br>";   //2nd break is a place holder for next line (fixes scroll issue at bottom)
-					this.extraBR=true;
-					if (this.cursorOn) this.div.innerHTML +=  this.CURSOR;
-					//element.scrollIntoView();
-					//element.scrollTop = element.scrollHeight;
-					let p = this.div.getBoundingClientRect();
-					window.scrollTo(0, p.height+100);
+					this.lines.push(this.line);
+					this.line="";
+					this.scroll=true;
+					if (this.lines.length>=this.scrollback*2) {   // (for output that doesn't let an animation frame run)
+						this.lines.splice(0, this.lines.length-this.scrollback);
+						this.reset=true;
+					}
 					break;
 
 				case 8:  // backspace
-					if (this.cursorOn) this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-					this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-					if (this.cursorOn) this.div.innerHTML +=  this.CURSOR;
+					if (this.line.length>0) {
+						const last=this.line.charCodeAt(this.line.length-1);
+						this.line=this.line.slice(0, last>=0xDC00 && last<=0xDFFF ? -2 : -1);  // a surrogate pair is one code point
+					}
+					break;
+
+				case 0xC:   // form feed
+					this.lines=[];
+					this.line="";
+					this.reset=true;
 					break;
 
 				case 0xE:   // cursor on
 					if (!this.cursorOn) {
 						this.cursorOn=true;
-						this.div.innerHTML +=  this.CURSOR;
 						this.div.focus();
 					}
 					break;
 
 				case 0xF:   // cursor off
-					if (this.cursorOn) {
-						this.cursorOn=false;
-						this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-					}
+					this.cursorOn=false;
 					break;
+
 				default:
-					if (this.cursorOn) this.div.innerHTML=this.div.innerHTML.slice(0, -1);
-					let newchr=String.fromCodePoint(chnum);
-					if (newchr==' ') newchr="&nbsp;";
-					this.div.innerHTML += newchr;
-					if (this.cursorOn) this.div.innerHTML +=  this.CURSOR;
+					this.line+=(chnum==32 ? "\u00A0" : String.fromCodePoint(chnum));
 					break;
 				}
 
 			this.lastChar=chnum;
+			if (!this.updatePending) {
+				this.updatePending=true;
+				requestAnimationFrame(()=>this.update());
+			}
 		}
 	}
 
 	stringOut(str:string) {
-		for (let i=0; i < str.length; i++)
-			this.charOut(str.codePointAt(i)||0, codePageUTF32);
+		for (const ch of str)  // by code point, not UTF-16 unit
+			this.charOut(ch.codePointAt(0)||0, codePageUTF32);
+	}
+
+	// add len bytes of utf-8 or windows-1252 text from module memory.  Same control codes as charOut.
+	strOut(str:number, len:number, codePage:number) {
+		this.stringOut(this.decoder.decode(this.owner.mem8.subarray(str, str+len), codePage));
+	}
+
+	// make the div show the output so far.  The new lines go in as one DocumentFragment
+	private update() {
+		this.updatePending=false;
+		if (!this.div) return;
+
+		if (this.reset) {
+			this.div.replaceChildren();
+			this.reset=false;
+		}
+
+		// the first output, or the page has replaced what was in the div (eg, with innerHTML)
+		if (!this.lineNode || this.lineNode.parentNode!==this.div) {
+			this.lineNode=document.createTextNode("");
+			this.div.appendChild(this.lineNode);
+			this.lineCount=this.div.getElementsByTagName("br").length;
+		}
+
+		if (this.lines.length>0) {
+			this.lineNode.data=this.lines[0];
+			const frag=document.createDocumentFragment();
+			frag.appendChild(document.createElement("br"));
+			for (let i=1; i<this.lines.length; i++) {
+				frag.appendChild(document.createTextNode(this.lines[i]));
+				frag.appendChild(document.createElement("br"));
+			}
+			const lineNode=document.createTextNode("");
+			frag.appendChild(lineNode);
+			this.div.insertBefore(frag, this.lineNode.nextSibling);
+			this.lineNode=lineNode;
+			this.lineCount+=this.lines.length;
+			this.lines=[];
+
+			// remove the oldest lines, each up to and including its <br>
+			while (this.lineCount>this.scrollback && this.div.firstChild) {
+				const node=this.div.firstChild;
+				this.div.removeChild(node);
+				if (node.nodeName=="BR") this.lineCount--;
+			}
+		}
+
+		this.lineNode.data=this.cursorOn ? this.line+this.CURSOR : this.line;
+
+		if (this.scroll) {
+			this.scroll=false;
+			const p = this.div.getBoundingClientRect();
+			window.scrollTo(0, p.height+100);
+		}
 	}
 }
 
 
 export class twrDivProxy implements IDiv {
     divKeys: twrSharedCircularBuffer;
+    divOut: twrSharedOutputRing;
+    lineReply: twrLineBeginReply;
+    id:string;
+    handle:number;
+    owner:twrWasmModuleBase;
+    decoder=new twrCodePageDecoder();
 
-    constructor(params:TDivProxyParams) {
-        const [divKeysBuffer] = params;
+    constructor(params:TDivProxyParams, owner:twrWasmModuleBase, handle:number) {
+        const [divKeysBuffer, divOutBuffer, id, lineReplyBuffer] = params;
         this.divKeys = new twrSharedCircularBuffer(divKeysBuffer);
+        this.lineReply = new twrLineBeginReply(lineReplyBuffer);
+        this.divOut = new twrSharedOutputRing(divOutBuffer);
+        this.divOut.wake=()=>postMessage(["divout", handle]);
+        this.id=id;
+        this.handle=handle;
+        this.owner=owner;
     }
 
-    charIn() {  
-        return this.divKeys.readWait();  // wait for a key, then read it
+    // wait for a key, then read it (as a code point, without the modifier flags)
+    charIn() {
+        for (;;) {
+            const k=this.divKeys.readWait();
+            if (!(k&keyUp)) return k&keyCodeMask;
+        }
     }
-    
+
     inkey() {
-        if (this.divKeys.isEmpty())
-            return 0;
-        else
-            return this.charIn();    
+        while (!this.divKeys.isEmpty()) {
+            const k=this.divKeys.read();
+            if (!(k&keyUp)) return k&keyCodeMask;
+        }
+        return 0;
     }
 
-	charOut(ch:number, codePoint:number) {
-		postMessage(["divout", [ch, codePoint]]);
+    // wait for a key event, then copy every key event there is (up to n) to the long array at buf.  Returns the count
+    keysIn(buf:number, n:number) {
+        const keys=this.divKeys.readMany(n);
+        for (let i=0; i<keys.length; i++)
+            this.owner.setLong(buf+i*4, keys[i]);
+        return keys.length;
+    }
+
+    // start line editing on the main thread (see twrLineEditor), and wait for it to answer.  Returns 0, and the line
+    // is read key by key, if keys were typed ahead
+    lineBegin() {
+        if (!this.divKeys.isEmpty()) return 0;
+        this.lineReply.reset();
+        postMessage(["divlinebegin", this.handle]);
+        return this.lineReply.wait() ? 1 : 0;
+    }
+
+	// divOut is UTF-8, so UTF-8 bytes go as is (a character split across calls is put back together by the reader)
+	charOut(ch:number, codePage:number) {
+		if (codePage==codePageUTF8) {
+			this.divOut.writeByte(ch);
+		}
+		else {
+			const cp=twrCodePageToUnicodeCodePointImpl(ch, codePage);
+			if (cp!=0) this.divOut.writeCodePoint(cp);
+		}
 	}
-}
 
+	strOut(str:number, len:number, codePage:number) {
+		if (codePage==codePageUTF8)
+			this.divOut.write(this.owner.mem8.subarray(str, str+len));
+		else
+			this.divOut.writeString(this.decoder.decode(this.owner.mem8.subarray(str, str+len), codePage));
+	}
+}
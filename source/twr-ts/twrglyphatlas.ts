@@ -0,0 +1,146 @@
+// A cache of rendered glyphs, so that text can be drawn to a canvas with drawImage copies instead of fillText.
+// Each glyph (for a font and fill color), or block graphic (for a color and size), is drawn once into a tile of an
+// offscreen canvas.  When every tile is in use, the least recently used one is reused.
+
+// draw a d2d_fillblocks cell with fillRect.  The split matches the C side (see draw2d.c)
+export function fillBlocks(ctx:CanvasRenderingContext2D, bits:number, x:number, y:number, w:number, h:number) {
+    const w1=Math.floor(w/2);
+    const w2=w-w1;
+    const h1=Math.floor(h/3);
+    const h3=h-h1*2;
+
+    if (bits&1)  ctx.fillRect(x, y, w1, h1);
+    if (bits&2)  ctx.fillRect(x+w1, y, w2, h1);
+    if (bits&4)  ctx.fillRect(x, y+h1, w1, h1);
+    if (bits&8)  ctx.fillRect(x+w1, y+h1, w2, h1);
+    if (bits&16) ctx.fillRect(x, y+h1*2, w1, h3);
+    if (bits&32) ctx.fillRect(x+w1, y+h1*2, w2, h3);
+}
+
+export class twrGlyphAtlas {
+    canvas:HTMLCanvasElement;
+    ctx:CanvasRenderingContext2D;
+    tileW:number;
+    tileH:number;
+    cols:number;
+    capacity:number;
+    tiles=new Map<string, number>();  // key to tile, least recently used first.  -1 for glyphs that don't fit in a tile
+    free:number[]=[];
+    hits=0;
+    misses=0;
+
+    static readonly PAD=1;   // between tiles, so that anti-aliased edges don't bleed into a neighbor
+
+    constructor(tileW:number, tileH:number, cols=32, rows=32) {
+        this.tileW=tileW;
+        this.tileH=tileH;
+        this.cols=cols;
+        this.capacity=cols*rows;
+        this.clear();
+
+        this.canvas=document.createElement("canvas");
+        this.canvas.width=cols*(tileW+twrGlyphAtlas.PAD);
+        this.canvas.height=rows*(tileH+twrGlyphAtlas.PAD);
+        const c=this.canvas.getContext("2d");
+        if (!c) throw new Error("canvas 2D context not found in twrGlyphAtlas.constructor");
+        this.ctx=c;
+        this.ctx.textBaseline="top";
+    }
+
+    // draw code point c at x, y, with ctx's font and fillStyle.  Returns false (and draws nothing) if it can't be
+    // drawn from the atlas, in which case the caller uses fillText
+    fillCodePoint(ctx:CanvasRenderingContext2D, c:number, x:number, y:number) {
+        if (typeof ctx.fillStyle!="string" || ctx.textBaseline!="top" || (ctx.textAlign!="start" && ctx.textAlign!="left"))
+            return false;
+
+        const font=ctx.font;
+        const color=ctx.fillStyle;
+        const tile=this.lookup(font+"|"+color+"|"+c, (tx, ty)=>{
+            this.ctx.font=font;
+            const txt=String.fromCodePoint(c);
+            const m=this.ctx.measureText(txt);
+            if (m.actualBoundingBoxLeft>0 || m.actualBoundingBoxRight>this.tileW || m.actualBoundingBoxAscent>0 || m.actualBoundingBoxDescent>this.tileH)
+                return false;
+            this.ctx.fillStyle=color;
+            this.ctx.fillText(txt, tx, ty);
+            return true;
+        });
+
+        if (tile<0) return false;
+        this.drawTile(ctx, tile, x, y);
+        return true;
+    }
+
+    // a d2d_fillblocks cell, with ctx's fillStyle
+    fillBlocks(ctx:CanvasRenderingContext2D, bits:number, x:number, y:number, w:number, h:number) {
+        if (typeof ctx.fillStyle!="string" || w>this.tileW || h>this.tileH) {
+            fillBlocks(ctx, bits, x, y, w, h);
+            return;
+        }
+
+        const color=ctx.fillStyle;
+        const tile=this.lookup("#"+bits+"|"+color+"|"+w+"x"+h, (tx, ty)=>{
+            this.ctx.fillStyle=color;
+            fillBlocks(this.ctx, bits, tx, ty, w, h);
+            return true;
+        });
+
+        this.drawTile(ctx, tile, x, y);
+    }
+
+    private drawTile(ctx:CanvasRenderingContext2D, tile:number, x:number, y:number) {
+        const [sx, sy]=this.tileXY(tile);
+        ctx.drawImage(this.canvas, sx, sy, this.tileW, this.tileH, x, y, this.tileW, this.tileH);
+    }
+
+    private tileXY(tile:number) {
+        return [(tile%this.cols)*(this.tileW+twrGlyphAtlas.PAD), Math.floor(tile/this.cols)*(this.tileH+twrGlyphAtlas.PAD)];
+    }
+
+    // the tile for key, or -1 if it doesn't fit.  On a miss, render draws it into a cleared tile at tx, ty
+    private lookup(key:string, render:(tx:number, ty:number)=>boolean) {
+        const tile=this.tiles.get(key);
+        if (tile!==undefined) {
+            this.hits++;
+            this.tiles.delete(key);   // a Map iterates in insertion order, so this makes key the most recently used
+            this.tiles.set(key, tile);
+            return tile;
+        }
+
+        this.misses++;
+        // entries for glyphs that don't fit use no tile, but are limited too
+        if (this.free.length==0 || this.tiles.size>=this.capacity*2)
+            this.evict();
+
+        const t=this.free.pop()!;
+        const [tx, ty]=this.tileXY(t);
+        this.ctx.clearRect(tx, ty, this.tileW, this.tileH);
+        if (render(tx, ty)) {
+            this.tiles.set(key, t);
+            return t;
+        }
+
+        this.free.push(t);
+        this.tiles.set(key, -1);
+        return -1;
+    }
+
+    // remove least recently used entries, up to and including the first one with a tile
+    private evict() {
+        for (const [key, tile] of this.tiles) {
+            this.tiles.delete(key);
+            if (tile>=0) {
+                this.free.push(tile);
+                return;
+            }
+        }
+    }
+
+    // forget every glyph (for example, to free the memory of glyphs that won't be used again)
+    clear() {
+        this.tiles.clear();
+        this.free=[];
+        for (let i=this.capacity-1; i>=0; i--)
+            this.free.push(i);
+    }
+}
@@ -0,0 +1,136 @@
+// Line editing on the main JS thread, for io_mbgets() on a twrWasmModuleAsync console (see io_set_line_mode).
+// While a line is being edited, keys are echoed, erased (backspace) and recalled from history (up and down arrows)
+// here, without a round trip to the WebWorker thread for each one.  When Enter (or Esc) is pressed, the whole line is
+// written to the console's key buffer at once, and the worker is woken once.
+//
+// Line mode only starts if no keys are waiting in the key buffer.  The main JS thread decides this, because it is
+// the thread that writes keys, and the WebWorker thread waits for the answer (twrLineBeginReply).  So a key typed
+// while line mode is starting goes either to the key buffer (and line mode doesn't start), or to the editor.
+
+import {keyCodeMask} from "./twrcircular.js";
+
+const BACKSPACE=8;
+const ENTER=10;
+const RETURN=13;
+const ESC=0x1B;
+const ARROW_UP=0x2191;
+const ARROW_DOWN=0x2193;
+
+const PENDING=0;
+const ACCEPTED=1;
+const DECLINED=2;
+
+// the main JS thread's answer to a request (from the WebWorker thread) to start line mode
+export class twrLineBeginReply {
+    sharedArray:SharedArrayBuffer;
+    buf:Int32Array;
+
+    constructor(sa?:SharedArrayBuffer) {
+        this.sharedArray=sa ?? new SharedArrayBuffer(4);
+        this.buf=new Int32Array(this.sharedArray);
+    }
+
+    // WebWorker thread: call before the request is posted
+    reset() {
+        Atomics.store(this.buf, 0, PENDING);
+    }
+
+    // main JS thread
+    reply(accepted:boolean) {
+        Atomics.store(this.buf, 0, accepted?ACCEPTED:DECLINED);
+        Atomics.notify(this.buf, 0);
+    }
+
+    // WebWorker thread: true if line mode started
+    wait() {
+        while (Atomics.load(this.buf, 0)==PENDING)
+            Atomics.wait(this.buf, 0, PENDING);
+        return Atomics.load(this.buf, 0)==ACCEPTED;
+    }
+}
+
+export class twrLineEditor {
+    active=false;
+    line:number[]=[];           // code points
+    history:number[][]=[];      // entered lines, oldest first
+    historyIndex=0;             // history.length if not showing a history line
+    historySize:number;
+    maxKeys:number;             // the key buffer size.  The line is at most maxKeys-1 code points, so ENTER always fits
+    echo:(cp:number)=>void;     // show a code point (or erase the last one, for BACKSPACE) on the console
+    send:(keys:number[])=>void; // the finished line, or [ESC]
+
+    constructor(echo:(cp:number)=>void, send:(keys:number[])=>void, maxKeys:number, historySize=100) {
+        this.echo=echo;
+        this.send=send;
+        this.maxKeys=maxKeys;
+        this.historySize=historySize;
+    }
+
+    begin() {
+        this.active=true;
+        this.line=[];
+        this.historyIndex=this.history.length;
+    }
+
+    // a key event (see keyEventProcess) while active
+    key(k:number) {
+        const c=k&keyCodeMask;
+        switch (c) {
+            case BACKSPACE:
+                if (this.line.length>0) {
+                    this.line.pop();
+                    this.echo(BACKSPACE);
+                }
+                break;
+
+            case ENTER:
+            case RETURN:
+                if (this.line.length>0 && !this.sameAsLast(this.line)) {
+                    this.history.push(this.line);
+                    if (this.history.length>this.historySize) this.history.shift();
+                }
+                this.echo(ENTER);
+                this.active=false;
+                this.send([...this.line, ENTER]);
+                break;
+
+            case ESC:
+                this.active=false;
+                this.send([ESC]);
+                break;
+
+            case ARROW_UP:
+                if (this.historyIndex>0)
+                    this.replace(this.history[--this.historyIndex]);
+                break;
+
+            case ARROW_DOWN:
+                if (this.historyIndex<this.history.length) {
+                    this.historyIndex++;
+                    this.replace(this.historyIndex<this.history.length ? this.history[this.historyIndex] : []);
+                }
+                break;
+
+            default:
+                // not a control code or another arrow, and there is room in the key buffer
+                if (c>=0x20 && c!=0x7F && (c<0x2190 || c>0x2193) && this.line.length<this.maxKeys-1) {
+                    this.line.push(c);
+                    this.echo(c);
+                }
+                break;
+        }
+    }
+
+    private replace(line:number[]) {
+        for (let i=0; i<this.line.length; i++)
+            this.echo(BACKSPACE);
+        this.line=line.slice(0, this.maxKeys-1);
+        for (const c of this.line)
+            this.echo(c);
+    }
+
+    private sameAsLast(line:number[]) {
+        const last=this.history[this.history.length-1];
+        return !!last && last.length==line.length && last.every((c, i)=>c==line[i]);
+    }
+}
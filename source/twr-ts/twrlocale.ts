@@ -33,6 +33,26 @@ export function twrCodePageToUnicodeCodePointImpl(c:number, codePage:number) {
 	return outstr.codePointAt(0) || 0;
 }
 
+// decodes spans of bytes (in a code page) from module memory.  The TextDecoders are created once and reused.
+// A UTF-8 sequence split across two spans is kept until the next decode, so use one instance per output stream.
+export class twrCodePageDecoder {
+	utf8=new TextDecoder('utf-8');
+
+	decode(u8:Uint8Array, codePage:number) {
+		// TextDecoder doesn't accept a view of a SharedArrayBuffer (twrWasmModuleAsync memory)
+		if (!(u8.buffer instanceof ArrayBuffer)) u8=u8.slice();
+
+		if (codePage==codePageUTF8)
+			return this.utf8.decode(u8, {stream: true});
+		else if (codePage==codePage1252)
+			return decoder1252.decode(u8);
+		else if (codePage==codePageASCII)
+			return decoder1252.decode(u8.filter(c=>c<=127));   // same as 1252 below 128
+		else
+			throw new Error("unsupported CodePage: "+codePage);
+	}
+}
+
 export function twrUnicodeCodePointToCodePageImpl(this: twrWasmModuleBase, outstr:number, cp:number, codePage:number) {
 	return noasyncCopyString(this, outstr, String.fromCodePoint(cp), codePage);
 }
@@ -1,7 +1,6 @@
-import {twrDebugLogImpl} from "./twrdebug.js"
+import {twrDebugLogImpl, twrDebugLogStrImpl} from "./twrdebug.js"
 import {IModOpts} from "./twrmodbase.js";
 import {twrWasmModuleInJSMain} from "./twrmodjsmain.js"
-import {twrCanvas} from "./twrcanvas.js";
 import {twrTimeEpochImpl} from "./twrdate.js"
 import {twrTimeTmLocalImpl, twrUserLconvImpl, twrUserLanguageImpl, twrRegExpTest1252Impl,twrToLower1252Impl, twrToUpper1252Impl} from "./twrlocale.js"
 import {twrStrcollImpl, twrUnicodeCodePointToCodePageImpl, twrCodePageToUnicodeCodePointImpl, twrGetDtnamesImpl} from "./twrlocale.js"
@@ -15,13 +14,10 @@ export class twrWasmModule extends twrWasmModuleInJSMain {
 	constructor(opts:IModOpts={}) {
 		super(opts, true);
 		this.malloc=(size:number)=>{throw new Error("error - un-init malloc called")};
-		
-		let canvas:twrCanvas;
-		if (this.d2dcanvas.isValid()) canvas=this.d2dcanvas;
-		else canvas=this.iocanvas;
 
 		this.modParams.imports={
 			twrDebugLog:twrDebugLogImpl,
+			twrDebugLogStr:twrDebugLogStrImpl.bind(this),
 			twrTimeEpoch:twrTimeEpochImpl,
 			twrTimeTmLocal:twrTimeTmLocalImpl.bind(this),
 			twrUserLconv:twrUserLconvImpl.bind(this),
@@ -34,13 +30,26 @@ export class twrWasmModule extends twrWasmModuleInJSMain {
 			twrCodePageToUnicodeCodePoint:twrCodePageToUnicodeCodePointImpl.bind(this),
 			twrGetDtnames:twrGetDtnamesImpl.bind(this),
 			
-			twrDivCharOut:this.iodiv.charOut.bind(this.iodiv),
-			twrCanvasGetProp:canvas.getProp.bind(canvas),
-			twrCanvasDrawSeq:canvas.drawSeq.bind(canvas),
+			twrDivCharOut:(div:number, c:number, codePage:number)=>this.getDiv(div).charOut(c, codePage),
+			twrDivStrOut:(div:number, str:number, len:number, codePage:number)=>this.getDiv(div).strOut(str, len, codePage),
+			twrDivGetHandle:this.getDivHandle.bind(this),
+			twrCanvasGetProp:(canvas:number, pn:number)=>this.getCanvas(canvas).getProp(pn),
+			twrCanvasDrawSeq:(ds:number)=>this.getCanvas(this.getLong(ds+8)).drawSeq(ds),  /* ds->canvas */
+			twrCanvasDrawSeqs:this.drawSeqs.bind(this),
+			twrCanvasGetHandle:this.getCanvasHandle.bind(this),
 			twrCanvasCharIn:this.null,
 			twrCanvasInkey:this.null,
+			twrCanvasKeysIn:this.null,
+			twrCanvasLineBegin:this.null,
 			twrDivCharIn:this.null,
+			twrDivKeysIn:this.null,
+			twrDivLineBegin:this.null,
+			twrLineModeAvailable:()=>0,
 			twrSleep:this.null,
+			twrRangeOpen:this.null,
+			twrRangeSize:this.null,
+			twrRangeRead:this.null,
+			twrRangeClose:this.null,
 
 			twrSin:Math.sin,
 			twrCos:Math.cos,
@@ -59,10 +68,6 @@ export class twrWasmModule extends twrWasmModuleInJSMain {
 			twrTrunc: Math.trunc,
 
 			twrDtoa: this.floatUtil.dtoa.bind(this.floatUtil),
-			twrToFixed: this.floatUtil.toFixed.bind(this.floatUtil),
-			twrToExponential: this.floatUtil.toExponential.bind(this.floatUtil),
-			twrAtod: this.floatUtil.atod.bind(this.floatUtil),
-			twrFcvtS: this.floatUtil.fcvtS.bind(this.floatUtil),
 		}
 	}
 
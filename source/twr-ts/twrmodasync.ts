@@ -1,8 +1,10 @@
 import {IModOpts, IModParams, IModProxyParams} from "./twrmodbase.js";
-import {twrDebugLogImpl} from "./twrdebug.js";
+import {twrDebugLogString} from "./twrdebug.js";
 import {twrWasmModuleInJSMain} from "./twrmodjsmain.js"
 import {twrWaitingCalls} from "./twrwaitingcalls.js"
-import {twrCanvas} from "./twrcanvas.js";
+import {twrRangeFiles} from "./twrrange.js"
+import {twrSharedOutputRing} from "./twroutring.js";
+import {keyShift, keyCtrl, keyAlt, keyUp} from "./twrcircular.js";
 
 export type TAsyncModStartupMsg = {
 	urlToLoad: string,
@@ -19,6 +21,8 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 	callCReject?: (reason?: any) => void;
 	initLW=false;
 	waitingcalls?:twrWaitingCalls;
+	rangefiles?:twrRangeFiles;
+	debugOut?:twrSharedOutputRing;
 
 
 	constructor(opts?:IModOpts) {
@@ -48,15 +52,16 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 			}
 
 			this.waitingcalls=new twrWaitingCalls();  // handle's calls that cross the worker thread - main js thread boundary
-
-			let canvas:twrCanvas;
-			if (this.d2dcanvas.isValid()) canvas=this.d2dcanvas;
-			else canvas=this.iocanvas;
+			this.rangefiles=new twrRangeFiles(this);
+			this.debugOut=new twrSharedOutputRing();
 
 			const modAsyncProxyParams={
-				divProxyParams: this.iodiv.getProxyParams(), 
-				canvasProxyParams: canvas.getProxyParams(),
+				divsProxyParams: this.divs.map((d)=>d.getProxyParams()),
+				debugLogProxyParams: this.debugOut.sharedArray,
+				canvasesProxyParams: this.canvases.map((c)=>c.getProxyParams()),
+				defaultCanvas: this.defaultCanvas,
 				waitingCallsProxyParams: this.waitingcalls.getProxyParams(),
+				rangeFilesProxyParams: this.rangefiles.getProxyParams(),
 			};
 			const urlToLoad = new URL(pathToLoad, document.URL);
 			const startMsg:TAsyncModStartupMsg={ urlToLoad: urlToLoad.href, modAsyncProxyParams: modAsyncProxyParams, modParams: this.modParams};
@@ -79,7 +84,7 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 		});
 	}
 	
-	private keyEventProcess(ev:KeyboardEvent) {
+	private keyCode(ev:KeyboardEvent, up:boolean) {
 		if ( !ev.isComposing  && !ev.metaKey && ev.key!="Control" && ev.key!="Alt" ) {
 			//console.log("keyDownDiv: ",ev.key, ev.code, ev.key.codePointAt(0), ev);
 			if (ev.key.length==1)
@@ -95,28 +100,66 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 					case 'ArrowRight':return 0x2192;
 					case 'ArrowDown':	return 0x2193;
 				}
-				console.log("keyDownDiv SKIPPED: ",ev.key, ev.code, ev.key.codePointAt(0), ev);
+				if (!up) console.log("keyDownDiv SKIPPED: ",ev.key, ev.code, ev.key.codePointAt(0), ev);
 			}
 		}
-		else {
+		else if (!up) {
 			console.log("keyDownDiv SKIPPED-2: ",ev.key, ev.code, ev.key.codePointAt(0), ev);
 		}
 
 		return undefined;
 	}
 
-	// this function should be called from HTML "keydown" event from <div>
-	keyDownDiv(ev:KeyboardEvent) {
-		if (!this.iodiv || !this.iodiv.divKeys) throw new Error("unexpected undefined twrWasmAsyncModule.divKeys");
+	// a key event, as io_getkeys() returns it:  the code point, and the IO_KEY_* flags
+	private keyEventProcess(ev:KeyboardEvent, up=false) {
+		const c=this.keyCode(ev, up);
+		if (!c) return undefined;
+		return c | (ev.shiftKey?keyShift:0) | (ev.ctrlKey?keyCtrl:0) | (ev.altKey?keyAlt:0) | (up?keyUp:0);
+	}
+
+	// this function should be called from HTML "keydown" event from <div>.  div is the handle (see divs) of a div
+	// other than twr_iodiv
+	keyDownDiv(ev:KeyboardEvent, div=0) {
+		const d=this.getDiv(div);
+		if (!d.divKeys) throw new Error("unexpected undefined twrWasmAsyncModule.divKeys");
 		const r=this.keyEventProcess(ev);
-		if (r) this.iodiv.divKeys.write(r);
+		if (r && d.lineEditor?.active) d.lineEditor.key(r);
+		else if (r) d.divKeys.write(r);
 	}
 
-	// this function should be called from HTML "keydown" event from <canvas>
-	keyDownCanvas(ev:KeyboardEvent) {
-		if (!this.iocanvas || !this.iocanvas.canvasKeys) throw new Error("unexpected undefined twrWasmAsyncModule.canvasKeys");
+	// optional.  Call from an HTML "keyup" event from <div>, for programs that use io_getkeys() to see key releases
+	keyUpDiv(ev:KeyboardEvent, div=0) {
+		const d=this.getDiv(div);
+		if (!d.divKeys) throw new Error("unexpected undefined twrWasmAsyncModule.divKeys");
+		const r=this.keyEventProcess(ev, true);
+		if (r && !d.lineEditor?.active) d.divKeys.write(r);
+	}
+
+	// this function should be called from HTML "keydown" event from <canvas>.  canvas is the handle (see canvases) of
+	// a canvas other than twr_iocanvas
+	keyDownCanvas(ev:KeyboardEvent, canvas=0) {
+		const c=this.getCanvas(canvas);
+		if (!c.canvasKeys) throw new Error("unexpected undefined twrWasmAsyncModule.canvasKeys");
 		const r=this.keyEventProcess(ev);
-		if (r) this.iocanvas.canvasKeys.write(r);
+		if (r && c.lineEditor?.active) c.lineEditor.key(r);
+		else if (r) c.canvasKeys.write(r);
+	}
+
+	// optional.  Call from an HTML "keyup" event from <canvas>, for programs that use io_getkeys() to see key releases
+	keyUpCanvas(ev:KeyboardEvent, canvas=0) {
+		const c=this.getCanvas(canvas);
+		if (!c.canvasKeys) throw new Error("unexpected undefined twrWasmAsyncModule.canvasKeys");
+		const r=this.keyEventProcess(ev, true);
+		if (r && !c.lineEditor?.active) c.canvasKeys.write(r);
+	}
+
+	// div and debug output is read once an animation frame (see twrSharedOutputRing).  When a callC finishes, what
+	// it output is read first, so that it comes before output from the code that awaits callC
+	private flushOutput() {
+		for (const div of this.divs)
+			div.flushOutput();
+		const text=this.debugOut?.readText();
+		if (text) twrDebugLogString(text);
 	}
 
 	processMsg(event: MessageEvent) {
@@ -126,29 +169,48 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 		//console.log("twrWasmAsyncModule - got message: "+event.data)
 
 		switch (msgType) {
+			// div and debug output is in a twrSharedOutputRing.  These messages mean there is some to read
 			case "divout":
-				const [c, codePage]=d;
-				if (this.iodiv.isValid())
-					this.iodiv.charOut(c, codePage);
+			{
+				const div=this.getDiv(d);
+				if (div.isValid())
+					div.readOutput();
 				else
-					console.log('error - msg divout received but iodiv is undefined.')
+					console.log('error - msg divout received but div '+d+' is undefined.')
 				break;
+			}
 
 			case "debug":
-				twrDebugLogImpl(d);
+				if (!this.debugOut) throw new Error ("internal error: this.debugOut undefined.")
+				this.debugOut.scheduleRead(twrDebugLogString);
 				break;
 
+			// io_mbgets in line mode:  edit a line here, and send it when it is finished
+			case "divlinebegin":
+				this.getDiv(d).beginLine();
+				break;
+
+			case "canvaslinebegin":
+			{
+				const [canvas, cursor, foreColor, backColor] = d;
+				this.getCanvas(canvas).beginLine(cursor, foreColor, backColor);
+				break;
+			}
+
 			case "drawseq":
 			{
 				//console.log("twrModAsync got message drawseq");
 				const [ds] =  d;
-				if (this.iocanvas.isValid())
-					this.iocanvas.drawSeq(ds);
-				else if (this.d2dcanvas.isValid())
-					this.d2dcanvas.drawSeq(ds);
-				else
-					throw new Error('msg drawseq received but canvas is undefined.')
+				const canvas=this.getCanvas(this.getLong(ds+8));  /* ds->canvas */
+				if (!canvas.isValid()) throw new Error('msg drawseq received but canvas is undefined.')
+				canvas.drawSeq(ds);
+				break;
+			}
 
+			case "drawseqs":
+			{
+				const [list, n] =  d;
+				this.drawSeqs(list, n);
 				break;
 			}
 
@@ -177,6 +239,7 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 				break;
 
 			case "callCFail":
+				this.flushOutput();
 				if (this.callCReject)
 					this.callCReject(d);
 				else
@@ -184,6 +247,7 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 				break;
 
 			case "callCOkay":
+				this.flushOutput();
 				if (this.callCResolve)
 					this.callCResolve(d);
 				else
@@ -192,7 +256,8 @@ export class twrWasmModuleAsync extends twrWasmModuleInJSMain {
 
 			default:
 				if (!this.waitingcalls) throw new Error ("internal error: this.waitingcalls undefined.")
-				if (!this.waitingcalls.processMessage(msgType, d))
+				if (!this.rangefiles) throw new Error ("internal error: this.rangefiles undefined.")
+				if (!this.waitingcalls.processMessage(msgType, d) && !this.rangefiles.processMessage(msgType, d))
 					throw new Error("twrWasmAsyncModule - unknown and unexpected msgType: "+msgType);
 		}
 	}
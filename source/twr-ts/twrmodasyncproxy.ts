@@ -1,11 +1,12 @@
 // this script is the WebWorker thead used by class twrWasmAsyncModule
 
-import {twrCanvasProxy} from "./twrcanvas.js";
+import {twrCanvasProxy, D2D_DEFAULT_CANVAS} from "./twrcanvas.js";
 import {twrDivProxy} from "./twrdiv.js";
 import {twrDebugLogProxy} from "./twrdebug.js";
 import {TAsyncModStartupMsg} from "./twrmodasync.js"
 import {twrWasmModuleBase, IModProxyParams, IModParams} from "./twrmodbase.js"
 import {twrWaitingCallsProxy} from "./twrwaitingcalls.js";
+import {twrRangeFilesProxy} from "./twrrange.js";
 import {twrTimeEpochImpl} from "./twrdate.js"
 import {twrTimeTmLocalImpl, twrUserLconvImpl, twrUserLanguageImpl, twrRegExpTest1252Impl,twrToLower1252Impl, twrToUpper1252Impl} from "./twrlocale.js"
 import {twrStrcollImpl, twrUnicodeCodePointToCodePageImpl, twrCodePageToUnicodeCodePointImpl, twrGetDtnamesImpl} from "./twrlocale.js"
@@ -47,6 +48,9 @@ onmessage = function(e) {
 class twrWasmModuleAsyncProxy extends twrWasmModuleBase {
 	malloc:(size:number)=>Promise<number>;
     modParams: IModParams;
+    canvases: twrCanvasProxy[];    // by handle (see twrWasmModuleInJSMain.canvases)
+    divs: twrDivProxy[];
+    defaultCanvas: number;
 
 
     constructor(modParams:IModParams, modProxyParams:IModProxyParams) {
@@ -56,12 +60,16 @@ class twrWasmModuleAsyncProxy extends twrWasmModuleBase {
         this.modParams=modParams;
 
         //console.log("twrWasmModuleAsyncProxy: ", modProxyParams.canvasProxyParams)
-        const canvasProxy = new twrCanvasProxy(modProxyParams.canvasProxyParams, this);
-        const divProxy = new twrDivProxy(modProxyParams.divProxyParams);
+        this.canvases=modProxyParams.canvasesProxyParams.map((p, i)=>new twrCanvasProxy(p, this, i));
+        this.divs=modProxyParams.divsProxyParams.map((p, i)=>new twrDivProxy(p, this, i));
+        this.defaultCanvas=modProxyParams.defaultCanvas;
+        const debugLogProxy = new twrDebugLogProxy(modProxyParams.debugLogProxyParams, this);
         const waitingCallsProxy = new twrWaitingCallsProxy(modProxyParams.waitingCallsProxyParams);
+        const rangeFilesProxy = new twrRangeFilesProxy(modProxyParams.rangeFilesProxyParams, this);
 
         this.modParams.imports={
-            twrDebugLog:twrDebugLogProxy,
+            twrDebugLog:debugLogProxy.charOut.bind(debugLogProxy),
+            twrDebugLogStr:debugLogProxy.strOut.bind(debugLogProxy),
 				twrTimeEpoch:twrTimeEpochImpl,
 				twrTimeTmLocal:twrTimeTmLocalImpl.bind(this),
 				twrUserLconv:twrUserLconvImpl.bind(this),
@@ -75,14 +83,27 @@ class twrWasmModuleAsyncProxy extends twrWasmModuleBase {
 				twrGetDtnames:twrGetDtnamesImpl.bind(this),
 
             twrSleep:waitingCallsProxy.sleep.bind(waitingCallsProxy),
-
-            twrDivCharOut:divProxy.charOut.bind(divProxy), 
-            twrDivCharIn:divProxy.charIn.bind(divProxy),      
-
-            twrCanvasCharIn:canvasProxy.charIn.bind(canvasProxy),
-            twrCanvasInkey:canvasProxy.inkey.bind(canvasProxy),
-            twrCanvasGetProp:canvasProxy.getProp.bind(canvasProxy),
-            twrCanvasDrawSeq:canvasProxy.drawSeq.bind(canvasProxy),
+            twrRangeOpen:rangeFilesProxy.open.bind(rangeFilesProxy),
+            twrRangeSize:rangeFilesProxy.size.bind(rangeFilesProxy),
+            twrRangeRead:rangeFilesProxy.read.bind(rangeFilesProxy),
+            twrRangeClose:rangeFilesProxy.close.bind(rangeFilesProxy),
+
+            twrDivCharOut:(div:number, c:number, codePage:number)=>this.getDiv(div).charOut(c, codePage), 
+            twrDivStrOut:(div:number, str:number, len:number, codePage:number)=>this.getDiv(div).strOut(str, len, codePage),
+            twrDivCharIn:(div:number)=>this.getDiv(div).charIn(),      
+            twrDivKeysIn:(div:number, buf:number, n:number)=>this.getDiv(div).keysIn(buf, n),
+            twrDivLineBegin:(div:number)=>this.getDiv(div).lineBegin(),
+            twrDivGetHandle:(id:number)=>this.findHandle(this.divs, id),
+
+            twrCanvasCharIn:(canvas:number)=>this.getCanvas(canvas).charIn(),
+            twrCanvasInkey:(canvas:number)=>this.getCanvas(canvas).inkey(),
+            twrCanvasKeysIn:(canvas:number, buf:number, n:number)=>this.getCanvas(canvas).keysIn(buf, n),
+            twrCanvasLineBegin:(canvas:number, cursor:number, foreColor:number, backColor:number)=>this.getCanvas(canvas).lineBegin(cursor, foreColor, backColor),
+            twrLineModeAvailable:()=>1,
+            twrCanvasGetProp:(canvas:number, pn:number)=>this.getCanvas(canvas).getProp(pn),
+            twrCanvasDrawSeq:(ds:number)=>this.getCanvas(this.getLong(ds+8)).drawSeq(ds),  /* ds->canvas */
+            twrCanvasDrawSeqs:(list:number, n:number)=>this.getCanvas(this.getLong(this.getLong(list+(n-1)*4)+8)).drawSeqs(list, n),  /* the last ds->canvas */
+            twrCanvasGetHandle:(id:number)=>this.findHandle(this.canvases, id),
 
 				twrSin:Math.sin,
 				twrCos:Math.cos,
@@ -100,14 +121,30 @@ class twrWasmModuleAsyncProxy extends twrWasmModuleBase {
 				twrSqrt: Math.sqrt,
 				twrTrunc: Math.trunc,
 
-				twrDtoa: this.floatUtil.dtoa.bind(this.floatUtil),
-				twrToFixed: this.floatUtil.toFixed.bind(this.floatUtil),
-				twrToExponential: this.floatUtil.toExponential.bind(this.floatUtil),
-				twrAtod: this.floatUtil.atod.bind(this.floatUtil),
-				twrFcvtS: this.floatUtil.fcvtS.bind(this.floatUtil)
+				twrDtoa: this.floatUtil.dtoa.bind(this.floatUtil)
             
         }
    }
+
+    // see twrWasmModuleInJSMain.getCanvas
+    getCanvas(handle:number) {
+        handle|=0;
+        const canvas=this.canvases[handle==D2D_DEFAULT_CANVAS ? this.defaultCanvas : handle];
+        if (!canvas) throw new Error("invalid canvas handle: "+handle);
+        return canvas;
+    }
+
+    getDiv(handle:number) {
+        const div=this.divs[handle];
+        if (!div) throw new Error("invalid div handle: "+handle);
+        return div;
+    }
+
+    // the handle of the canvas or div with element id id (a string in module memory), or -1.  (An element that doesn't exist has an id of "")
+    private findHandle(list:(twrCanvasProxy|twrDivProxy)[], id:number) {
+        const s=this.getString(id);
+        return s ? list.findIndex((e)=>e.id==s) : -1;
+    }
 }
 
 
@@ -1,7 +1,9 @@
 
 import {TCanvasProxyParams} from "./twrcanvas.js"
 import {TDivProxyParams} from "./twrdiv.js";
+import {TDebugLogProxyParams} from "./twrdebug.js";
 import {TWaitingCallsProxyParams} from "./twrwaitingcalls.js"
+import {TRangeFilesProxyParams} from "./twrrange.js"
 import {twrDebugLogImpl} from "./twrdebug.js";
 import {twrFloatUtil} from "./twrfloat.js";
 import {codePageUTF8, codePage1252, codePageASCII, to1252, toASCII} from "./twrlocale.js"
@@ -9,6 +11,9 @@ import {codePageUTF8, codePage1252, codePageASCII, to1252, toASCII} from "./twrl
 
 export type TStdioVals="div"|"canvas"|"null"|"debug";
 
+// number of 32 bit words in a struct twr_bigint.  keep in sync with BIGINT_SIZEW in twr-bigint.h
+export const twrBigIntSizeW=256;
+
 export interface IModOpts {
 	stdio?:TStdioVals, 
 	windim?:[number, number],
@@ -16,6 +21,11 @@ export interface IModOpts {
 	backcolor?:string,
 	fontsize?:number,
 	isd2dcanvas?:boolean,
+	glyphatlas?:boolean,
+	scrollback?:number,
+	keybuffer?:number,
+	canvases?:string[],
+	divs?:string[],
 	imports?:{},
 }
 
@@ -27,13 +37,29 @@ export interface IModParams {
 	fontsize:number,
 	styleIsDefault: boolean
 	isd2dcanvas:boolean,
+	glyphatlas?:boolean,		// undefined: on for console canvases, off for twr_d2dcanvas
+	scrollback:number,
+	keybuffer:number,
 	imports:{[index:string]:Function},
 }
 
+export interface IFetchStreamOpts {
+	chunkSize?:number,		// starting size of the buffer in module memory that the C function is passed.  default 64K
+	decompress?:"gzip"|"deflate"|"deflate-raw",	// decode the body with DecompressionStream
+	userData?:number,		// passed to the C function as its last parameter
+}
+
+export interface IAddFileOpts {
+	inflate?:boolean,		// the data is zlib or gzip compressed.  It is decompressed in C, and the file is the result
+}
+
 export interface IModProxyParams {
-	divProxyParams:TDivProxyParams,
-	canvasProxyParams:TCanvasProxyParams,
+	divsProxyParams:TDivProxyParams[],		// by handle (see twrWasmModuleInJSMain.divs)
+	debugLogProxyParams:TDebugLogProxyParams,
+	canvasesProxyParams:TCanvasProxyParams[],	// by handle (see twrWasmModuleInJSMain.canvases)
+	defaultCanvas:number,						// the canvas for D2D_DEFAULT_CANVAS
 	waitingCallsProxyParams:TWaitingCallsProxyParams,
+	rangeFilesProxyParams:TRangeFilesProxyParams,
 }
 
 /*********************************************************************/
@@ -175,6 +201,10 @@ export abstract class twrWasmModuleBase {
 		const f = this.exports[fname] as CallableFunction;
 		let cr=f(...cparams);
 
+		// stdout is line buffered, so send any partial line now that C has returned
+		const flush=this.exports.twr_wasm_flush as CallableFunction|undefined;
+		if (flush) flush();
+
 		return cr;
 	}
 
@@ -333,11 +363,7 @@ export abstract class twrWasmModuleBase {
 			throw new Error("fetchAndPutURL param must be URL");
 
 		try {
-			let response=await fetch(fnin);
-			let buffer = await response.arrayBuffer();
-			let src = new Uint8Array(buffer);
-			let dest=await this.putU8(src);
-			return [dest, src.length];
+			return await this.fetchIntoMemory(fnin, this.malloc);
 			
 		} catch(err:any) {
 			console.log('fetchAndPutURL Error. URL: '+fnin+'\n' + err + (err.stack ? "\n" + err.stack : ''));
@@ -345,6 +371,145 @@ export abstract class twrWasmModuleBase {
 		}
 	}
 
+	// fetch a URL into module memory from alloc.  When the response has a Content-Length (and isn't compressed), the
+	// memory is allocated first, and the body is copied into it as it arrives, so the whole file is never also held
+	// in an ArrayBuffer.  Returns [index, length]
+	async fetchIntoMemory(url:URL, alloc:(size:number)=>Promise<number>):Promise<[number, number]> {
+		const response=await fetch(url);
+		if (!response.ok) throw new Error("fetch response error on '"+url+"'\n"+response.statusText);
+
+		const contentLength=response.headers.get("Content-Length");
+		const len=contentLength===null ? NaN : parseInt(contentLength);
+
+		if (response.body && !response.headers.get("Content-Encoding") && len>0) {
+			const dest:number=await alloc(len);
+			if (!dest) throw new Error("fetchIntoMemory: out of memory loading '"+url+"' ("+len+" bytes)");
+			const reader=response.body.getReader();
+			let pos=0;
+			try {
+				for (;;) {
+					const {done, value}=await reader.read();
+					if (done) break;
+					if (pos+value.length>len) throw new Error("fetchIntoMemory: '"+url+"' is longer than its Content-Length");
+					this.mem8.set(value, dest+pos);
+					pos+=value.length;
+				}
+				if (pos!=len) throw new Error("fetchIntoMemory: '"+url+"' is shorter than its Content-Length");
+			} catch(err:any) {
+				await this.callCImpl("free", [dest]);
+				throw err;
+			}
+			return [dest, len];
+		}
+
+		const u8=new Uint8Array(await response.arrayBuffer());
+		const dest:number=await alloc(u8.length);
+		if (!dest && u8.length) throw new Error("fetchIntoMemory: out of memory loading '"+url+"' ("+u8.length+" bytes)");
+		this.mem8.set(u8, dest);
+		return [dest, u8.length];
+	}
+
+	// fetch a URL, and pass its body to the exported C function cFuncName while it downloads:
+	//
+	//    int on_chunk(const char* data, int len, int final, void* user_data);
+	//
+	// data is a buffer in module memory.  The C function returns how many bytes it used, from the start of data, or -1
+	// to stop the download.  Bytes that weren't used (for example a line that isn't complete yet) are passed again,
+	// at the start of data, with the next chunk.  If none are used and the buffer is full, it is doubled.  The last call
+	// has final set, and is passed whatever is left.
+	//
+	// The next part of the body isn't read until the C function returns, so a consumer that is slower than the network
+	// slows the download instead of queueing the body in memory.  Returns the number of bytes passed to C.
+	async fetchStream(url:URL|string, cFuncName:string, opts:IFetchStreamOpts={}) {
+		const response=await fetch(url);
+		if (!response.ok) throw new Error("fetch response error on '"+url+"'\n"+response.statusText);
+		if (!response.body) throw new Error("fetchStream: '"+url+"' has no body");
+
+		let stream:ReadableStream<Uint8Array>=response.body;
+		if (opts.decompress) stream=stream.pipeThrough(new DecompressionStream(opts.decompress));
+
+		let size=opts.chunkSize ?? 65536;
+		let buf:number=await this.malloc(size);
+		if (!buf) throw new Error("fetchStream: out of memory ("+size+" bytes)");
+
+		const userData=opts.userData ?? 0;
+		let len=0;		// bytes in buf
+		let total=0;
+
+		// returns false if C stopped the download
+		const deliver=async (final:boolean)=>{
+			const used=await this.callCImpl(cFuncName, [buf, len, final?1:0, userData]) as number;
+			if (used<0) return false;
+			if (used>len) throw new Error("fetchStream: "+cFuncName+" returned "+used+", but was passed "+len+" bytes");
+
+			if (used>0) this.mem8.copyWithin(buf, buf+used, buf+len);
+			len-=used;
+
+			if (len==size) {
+				const bigger:number=await this.malloc(size*2);
+				if (!bigger) throw new Error("fetchStream: out of memory ("+size*2+" bytes)");
+				this.mem8.copyWithin(bigger, buf, buf+len);
+				await this.callCImpl("free", [buf]);
+				buf=bigger;
+				size*=2;
+			}
+			return true;
+		};
+
+		const reader=stream.getReader();
+		try {
+			for (;;) {
+				const {done, value}=await reader.read();
+				if (done) break;
+
+				let pos=0;
+				while (pos<value.length) {
+					const n=Math.min(size-len, value.length-pos);
+					this.mem8.set(value.subarray(pos, pos+n), buf+len);
+					len+=n;
+					pos+=n;
+					total+=n;
+					if (len==size && !await deliver(false)) {
+						await reader.cancel();
+						return total;
+					}
+				}
+			}
+			await deliver(true);
+		}
+		finally {
+			await this.callCImpl("free", [buf]);
+		}
+
+		return total;
+	}
+
+	// add a file to the in-memory file system that C fopen() and twr_map_asset() use.  The contents are loaded into
+	// module memory once (16 byte aligned), and C reads them there.  Replaces a file with the same path.
+	async addFile(path:string, data:ArrayBuffer|Uint8Array|URL, opts:IAddFileOpts={}) {
+		const allocAsset=(size:number)=>this.callCImpl("twr_wasm_alloc_asset", [size]) as Promise<number>;
+		let idx:number, len:number;
+
+		if (data instanceof URL) {
+			[idx, len]=await this.fetchIntoMemory(data, allocAsset);
+		}
+		else {
+			const u8=data instanceof Uint8Array ? data : new Uint8Array(data);
+			idx=await allocAsset(u8.length);
+			if (!idx) throw new Error("addFile: out of memory adding '"+path+"' ("+u8.length+" bytes)");
+			this.mem8.set(u8, idx);
+			len=u8.length;
+		}
+
+		const pathIdx=await this.putString(path);
+		const rv=await this.callCImpl(opts.inflate ? "twr_wasm_memfs_add_inflate" : "twr_wasm_memfs_add", [pathIdx, idx, len]);
+		await this.callCImpl("free", [pathIdx]);
+		if (rv!=0) {
+			await this.callCImpl("free", [idx]);
+			throw new Error("addFile: '"+path+"' could not be added (it may be open"+(opts.inflate ? ", or not valid compressed data)" : ")"));
+		}
+	}
+
 	getLong(idx:number): number {
 		const idx32=Math.floor(idx/4);
 		if (idx32*4!=idx) throw new Error("getLong passed non long aligned address")
@@ -384,6 +549,14 @@ export abstract class twrWasmModuleBase {
 	// get a string out of module memory
 	// null terminated, up until max of (optional) len bytes
 	// len may be longer than the number of characters, if characters are utf-8 encoded
+	// TextDecoder construction is not free, so create one per encoding and reuse it
+	private static decoders:{[encoding:string]:TextDecoder}={};
+	private static getDecoder(encoding:string) {
+		let td=twrWasmModuleBase.decoders[encoding];
+		if (!td) td=twrWasmModuleBase.decoders[encoding]=new TextDecoder(encoding);
+		return td;
+	}
+
 	getString(strIndex:number, len?:number, codePage=codePageUTF8): string {
 		if (strIndex<0 || strIndex >= this.mem8.length) throw new Error("invalid strIndex passed to getString: "+strIndex);
 
@@ -401,7 +574,7 @@ export abstract class twrWasmModuleBase {
 		else if (codePage==codePage1252) encodeFormat='windows-1252';
 		else throw new Error("Unsupported codePage: "+codePage);
 
-		const td=new TextDecoder(encodeFormat);
+		const td=twrWasmModuleBase.getDecoder(encodeFormat);
 		const u8todecode=new Uint8Array(this.mem8.buffer, strIndex, len);
 
  // chrome throws exception when using TextDecoder on SharedArrayBuffer
@@ -450,4 +623,44 @@ export abstract class twrWasmModuleBase {
 		const u32 = new Uint32Array( (this.mem8.slice(dataptr, dataptr+size)).buffer );
 		return u32;
 	}
+
+	// get a struct twr_bigint (see twr-bigint.h) out of module memory as a JavaScript bigint
+	getBigInt(idx:number): bigint {
+		const len=this.getLong(idx);
+		if (len<0 || len>twrBigIntSizeW) throw new Error("invalid twr_bigint passed to getBigInt: "+idx);
+		if (len==0) return 0n;
+
+		// one conversion via a hex string, rather than len bigint shifts
+		const words=this.mem32.subarray(idx/4+1, idx/4+1+len);
+		let hex="0x";
+		for (let i=len-1; i>=0; i--)
+			hex+=words[i].toString(16).padStart(8, "0");
+		return BigInt(hex);
+	}
+
+	// set a struct twr_bigint in module memory to a JavaScript bigint
+	setBigInt(idx:number, value:bigint) {
+		if (value<0n) throw new Error("setBigInt value must not be negative");
+		const idx32=Math.floor(idx/4);
+		if (idx32*4!=idx) throw new Error("setBigInt passed non long aligned address");
+		if (idx32<0 || idx32+1+twrBigIntSizeW > this.mem32.length) throw new Error("invalid index passed to setBigInt: "+idx);
+
+		let hex=value.toString(16);
+		if (hex=="0") hex="";
+		const len=Math.ceil(hex.length/8);
+		if (len>twrBigIntSizeW) throw new Error("setBigInt value is too big for a twr_bigint");
+
+		hex=hex.padStart(len*8, "0");
+		this.mem32[idx32]=len;
+		this.mem32[idx32+1]=0;
+		for (let i=0; i<len; i++)
+			this.mem32[idx32+1+i]=parseInt(hex.substring((len-1-i)*8, (len-i)*8), 16);
+	}
+
+	// allocate a struct twr_bigint in module memory and set it to value
+	async putBigInt(value:bigint) {
+		const idx:number=await this.malloc(4+4*twrBigIntSizeW);
+		this.setBigInt(idx, value);
+		return idx;
+	}
 }
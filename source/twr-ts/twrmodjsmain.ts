@@ -2,14 +2,19 @@
 
 import {twrDiv} from "./twrdiv.js"
 import {IModParams, IModOpts, twrWasmModuleBase} from "./twrmodbase.js"
-import {twrCanvas} from "./twrcanvas.js"
+import {twrCanvas, D2D_DEFAULT_CANVAS} from "./twrcanvas.js"
 import {codePageUTF32} from "./twrlocale.js"
 
 
+// C code addresses a canvas or div by its index (handle) in canvases or divs.  twr_iocanvas is canvas 0 and
+// twr_d2dcanvas is canvas 1 (either may be missing, in which case its twrCanvas is not valid), followed by
+// opts.canvases.  twr_iodiv is div 0, followed by opts.divs
 export abstract class twrWasmModuleInJSMain extends twrWasmModuleBase {
 	iocanvas:twrCanvas;
 	d2dcanvas:twrCanvas;
 	iodiv:twrDiv;
+	canvases:twrCanvas[];
+	divs:twrDiv[];
 	modParams:IModParams;
 
    constructor(opts:IModOpts={}, isWasmModule=false) {
@@ -21,7 +26,6 @@ export abstract class twrWasmModuleInJSMain extends twrWasmModuleBase {
 		const eiocanvas=document.getElementById("twr_iocanvas") as HTMLCanvasElement;
 		const ed2dcanvas=document.getElementById("twr_d2dcanvas") as HTMLCanvasElement;
 
-		if (eiocanvas && ed2dcanvas) throw new Error ("Both twr_iocanvas and twr_d2dcanvas defined. Currently only one canvas allowed.");
 		if (opts.stdio=='div' && !eiodiv) throw new Error("twrWasmModuleBase opts=='div' but twr_iodiv not defined");
 		if (opts.stdio=='canvas' && !eiocanvas) throw new Error("twrWasmModuleBase, opts=='canvas' but twr_iocanvas not defined");
 		if (opts.isd2dcanvas && !ed2dcanvas) throw new Error("twrWasmModuleBase, opts.isd2dcanvas==true but twr_d2dcanvas not defined");
@@ -51,6 +55,9 @@ export abstract class twrWasmModuleInJSMain extends twrWasmModuleBase {
 				opts.isd2dcanvas=false;
 		}
 
+		if (!opts.scrollback) opts.scrollback=10000;
+		if (!opts.keybuffer) opts.keybuffer=1024;
+
 		this.modParams={
 			stdio:opts.stdio!, 
 			windim:opts.windim!, 
@@ -59,16 +66,73 @@ export abstract class twrWasmModuleInJSMain extends twrWasmModuleBase {
 			backcolor:opts.backcolor, 
 			styleIsDefault: styleIsDefault,
 			fontsize:opts.fontsize,
-			isd2dcanvas:opts.isd2dcanvas
+			isd2dcanvas:opts.isd2dcanvas,
+			glyphatlas:opts.glyphatlas,
+			scrollback:opts.scrollback,
+			keybuffer:opts.keybuffer
 		};
 
+		// text on a terminal canvas is drawn from a glyph atlas, unless turned off
 		this.iodiv=new twrDiv(eiodiv, this.modParams, this);
-		this.iocanvas=new twrCanvas(eiocanvas, this.modParams, this);
-		this.d2dcanvas=new twrCanvas(ed2dcanvas, this.modParams, this);
+		this.iocanvas=new twrCanvas(eiocanvas, this.modParams, this, true, opts.glyphatlas ?? true);
+		this.d2dcanvas=new twrCanvas(ed2dcanvas, this.modParams, this, false, opts.glyphatlas ?? false);
+
+		this.divs=[this.iodiv];
+		for (const id of opts.divs ?? []) {
+			const e=document.getElementById(id) as HTMLDivElement;
+			if (!e) throw new Error("twrWasmModuleBase, opts.divs element '"+id+"' not defined");
+			this.divs.push(new twrDiv(e, this.modParams, this));
+		}
+
+		// other canvases keep their size, and can be used by twr_new_windowcon() or the d2d_ functions
+		this.canvases=[this.iocanvas, this.d2dcanvas];
+		for (const id of opts.canvases ?? []) {
+			const e=document.getElementById(id) as HTMLCanvasElement;
+			if (!e) throw new Error("twrWasmModuleBase, opts.canvases element '"+id+"' not defined");
+			this.canvases.push(new twrCanvas(e, this.modParams, this, false, opts.glyphatlas ?? true));
+		}
+	}
+
+	// D2D_DEFAULT_CANVAS is twr_d2dcanvas if there is one, otherwise twr_iocanvas
+	get defaultCanvas() {
+		return this.d2dcanvas.isValid() ? 1 : 0;
+	}
+
+	// any other handle that isn't in canvases (such as -1, from a d2d_get_canvas that failed) is an error
+	getCanvas(handle:number) {
+		handle|=0;   // (ds->canvas is read with getLong, which is unsigned)
+		const canvas=this.canvases[handle==D2D_DEFAULT_CANVAS ? this.defaultCanvas : handle];
+		if (!canvas) throw new Error("invalid canvas handle: "+handle);
+		return canvas;
+	}
+
+	getDiv(handle:number) {
+		const div=this.divs[handle];
+		if (!div) throw new Error("invalid div handle: "+handle);
+		return div;
+	}
+
+	// the handle of the canvas or div with element id id (a string in module memory), or -1
+	getCanvasHandle(id:number) {
+		const s=this.getString(id);
+		return this.canvases.findIndex((c)=>c.isValid() && c.id==s);
+	}
+
+	getDivHandle(id:number) {
+		const s=this.getString(id);
+		return this.divs.findIndex((d)=>d.isValid() && d.id==s);
+	}
 
+	// twrCanvasDrawSeqs:  n draw sequences, for any canvases, drawn in order.  Only the last one signals that it is done
+	drawSeqs(list:number, n:number) {
+		for (let i=0; i<n; i++) {
+			const ds=this.getLong(list+i*4);
+			this.getCanvas(this.getLong(ds+8)).drawSeq(ds, i==n-1);  /* ds->canvas */
+		}
 	}
 
 	divLog(...params: string[]) {
+		this.iodiv.flushOutput();   // (twrWasmModuleAsync output that C wrote first)
 		for (var i = 0; i < params.length; i++) {
 			this.iodiv.stringOut(params[i].toString());
 			this.iodiv.charOut(32, codePageUTF32); // space
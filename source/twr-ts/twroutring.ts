@@ -0,0 +1,137 @@
+//
+// A SharedArrayBuffer ring of bytes (UTF-8 text) that a WebWorker thread writes and the main JS thread reads.
+// twrWasmModuleAsync uses it for div and debug output, instead of a postMessage for each character.
+// The reader reads at most once per animation frame.  When the ring is full the writer waits (Atomics.wait) for it,
+// so output goes as fast as it can be shown.  The writer only posts a message when the reader is idle (has read
+// everything, and asked to be woken), so there is about one message per frame of output, not one per character.
+//
+
+const RD=0;     // bytes read, mod 2^32
+const WR=1;     // bytes written, mod 2^32
+const WAKE=2;   // 1 if the reader is idle, and needs a message when there is more
+
+export type TOutputRingProxyParams = SharedArrayBuffer;
+
+export class twrSharedOutputRing {
+    sharedArray:SharedArrayBuffer;
+    hdr:Int32Array;
+    buf:Uint8Array;
+    size:number;    // a power of 2
+    wake?:()=>void; // writer: tell the reader there is more (postMessage)
+    encoder=new TextEncoder();
+    utf8=new Uint8Array(4);
+    decoder=new TextDecoder('utf-8');
+    readPending=false;
+
+    constructor (sa?:SharedArrayBuffer, size=65536) {
+        if (typeof window !== 'undefined') {  // this check only works if window defined (not a worker thread)
+            if (!crossOriginIsolated && !(window.location.protocol === 'file:')) throw new Error("twrSharedOutputRing constructor, crossOriginIsolated="+crossOriginIsolated+". See SharedArrayBuffer docs.");
+        }
+        if (sa) {
+            this.sharedArray=sa;
+            this.size=sa.byteLength-12;
+        }
+        else {
+            this.sharedArray=new SharedArrayBuffer(12+size);
+            this.size=size;
+        }
+        this.hdr=new Int32Array(this.sharedArray, 0, 3);
+        this.buf=new Uint8Array(this.sharedArray, 12, this.size);
+        if (!sa) {
+            this.hdr[RD]=0;
+            this.hdr[WR]=0;
+            this.hdr[WAKE]=1;
+        }
+    }
+
+    /* writer */
+
+    write(bytes:Uint8Array) {
+        let i=0;
+        while (i<bytes.length) {
+            const rd=Atomics.load(this.hdr, RD);
+            const wr=this.hdr[WR];
+            const free=this.size-((wr-rd)|0);
+            if (free==0) {
+                this.wakeReader();
+                Atomics.wait(this.hdr, RD, rd);
+                continue;
+            }
+            const at=wr&(this.size-1);
+            const n=Math.min(free, bytes.length-i, this.size-at);  // (to the end of buf, then around)
+            this.buf.set(bytes.subarray(i, i+n), at);
+            Atomics.store(this.hdr, WR, (wr+n)|0);
+            i+=n;
+        }
+        this.wakeReader();
+    }
+
+    writeByte(b:number) {
+        this.utf8[0]=b;
+        this.write(this.utf8.subarray(0, 1));
+    }
+
+    writeCodePoint(cp:number) {
+        if (cp<0x80)
+            this.writeByte(cp);
+        else
+            this.write(this.utf8.subarray(0, this.encoder.encodeInto(String.fromCodePoint(cp), this.utf8).written));
+    }
+
+    writeString(str:string) {
+        this.write(this.encoder.encode(str));
+    }
+
+    private wakeReader() {
+        if (Atomics.exchange(this.hdr, WAKE, 0)==1 && this.wake)
+            this.wake();
+    }
+
+    /* reader */
+
+    // everything written so far (copied out of the SharedArrayBuffer), or undefined
+    read() {
+        const wr=Atomics.load(this.hdr, WR);
+        const rd=this.hdr[RD];
+        const n=(wr-rd)|0;
+        if (n==0) return undefined;
+
+        const out=new Uint8Array(n);
+        const at=rd&(this.size-1);
+        const first=Math.min(n, this.size-at);
+        out.set(this.buf.subarray(at, at+first));
+        if (first<n) out.set(this.buf.subarray(0, n-first), first);
+
+        Atomics.store(this.hdr, RD, (rd+n)|0);
+        Atomics.notify(this.hdr, RD);  // a writer waiting for room
+        return out;
+    }
+
+    // everything written so far, as text.  (A UTF-8 character split by the writer is completed by a later read)
+    readText() {
+        const bytes=this.read();
+        return bytes ? this.decoder.decode(bytes, {stream: true}) : "";
+    }
+
+    // call when the wake message arrives.  In the next animation frame, what has been written is passed to
+    // onText, until the writer stops
+    scheduleRead(onText:(text:string)=>void) {
+        if (this.readPending) return;
+        this.readPending=true;
+
+        const readNow=()=>{
+            this.readPending=false;
+            const text=this.readText();
+            if (text) onText(text);
+
+            // ask to be woken.  But if more was written meanwhile, and the writer hasn't seen WAKE yet, keep reading
+            Atomics.store(this.hdr, WAKE, 1);
+            if (Atomics.load(this.hdr, WR)!=this.hdr[RD] && Atomics.exchange(this.hdr, WAKE, 0)==1)
+                this.scheduleRead(onText);
+        };
+
+        // animation frames don't run in a hidden tab, and a waiting writer would wait until the tab is shown
+        if (document.hidden) setTimeout(readNow, 50);
+        else requestAnimationFrame(readNow);
+    }
+}
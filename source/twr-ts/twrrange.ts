@@ -0,0 +1,222 @@
+import {twrSignal} from "./twrsignal.js";
+import {twrWasmModuleBase} from "./twrmodbase.js";
+
+// Random access to large remote files with HTTP Range requests, for C twr_pread() (rangefile.c)
+//
+// A file is fetched a page at a time, and the main JS thread keeps up to maxPages of them in an LRU cache, so only
+// the parts that are read are downloaded, and memory use is bounded however large the file is.  The worker posts
+// a request and blocks on a twrSignal until the pages it needs are copied into module memory.  When a read starts
+// where the last one ended, the next prefetch pages are requested without waiting for them.
+
+export type TRangeFilesProxyParams = [SharedArrayBuffer, SharedArrayBuffer];   // twrSignal, results
+
+class twrRangeFile {
+	url:string;
+	size=0;
+	pageSize:number;
+	maxPages:number;
+	prefetch:number;
+	pages=new Map<number, Promise<Uint8Array>>();	// a Map iterates in insertion order, so the first page is the least recently used
+	nextPage=-1;	// the page that a sequential read would start in
+
+	constructor(url:string, pageSize:number, maxPages:number, prefetch:number) {
+		this.url=url;
+		this.pageSize=pageSize;
+		this.maxPages=maxPages;
+		this.prefetch=prefetch;
+	}
+
+	// the size comes from the Content-Range of a request for the first page, which is kept
+	async open() {
+		const response=await fetch(this.url, {headers: {Range: "bytes=0-"+(this.pageSize-1)}});
+		const contentRange=response.headers.get("Content-Range");
+
+		if (response.status==416 && contentRange=="bytes */0") return;		// empty file
+
+		if (response.status!=206 || !contentRange) {
+			await response.body?.cancel();
+			throw new Error("'"+this.url+"' "+(response.ok ? "server doesn't support Range requests" : response.statusText));
+		}
+
+		const m=contentRange.match(/^bytes \d+-\d+\/(\d+)$/);
+		if (!m) throw new Error("'"+this.url+"' unexpected Content-Range: "+contentRange);
+		this.size=parseInt(m[1]);
+
+		this.pages.set(0, Promise.resolve(await this.pageData(0, response)));
+	}
+
+	async read(offset:number, len:number, copy:(data:Uint8Array, pos:number)=>void) {
+		if (offset>=this.size) return 0;
+		len=Math.min(len, this.size-offset);
+
+		const first=Math.floor(offset/this.pageSize);
+		const last=Math.floor((offset+len-1)/this.pageSize);
+
+		const pages:Promise<Uint8Array>[]=[];
+		for (let n=first; n<=last; n++)
+			pages.push(this.getPage(n));
+
+		if (first==this.nextPage) {
+			const lastInFile=Math.ceil(this.size/this.pageSize)-1;
+			for (let n=last+1; n<=Math.min(last+this.prefetch, lastInFile); n++)
+				if (!this.pages.has(n)) this.getPage(n).catch(()=>{});
+		}
+		this.nextPage=Math.floor((offset+len)/this.pageSize);
+
+		let pos=0;
+		for (let i=0; i<pages.length; i++) {
+			const data=await pages[i];
+			const start=i==0 ? offset-first*this.pageSize : 0;
+			const n=Math.min(data.length-start, len-pos);
+			copy(data.subarray(start, start+n), pos);
+			pos+=n;
+		}
+
+		return len;
+	}
+
+	// a page from the cache, or a new request for it.  Either way it becomes the most recently used
+	private getPage(n:number) {
+		let page=this.pages.get(n);
+		if (page) {
+			this.pages.delete(n);
+		}
+		else {
+			const p=this.fetchPage(n);
+			p.catch(()=>{if (this.pages.get(n)===p) this.pages.delete(n)});	// so the next read tries again
+			page=p;
+		}
+
+		this.pages.set(n, page);
+		while (this.pages.size>this.maxPages)
+			this.pages.delete(this.pages.keys().next().value as number);
+
+		return page;
+	}
+
+	private async fetchPage(n:number) {
+		const start=n*this.pageSize;
+		const end=Math.min(start+this.pageSize, this.size)-1;
+		const response=await fetch(this.url, {headers: {Range: "bytes="+start+"-"+end}});
+		if (response.status!=206) {
+			await response.body?.cancel();
+			throw new Error("'"+this.url+"' bytes "+start+"-"+end+": "+response.status+" "+response.statusText);
+		}
+		return this.pageData(n, response);
+	}
+
+	private async pageData(n:number, response:Response) {
+		const data=new Uint8Array(await response.arrayBuffer());
+		const expected=Math.min(this.pageSize, this.size-n*this.pageSize);
+		if (data.length!=expected) throw new Error("'"+this.url+"' page "+n+" is "+data.length+" bytes, expected "+expected);
+		return data;
+	}
+}
+
+// This class is used in the Main JS thread
+export class twrRangeFiles {
+	mod:twrWasmModuleBase;
+	callCompleteSignal:twrSignal;
+	results:Float64Array;		// [return value, size]
+	files=new Map<number, twrRangeFile>();
+	nextHandle=0;
+
+	constructor(mod:twrWasmModuleBase) {
+		this.mod=mod;
+		this.callCompleteSignal=new twrSignal();
+		this.results=new Float64Array(new SharedArrayBuffer(16));
+	}
+
+	getProxyParams():TRangeFilesProxyParams {
+		return [this.callCompleteSignal.sharedArray, this.results.buffer as SharedArrayBuffer];
+	}
+
+	processMessage(msgType:string, data:any[]):boolean {
+		switch (msgType) {
+			case "rangeopen": {
+				const [url, pageSize, maxPages, prefetch]=data;
+				this.complete(this.open(url, pageSize, maxPages, prefetch));
+				break;
+			}
+
+			case "rangeread": {
+				const [handle, offset, buf, len]=data;
+				const file=this.files.get(handle);
+				if (file) this.complete(file.read(offset, len, (u8, pos)=>this.mod.mem8.set(u8, buf+pos)));
+				else this.complete(Promise.reject(new Error("read of invalid handle "+handle)));
+				break;
+			}
+
+			case "rangeclose": {
+				const [handle]=data;
+				this.files.delete(handle);
+				break;
+			}
+
+			default:
+				return false;
+		}
+
+		return true;
+	}
+
+	private async open(url:string, pageSize:number, maxPages:number, prefetch:number) {
+		const file=new twrRangeFile(new URL(url, document.URL).href, pageSize, maxPages, prefetch);
+		await file.open();
+		const handle=this.nextHandle++;
+		this.files.set(handle, file);
+		this.results[1]=file.size;
+		return handle;
+	}
+
+	private complete(result:Promise<number>) {
+		result.catch((err)=>{
+			console.log("twrRangeFiles: "+err);
+			return -1;
+		}).then((rv)=>{
+			this.results[0]=rv;
+			this.callCompleteSignal.signal();
+		});
+	}
+}
+
+// This class is used in the worker thread
+export class twrRangeFilesProxy {
+	callCompleteSignal:twrSignal;
+	results:Float64Array;
+	owner:twrWasmModuleBase;
+	sizes=new Map<number, number>();
+
+	constructor(params:TRangeFilesProxyParams, owner:twrWasmModuleBase) {
+		this.callCompleteSignal=new twrSignal(params[0]);
+		this.results=new Float64Array(params[1]);
+		this.owner=owner;
+	}
+
+	private call(msgType:string, data:any[]) {
+		this.callCompleteSignal.reset();
+		postMessage([msgType, data]);
+		this.callCompleteSignal.wait();
+		return this.results[0];
+	}
+
+	open(url:number, pageSize:number, maxPages:number, prefetch:number) {
+		const handle=this.call("rangeopen", [this.owner.getString(url), pageSize, maxPages, prefetch]);
+		if (handle>=0) this.sizes.set(handle, this.results[1]);
+		return handle;
+	}
+
+	size(handle:number) {
+		return this.sizes.get(handle) ?? -1;
+	}
+
+	read(handle:number, offset:number, buf:number, len:number) {
+		if (!this.sizes.has(handle)) return -1;
+		return this.call("rangeread", [handle, offset, buf, len]);
+	}
+
+	close(handle:number) {
+		if (this.sizes.delete(handle))
+			postMessage(["rangeclose", [handle]]);
+	}
+}